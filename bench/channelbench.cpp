@@ -0,0 +1,87 @@
+//
+// Creation Date: Fri Oct 16 09:12:40 PDT 2026
+// Last Modified: Fri Oct 16 09:12:40 PDT 2026
+// Filename:      channelbench.cpp
+// Web Address:
+// Syntax:        C++
+// vim:           ts=3:nowrap:ft=text
+//
+// Description:   Microbenchmark for the RGB channel extraction kernel.
+//                Reports the throughput of extractGreenChannel() in
+//                GB/s of RGB input for each SIMD level supported by
+//                the CPU, and checks each level against the scalar one.
+//
+// Usage:         channelbench [megapixels] [repetitions]
+//
+
+#include "Utilities.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace rip;
+
+///////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+	double megapixels = 16.0;
+	int repetitions   = 20;
+	if (argc > 1) {
+		megapixels = atof(argv[1]);
+	}
+	if (argc > 2) {
+		repetitions = atoi(argv[2]);
+	}
+	if ((megapixels <= 0.0) || (repetitions <= 0)) {
+		cerr << "Usage: " << argv[0] << " [megapixels] [repetitions]" << endl;
+		exit(1);
+	}
+
+	// Odd pixel count so that the scalar tail of each kernel is exercised.
+	ulongint count = (ulongint)(megapixels * 1000000.0) | 1;
+	vector<ucharint> rgb(count * 3);
+	unsigned int seed = 12345;
+	for (ulongint i=0; i<rgb.size(); i++) {
+		seed = seed * 1103515245 + 12345;
+		rgb[i] = (ucharint)(seed >> 16);
+	}
+
+	vector<ucharint> reference(count);
+	vector<ucharint> output(count);
+	int maxlevel = getMaxSimdLevel();
+
+	cout << "# extractGreenChannel: " << count << " pixels, "
+	     << repetitions << " repetitions" << endl;
+	cout << "**level\t**GB/s\t**check" << endl;
+	for (int level=SIMD_SCALAR; level<=maxlevel; level++) {
+		setSimdLevel(level);
+		extractGreenChannel(output.data(), rgb.data(), count);  // warm-up
+		auto start = std::chrono::steady_clock::now();
+		for (int i=0; i<repetitions; i++) {
+			extractGreenChannel(output.data(), rgb.data(), count);
+		}
+		auto stop = std::chrono::steady_clock::now();
+		double seconds = std::chrono::duration<double>(stop - start).count();
+		double gbps = (double)rgb.size() * repetitions / seconds / 1.0e9;
+
+		if (level == SIMD_SCALAR) {
+			reference = output;
+		}
+		bool ok = (output == reference);
+		cout << getSimdLevelName(level) << "\t" << fixed << setprecision(2)
+		     << gbps << "\t" << (ok ? "ok" : "MISMATCH") << endl;
+		if (!ok) {
+			return 1;
+		}
+	}
+	setSimdLevel(maxlevel);
+
+	return 0;
+}
+
+
+
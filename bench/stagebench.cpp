@@ -0,0 +1,579 @@
+//
+// Creation Date: Fri Oct 16 23:58:12 PDT 2026
+// Last Modified: Fri Oct 16 23:58:12 PDT 2026
+// Filename:      stagebench.cpp
+// Web Address:
+// Syntax:        C++
+// vim:           ts=3:nowrap:ft=text
+//
+// Description:   Benchmark of the processing stages on a synthetic roll
+//                (see RollSynthesizer) and on any images given on the
+//                command line.  Each image is read with both reader
+//                strategies (file stream and memory map), thresholded,
+//                analyzed, and written out as ATON, MIDI and an overlay
+//                image, and the stage timings are collected with the
+//                StageProfiler of the RollImage.  The FFT and the margin
+//                smoothing filter are also timed on their own.  For each
+//                stage the median and 95th percentile wall times, the
+//                throughput in MB/s and rows/s, and the increase of the
+//                peak resident memory are printed as JSON, so that runs
+//                on the same machine can be compared between commits.
+//
+// Usage:         stagebench [options] [file.tiff ...]
+// Options:
+//     -r|-g|--65|--88  Roll type of the images given on the command line
+//                (default 88-note).
+//     --repetitions  Number of runs of each stage (default 3).
+//     --length   Length of the synthetic roll in feet (default 4, 0 = none).
+//     --seed     Random seed of the synthetic roll (default 1).
+//     --no-overlay  Do not time mergePixelOverlay() (which is slow).
+//     --json     Write the results to a file instead of standard output.
+//
+
+#include "FFT.h"
+#include "RollImage.h"
+#include "RollSynthesizer.h"
+#include "Smoothing.h"
+#include "StageProfiler.h"
+#include "ThreadPool.h"
+#include "Options.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+using namespace rip;
+using namespace smf;
+
+// BenchStage: the samples of one stage (one sample per repetition).
+class BenchStage {
+	public:
+		string         name;
+		vector<double> times;             // wall seconds
+		ulonglongint   bytes        = 0;  // bytes processed in one run
+		ulongint       rows         = 0;  // image rows in one run (0 = not rows)
+		longlongint    peakRssDelta = 0;  // largest increase of the peak RSS
+};
+
+typedef vector<BenchStage> BenchList;
+
+void        addSample          (BenchList& list, const string& name, double seconds,
+                                ulonglongint bytes, ulongint rows, longlongint rss);
+double      getPercentile      (vector<double> values, double percent);
+void        printStages        (ostream& out, const BenchList& list,
+                                const string& indent);
+string      getJsonString      (const string& text);
+string      makeTemporaryFile  (const string& suffix);
+bool        copyFile           (const string& source, const string& target);
+void        benchmarkImage     (BenchList& list, const string& filename,
+                                const string& rolltype, bool overlay);
+void        benchmarkReaders   (BenchList& list, const string& filename);
+void        benchmarkThreshold (BenchList& list, const string& filename);
+void        benchmarkPipeline  (BenchList& list, const string& filename,
+                                const string& rolltype, bool overlay);
+void        benchmarkKernels   (BenchList& list, int repetitions, ulongint rows);
+void        setRollType        (RollOptions& roll, const string& rolltype);
+
+///////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("r|red|red-welte|welte-red=b", "Images are Red-Welte (T-100) piano rolls");
+	options.define("g|green|green-welte|welte-green=b", "Images are Green-Welte (T-98) piano rolls");
+	options.define("5|65|65-note|65-hole=b", "Images are 65-note rolls");
+	options.define("8|88|88-note|88-hole=b", "Images are 88-note rolls (default)");
+	options.define("repetitions=i:3", "Number of runs of each stage");
+	options.define("length=d:4", "Length of the synthetic roll in feet (0 = no synthetic roll)");
+	options.define("seed=i:1", "Random seed of the synthetic roll");
+	options.define("no-overlay=b", "Do not time the overlay image writing");
+	options.define("json=s", "Write the results to a file");
+	options.process(argc, argv);
+
+	int repetitions = options.getInteger("repetitions");
+	if (repetitions <= 0) {
+		cerr << "Usage: " << options.getCommand() << " [--repetitions n] [file.tiff ...]" << endl;
+		exit(1);
+	}
+	string rolltype = "88-note";
+	if (options.getBoolean("red-welte")) {
+		rolltype = "welte-red";
+	} else if (options.getBoolean("green-welte")) {
+		rolltype = "welte-green";
+	} else if (options.getBoolean("65-note")) {
+		rolltype = "65-note";
+	}
+	bool overlay = !options.getBoolean("no-overlay");
+
+	// Images to benchmark: (name, filename) pairs.
+	vector<pair<string, string>> images;
+	string synthetic;
+	if (options.getDouble("length") > 0.0) {
+		RollSynthesizer roll;
+		roll.setRollType("88-note");
+		roll.setLength(options.getDouble("length"));
+		roll.setSeed(options.getInteger("seed"));
+		synthetic = makeTemporaryFile(".tif");
+		if (synthetic.empty() || !roll.writeTiff(synthetic)) {
+			cerr << "Cannot write the synthetic roll" << endl;
+			exit(1);
+		}
+		images.push_back(make_pair("synthetic", synthetic));
+	}
+	for (int i=1; i<=options.getArgCount(); i++) {
+		images.push_back(make_pair(options.getArg(i), options.getArg(i)));
+	}
+
+	stringstream out;
+	ulongint maxrows = 0;
+	out << "{\n";
+	out << "\t\"benchmark\": \"stagebench\",\n";
+	out << "\t\"software_date\": \"" << __DATE__ << " " << __TIME__ << "\",\n";
+	out << "\t\"simd\": \"" << getSimdLevelName(getSimdLevel()) << "\",\n";
+	out << "\t\"threads\": " << ThreadPool::getShared().getThreadCount() << ",\n";
+	out << "\t\"repetitions\": " << repetitions << ",\n";
+	out << "\t\"images\": [";
+	for (ulongint i=0; i<images.size(); i++) {
+		BenchList list;
+		TiffFile image;
+		if (!image.open(images[i].second)) {
+			continue;
+		}
+		ulongint rows = image.getRows();
+		ulongint cols = image.getCols();
+		image.close();
+		maxrows = std::max(maxrows, rows);
+		cerr << "[BENCH] " << images[i].first << endl;
+		for (int j=0; j<repetitions; j++) {
+			benchmarkImage(list, images[i].second, rolltype, overlay);
+		}
+		out << (i ? ",\n" : "\n");
+		out << "\t\t{\n";
+		out << "\t\t\t\"name\": "   << getJsonString(images[i].first) << ",\n";
+		out << "\t\t\t\"rows\": "   << rows                           << ",\n";
+		out << "\t\t\t\"cols\": "   << cols                           << ",\n";
+		out << "\t\t\t\"bytes\": "  << (ulonglongint)rows * cols * 3  << ",\n";
+		out << "\t\t\t\"stages\": ";
+		printStages(out, list, "\t\t\t");
+		out << "\n\t\t}";
+	}
+	out << "\n\t],\n";
+
+	cerr << "[BENCH] kernels" << endl;
+	BenchList kernels;
+	benchmarkKernels(kernels, repetitions, maxrows ? maxrows : 100000);
+	out << "\t\"kernels\": ";
+	printStages(out, kernels, "\t");
+	out << ",\n";
+	out << "\t\"peak_rss\": " << StageProfiler::getPeakRss() << "\n";
+	out << "}\n";
+
+	if (!synthetic.empty()) {
+		unlink(synthetic.c_str());
+	}
+
+	if (options.getBoolean("json")) {
+		ofstream output(options.getString("json"));
+		if (!output.is_open()) {
+			cerr << "Cannot write " << options.getString("json") << endl;
+			exit(1);
+		}
+		output << out.str();
+	} else {
+		cout << out.str();
+	}
+
+	return 0;
+}
+
+
+
+//////////////////////////////
+//
+// benchmarkImage -- One run of each stage on the image.
+//
+
+void benchmarkImage(BenchList& list, const string& filename,
+		const string& rolltype, bool overlay) {
+	benchmarkReaders(list, filename);
+	benchmarkThreshold(list, filename);
+	benchmarkPipeline(list, filename, rolltype, overlay);
+}
+
+
+
+//////////////////////////////
+//
+// benchmarkReaders -- Extract the green channel from every row, reading
+//     the rows from the file stream and from the memory map.
+//
+
+void benchmarkReaders(BenchList& list, const string& filename) {
+	for (int mapped=0; mapped<2; mapped++) {
+		TiffFile image;
+		if (!image.open(filename)) {
+			return;
+		}
+		image.allowPixelMapping(mapped);
+		ulongint rows = image.getRows();
+		ulongint cols = image.getCols();
+		vector<ucharint> green(cols);
+
+		longlongint rss = StageProfiler::getPeakRss();
+		auto start = std::chrono::steady_clock::now();
+		for (ulongint r=0; r<rows; r++) {
+			extractGreenChannel(green.data(), image.getRowPixels(r), cols);
+			if ((r + 1) % 256 == 0) {
+				image.releaseRowPixels(r + 1 - 256, 256);
+			}
+		}
+		auto stop = std::chrono::steady_clock::now();
+		addSample(list, mapped ? "read/mmap" : "read/stream",
+				std::chrono::duration<double>(stop - start).count(),
+				(ulonglongint)rows * cols * 3, rows,
+				StageProfiler::getPeakRss() - rss);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// benchmarkThreshold -- Classify the pixels of the green channel (already
+//     in memory) as paper or non-paper, both as bytes and as bits.
+//
+
+void benchmarkThreshold(BenchList& list, const string& filename) {
+	TiffFile image;
+	if (!image.open(filename)) {
+		return;
+	}
+	ImagePlane<ucharint> green;
+	image.getImageGreenChannel(green);
+	ulongint rows = image.getRows();
+	ulongint cols = image.getCols();
+	image.close();
+
+	vector<ucharint> classes(cols);
+	vector<ulonglongint> bits((cols + 63) / 64);
+	longlongint rss = StageProfiler::getPeakRss();
+	auto start = std::chrono::steady_clock::now();
+	for (ulongint r=0; r<rows; r++) {
+		markAboveThreshold(classes.data(), green.getRow(r), cols, 249);
+		packBelowThreshold(bits.data(), green.getRow(r), cols, 249);
+	}
+	auto stop = std::chrono::steady_clock::now();
+	addSample(list, "threshold", std::chrono::duration<double>(stop - start).count(),
+			(ulonglongint)rows * cols, rows, StageProfiler::getPeakRss() - rss);
+}
+
+
+
+//////////////////////////////
+//
+// benchmarkPipeline -- Load and analyze the image as tiff2holes does, write
+//     the ATON analysis (which includes the MIDI files), and merge the
+//     overlay into a copy of the image.  The times are the StageProfiler
+//     records of the roll (stages which run more than once are added
+//     together).
+//
+
+void benchmarkPipeline(BenchList& list, const string& filename,
+		const string& rolltype, bool overlay) {
+	RollImage roll;
+	if (!roll.open(filename)) {
+		return;
+	}
+	setRollType(roll, rolltype);
+	roll.getProfiler().setEnabled(true);
+	ulongint rows = roll.getRows();
+
+	roll.loadGreenChannel(roll.getThreshold(), false);
+	roll.analyze();
+	stringstream aton;
+	roll.printRollImageProperties(aton);
+
+	string copy;
+	if (overlay) {
+		copy = makeTemporaryFile(".tif");
+		if (!copy.empty() && copyFile(filename, copy)) {
+			fstream output(copy, ios::binary | ios::in | ios::out);
+			roll.mergePixelOverlay(output);
+			output.close();
+		}
+		if (!copy.empty()) {
+			unlink(copy.c_str());
+		}
+	}
+
+	vector<StageRecord> records = roll.getProfiler().getRecords();
+	vector<string> order;
+	map<string, BenchStage> sums;
+	for (ulongint i=0; i<records.size(); i++) {
+		StageRecord& record = records[i];
+		if (!record.finished) {
+			continue;
+		}
+		BenchStage& stage = sums[record.name];
+		if (stage.times.empty()) {
+			order.push_back(record.name);
+			stage.times.push_back(0.0);
+		}
+		stage.times[0] += record.wallTime;
+		stage.bytes += record.bytes;
+		stage.peakRssDelta = std::max(stage.peakRssDelta, record.peakRssDelta);
+	}
+	for (ulongint i=0; i<order.size(); i++) {
+		BenchStage& stage = sums[order[i]];
+		if ((order[i] == "printRollImageProperties") && (stage.bytes == 0)) {
+			stage.bytes = aton.str().size();
+		}
+		addSample(list, order[i], stage.times[0], stage.bytes, rows, stage.peakRssDelta);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// benchmarkKernels -- Time the FFT (as used for the tracker-bar spacing)
+//     and each margin smoothing mode on signals as long as the images.
+//
+
+void benchmarkKernels(BenchList& list, int repetitions, ulongint rows) {
+	ulongint size = 65536;
+	int calls = 20;
+	vector<double> real(size);
+	vector<mycomplex> data(size);
+	vector<mycomplex> output;
+	for (ulongint i=0; i<size; i++) {
+		real[i] = (i * 7919) % 101;
+		data[i] = real[i];
+	}
+	const FFTPlan& plan = FFTPlan::getPlan((int)size);
+
+	// six signals: the two margins at three gains, as in analyzeTears()
+	vector<double> gains = {0.100, 0.050, 0.001, 0.100, 0.050, 0.001};
+	vector<vector<double>> margins(gains.size(), vector<double>(rows));
+	for (ulongint i=0; i<margins.size(); i++) {
+		for (ulongint r=0; r<rows; r++) {
+			margins[i][r] = 300.0 + (r * (i + 3)) % 17;
+		}
+	}
+
+	for (int j=0; j<repetitions; j++) {
+		auto start = std::chrono::steady_clock::now();
+		for (int k=0; k<calls; k++) {
+			vector<mycomplex> copy = data;
+			plan.transform(copy);
+		}
+		auto stop = std::chrono::steady_clock::now();
+		addSample(list, "fft/complex-65536",
+				std::chrono::duration<double>(stop - start).count() / calls,
+				size * sizeof(mycomplex), 0, 0);
+
+		start = std::chrono::steady_clock::now();
+		for (int k=0; k<calls; k++) {
+			plan.transformReal(output, real);
+		}
+		stop = std::chrono::steady_clock::now();
+		addSample(list, "fft/real-65536",
+				std::chrono::duration<double>(stop - start).count() / calls,
+				size * sizeof(double), 0, 0);
+
+		for (int mode=SMOOTH_EXACT; mode<=SMOOTH_FIXED; mode++) {
+			vector<vector<double>> work = margins;
+			vector<vector<double>*> signals;
+			for (ulongint i=0; i<work.size(); i++) {
+				signals.push_back(&work[i]);
+			}
+			longlongint rss = StageProfiler::getPeakRss();
+			start = std::chrono::steady_clock::now();
+			smoothSignals(signals, gains, mode);
+			stop = std::chrono::steady_clock::now();
+			addSample(list, string("smoothing/") + getSmoothingModeName(mode),
+					std::chrono::duration<double>(stop - start).count(),
+					(ulonglongint)rows * sizeof(double) * gains.size(), rows,
+					StageProfiler::getPeakRss() - rss);
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// addSample -- Add a time to the named stage (creating it if needed).
+//
+
+void addSample(BenchList& list, const string& name, double seconds,
+		ulonglongint bytes, ulongint rows, longlongint rss) {
+	BenchStage* stage = NULL;
+	for (ulongint i=0; i<list.size(); i++) {
+		if (list[i].name == name) {
+			stage = &list[i];
+			break;
+		}
+	}
+	if (!stage) {
+		list.emplace_back();
+		stage = &list.back();
+		stage->name = name;
+	}
+	stage->times.push_back(seconds);
+	stage->bytes = bytes;
+	stage->rows = rows;
+	stage->peakRssDelta = std::max(stage->peakRssDelta, rss);
+}
+
+
+
+//////////////////////////////
+//
+// getPercentile -- Nearest-rank percentile of the values (50 = median).
+//
+
+double getPercentile(vector<double> values, double percent) {
+	if (values.empty()) {
+		return 0.0;
+	}
+	std::sort(values.begin(), values.end());
+	ulongint rank = (ulongint)std::ceil(percent / 100.0 * values.size());
+	if (rank < 1) {
+		rank = 1;
+	}
+	return values.at(std::min(rank, (ulongint)values.size()) - 1);
+}
+
+
+
+//////////////////////////////
+//
+// printStages -- Print the statistics of the stages as a JSON array,
+//     with the entries indented one tab more than the closing bracket.
+//     Throughputs are calculated from the median time, and are null when
+//     a stage has no byte or row count.
+//
+
+void printStages(ostream& out, const BenchList& list, const string& indent) {
+	out << "[";
+	for (ulongint i=0; i<list.size(); i++) {
+		const BenchStage& stage = list[i];
+		double median = getPercentile(stage.times, 50.0);
+		double p95 = getPercentile(stage.times, 95.0);
+		out << (i ? ",\n" : "\n");
+		out << indent << "\t{\"name\": " << getJsonString(stage.name);
+		out << ", \"samples\": "   << stage.times.size();
+		out << ", \"median_ms\": " << median * 1000.0;
+		out << ", \"p95_ms\": "    << p95 * 1000.0;
+		out << ", \"mb_per_s\": ";
+		if ((stage.bytes > 0) && (median > 0.0)) {
+			out << stage.bytes / median / 1.0e6;
+		} else {
+			out << "null";
+		}
+		out << ", \"rows_per_s\": ";
+		if ((stage.rows > 0) && (median > 0.0)) {
+			out << stage.rows / median;
+		} else {
+			out << "null";
+		}
+		out << ", \"peak_rss_delta\": " << stage.peakRssDelta;
+		out << "}";
+	}
+	out << "\n" << indent << "]";
+}
+
+
+
+//////////////////////////////
+//
+// getJsonString -- Quote a string for JSON.
+//
+
+string getJsonString(const string& text) {
+	string output = "\"";
+	for (ulongint i=0; i<text.size(); i++) {
+		char ch = text[i];
+		if ((ch == '"') || (ch == '\\')) {
+			output += '\\';
+			output += ch;
+		} else if ((unsigned char)ch < 0x20) {
+			char buffer[8];
+			snprintf(buffer, sizeof(buffer), "\\u%04x", ch);
+			output += buffer;
+		} else {
+			output += ch;
+		}
+	}
+	output += "\"";
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// makeTemporaryFile -- Create an empty file in $TMPDIR (or /tmp) and
+//     return its name (empty if it cannot be created).
+//
+
+string makeTemporaryFile(const string& suffix) {
+	const char* directory = getenv("TMPDIR");
+	string name = string(directory ? directory : "/tmp") + "/stagebench-XXXXXX" + suffix;
+	vector<char> buffer(name.begin(), name.end());
+	buffer.push_back('\0');
+	int fd = mkstemps(buffer.data(), (int)suffix.size());
+	if (fd < 0) {
+		return "";
+	}
+	close(fd);
+	return string(buffer.data());
+}
+
+
+
+//////////////////////////////
+//
+// copyFile -- Copy the bytes of a file.
+//
+
+bool copyFile(const string& source, const string& target) {
+	ifstream input(source, ios::binary);
+	ofstream output(target, ios::binary | ios::trunc);
+	if (!input.is_open() || !output.is_open()) {
+		return false;
+	}
+	output << input.rdbuf();
+	return output.good();
+}
+
+
+
+//////////////////////////////
+//
+// setRollType -- Apply the settings of the named roll type.
+//
+
+void setRollType(RollOptions& roll, const string& rolltype) {
+	if (rolltype == "welte-red") {
+		roll.setRollTypeRedWelte();
+	} else if (rolltype == "welte-green") {
+		roll.setRollTypeGreenWelte();
+	} else if (rolltype == "65-note") {
+		roll.setRollType65Note();
+	} else {
+		roll.setRollType88Note();
+	}
+}
+
+
+
@@ -0,0 +1,67 @@
+//
+// Creation Date: Fri Oct 16 16:21:07 PDT 2026
+// Last Modified: Fri Oct 16 16:21:07 PDT 2026
+// Filename:      BitPlane.h
+// Web Address:
+// Syntax:        C++
+// vim:           ts=3:nowrap:ft=text
+//
+// Description:   Two-dimensional mask with one bit per pixel, packed
+//                into 64-bit words (bit c % 64 of word c / 64 in each
+//                row).  Searches and counts work on a whole word at a
+//                time with count-trailing/leading-zeros and popcount.
+//
+
+#ifndef _BITPLANE_H
+#define _BITPLANE_H
+
+#include "Utilities.h"
+
+#include <vector>
+
+namespace rip  {
+
+class BitPlane {
+	public:
+		                   BitPlane           (void);
+		                  ~BitPlane           ();
+
+		void               resize             (ulongint rows, ulongint cols);
+		void               clear              (void);
+		ulongint           getRows            (void) const { return m_rows; }
+		ulongint           getCols            (void) const { return m_cols; }
+		ulongint           getWordsPerRow     (void) const { return m_stride; }
+		bool               empty              (void) const { return m_rows == 0; }
+
+		ulonglongint*      getRow             (ulongint row) { return m_words.data() + row * m_stride; }
+		const ulonglongint* getRow            (ulongint row) const { return m_words.data() + row * m_stride; }
+		bool               getBit             (ulongint row, ulongint col) const;
+
+		long               findSet            (ulongint row, ulongint startcol) const;
+		long               findSetReverse     (ulongint row, ulongint startcol) const;
+		long               findClear          (ulongint row, ulongint startcol) const;
+		ulongint           countSet           (ulongint row, ulongint startcol,
+		                                       ulongint endcol) const;
+		ulongint           getMemorySize      (void) const;
+
+	private:
+		// m_words: the bits of all rows.  Bits past the end of a row are
+		// always zero.
+		std::vector<ulonglongint> m_words;
+
+		// m_rows: the number of rows.
+		ulongint m_rows   = 0;
+
+		// m_cols: the number of bits in each row.
+		ulongint m_cols   = 0;
+
+		// m_stride: the number of words in each row.
+		ulongint m_stride = 0;
+};
+
+} // end rip namespace
+
+#endif /* _BITPLANE_H */
+
+
+
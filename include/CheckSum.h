@@ -16,6 +16,8 @@
 #include <sstream>
 #include <vector>
 
+#include "ImagePlane.h"
+
 using namespace std;
 
 struct MD5_CTX {              // MD5 context
@@ -35,8 +37,16 @@ class CheckSum {
       // equivalent to the md5sum output by "md5sum" command:
       string               getMD5Sum (const string& data);
       string               getMD5Sum (vector<vector<unsigned char> >& data);
+      string               getMD5Sum (const rip::ImagePlane<unsigned char>& data);
       void                 getMD5Sum (ostream& out, stringstream& data);
 
+      // incremental md5sum, for data which arrives in pieces (the result
+      // is the same as getMD5Sum() of the concatenated pieces):
+      void                 startMD5Sum  (void);
+      void                 addToMD5Sum  (const unsigned char* data,
+                                         unsigned long length);
+      string               finishMD5Sum (void);
+
    protected:
 
       // md5sum calculation functions
@@ -51,6 +61,9 @@ class CheckSum {
       static void Decode       (unsigned long *output, unsigned char *input, 
                                 unsigned int len);
 
+      // m_md5context: state of the incremental md5sum calculation.
+      MD5_CTX m_md5context;
+
 };
 
 
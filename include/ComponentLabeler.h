@@ -0,0 +1,159 @@
+//
+// Creation Date: Fri Oct 16 12:20:41 PDT 2026
+// Last Modified: Fri Oct 16 12:20:41 PDT 2026
+// Filename:      ComponentLabeler.h
+// Web Address:
+// Syntax:        C++
+// vim:           ts=3:nowrap:ft=text
+//
+// Description:   Run-based connected-component labeling (8-connectivity)
+//                of the pixels in an image plane which have a given value.
+//                Each row is split into runs of matching pixels, and runs
+//                that touch runs on the previous row are merged with a
+//                union-find structure.  The area, bounding box, centroid,
+//                second-order moments, perimeter and entry point of each
+//                component are calculated from its runs, with no recursion
+//                and without visiting pixels more than once.  Horizontal bands of the
+//                image can be labeled in parallel, with the components
+//                that cross band boundaries joined afterwards.  Planes
+//                can be either one byte per pixel or run-length encoded.
+//
+
+#ifndef _COMPONENTLABELER_H
+#define _COMPONENTLABELER_H
+
+#include "BitPlane.h"
+#include "ImagePlane.h"
+#include "RunLengthPlane.h"
+
+#include <vector>
+
+namespace rip  {
+
+// ComponentRun: horizontal run of pixels [start, end) in a row.
+class ComponentRun {
+	public:
+		unsigned int row;
+		unsigned int start;
+		unsigned int end;
+};
+
+
+// ComponentInfo: summary of a connected component.
+class ComponentInfo {
+	public:
+		ulongint      area;       // number of pixels
+		ulongint      minrow;     // bounding box (inclusive)
+		ulongint      mincol;
+		ulongint      maxrow;
+		ulongint      maxcol;
+		ulonglongint  rowsum;     // sum of pixel rows (for centroid)
+		ulonglongint  colsum;     // sum of pixel columns (for centroid)
+		ulongint      entryrow;   // first pixel in the seed window, in
+		ulongint      entrycol;   //    row-major order
+		ulongint      runstart;   // index of first run in getRuns()
+		ulongint      runcount;   // number of runs in the component
+		double        moment20;   // central moments, where moment20 is the
+		double        moment02;   //    sum of (col-centroid)^2, and moment02
+		double        moment11;   //    is the sum of (row-centroid)^2.
+		double        perimeter;  // outer contour length, in pixels
+
+		// Pixel sums relative to the first pixel of the component (used to
+		// calculate the central moments without cancellation problems):
+		ulongint      baserow;
+		ulongint      basecol;
+		double        drsum;
+		double        dcsum;
+		double        drdrsum;
+		double        dcdcsum;
+		double        drdcsum;
+};
+
+
+class ComponentLabeler {
+	public:
+		                   ComponentLabeler   (void);
+		                  ~ComponentLabeler   ();
+
+		void               clear              (void);
+		void               setSeedWindow      (ulongint startrow, ulongint endrow,
+		                                       ulongint startcol, ulongint endcol);
+		void               setThreadCount     (int count);
+		void               setSkipMask        (const BitPlane* mask);
+		int                getThreadCount     (void);
+		ulongint           label              (ImagePlane<ucharint>& plane,
+		                                       ucharint target);
+		ulongint           label              (RunLengthPlane& plane,
+		                                       ucharint target);
+		ulongint           getComponentCount  (void) { return m_components.size(); }
+		ComponentInfo&     getComponent       (ulongint index) { return m_components[index]; }
+		const ComponentRun* getRuns           (ulongint index);
+		void               paintComponent     (ImagePlane<ucharint>& plane,
+		                                       ulongint index, ucharint value);
+		void               paintComponent     (ImagePlane<ucharint>& plane,
+		                                       ulongint index, ucharint value,
+		                                       ucharint lowest, ucharint highest);
+
+	protected:
+		class Band {
+			public:
+				ulongint                  startrow;
+				ulongint                  endrow;
+				std::vector<ComponentRun> runs;      // runs in band rows
+				std::vector<ulongint>     rowStart;  // first run of each row
+				std::vector<unsigned int> parent;    // union-find within band
+		};
+
+		template <class PLANE>
+		ulongint           labelPlane         (PLANE& plane, ucharint target);
+		void               labelBand          (ImagePlane<ucharint>& plane,
+		                                       ucharint target, Band& band);
+		void               labelBand          (RunLengthPlane& plane,
+		                                       ucharint target, Band& band);
+		void               linkBand           (Band& band);
+		void               joinBands          (std::vector<Band>& bands);
+		void               collectComponents  (void);
+		void               calculateShape     (ComponentInfo& info);
+
+	private:
+		// m_runs: all runs of target pixels in row-major order.
+		std::vector<ComponentRun> m_runs;
+
+		// m_rowStart: index of the first run in each row (with an extra
+		// entry at the end for the total run count).
+		std::vector<ulongint> m_rowStart;
+
+		// m_parent: union-find parent of each run.
+		std::vector<unsigned int> m_parent;
+
+		// m_components: components which have at least one pixel in the
+		// seed window, sorted by entry point.
+		std::vector<ComponentInfo> m_components;
+
+		// m_componentRuns: runs grouped by component (see
+		// ComponentInfo::runstart).
+		std::vector<ComponentRun> m_componentRuns;
+
+		// Seed window: only components touching this region are reported,
+		// although they are followed outside of it.
+		ulongint m_startrow = 0;
+		ulongint m_endrow   = 0;
+		ulongint m_startcol = 0;
+		ulongint m_endcol   = 0;
+		bool     m_window   = false;
+
+		// m_threadCount: number of bands to label in parallel (0 = the
+		// thread count of the shared ThreadPool).
+		int      m_threadCount = 1;
+
+		// m_skipmask: pixels with a set bit are never target pixels (such
+		// as paper), so they are skipped 64 at a time (NULL = no mask).
+		const BitPlane* m_skipmask = NULL;
+};
+
+} // end rip namespace
+
+#endif /* _COMPONENTLABELER_H */
+
+
+
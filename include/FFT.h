@@ -34,6 +34,44 @@ void       fft_destructive  (std::vector<mycomplex>& X);
 bool       isPowerOfTwo     (int value);
 
 
+// FFTPlan: precalculated bit-reversal table and twiddle factors for
+// transforms of one (power of two) size.  Plans are expensive to set up
+// and cheap to use, so get them from getPlan(), which keeps one plan per
+// size for the whole program (such as for a batch of rolls).
+
+class FFTPlan {
+	public:
+		                  FFTPlan          (int size = 0);
+		                 ~FFTPlan          ();
+
+		static const FFTPlan& getPlan      (int size);
+
+		bool              setSize          (int size);
+		int               getSize          (void) const { return m_size; }
+		void              transform        (std::vector<mycomplex>& data) const;
+		void              transformReal    (std::vector<mycomplex>& output,
+		                                    const std::vector<double>& input) const;
+
+	protected:
+		void              transformInPlace (mycomplex* data, int size,
+		                                    const std::vector<int>& bitrev,
+		                                    int stride) const;
+		static void       makeBitReversal  (std::vector<int>& table, int size);
+
+	private:
+		int               m_size;
+
+		// m_twiddles: exp(-2 pi i k / m_size) for k from 0 to m_size/2-1.
+		std::vector<mycomplex> m_twiddles;
+
+		// m_bitrev: bit reversal of indexes for complex transforms of
+		// m_size samples; m_halfBitrev for m_size/2 samples (used by
+		// transformReal()).
+		std::vector<int>  m_bitrev;
+		std::vector<int>  m_halfBitrev;
+};
+
+
 } // end namespace rip
 
 
@@ -48,6 +48,9 @@ class HoleInfo {
 		double                    circularity;  // circularity of hole
 		double                    perimeter;    // outer contour of hole
 		double                    majoraxis;    // angle of longest axis
+		double                    moment20;     // central moment: sum of (col-centroid)^2
+		double                    moment02;     // central moment: sum of (row-centroid)^2
+		double                    moment11;     // central moment: sum of (col-centroid)*(row-centroid)
 		double                    coldrift;     // column drive in pixels
 		std::string               id;           // unique identifier (if not empty)
 		std::string               reason;       // reason for being a bad hole (if bad)
@@ -58,6 +61,8 @@ class HoleInfo {
 		bool                      snakebite;    // true if part of melody highlighting
 		ulongint                  offtime;      // if attack==true, then this is the offtime of the note
 		int                       midikey;      // MIDI key number for note
+		long                      component;    // index of the hole's pixel runs in
+		                                        // RollImage::holeComponents (-1 = none)
 
 		void     clear            (void);
 		bool     isMusicHole      (void) { return m_type == 1 ? 1 : 0; }
@@ -0,0 +1,355 @@
+//
+// Creation Date: Fri Oct 16 11:02:17 PDT 2026
+// Last Modified: Fri Oct 16 11:02:17 PDT 2026
+// Filename:      ImagePlane.h
+// Web Address:
+// Syntax:        C++
+// vim:           ts=3:nowrap:ft=text
+//
+// Description:   Two-dimensional image buffer stored in a single memory
+//                allocation.  Rows are stride elements apart, and can
+//                optionally start on 64-byte boundaries for vector
+//                instructions.  Indexing with plane[r][c] and
+//                plane.at(r).at(c) works the same way as for the
+//                vector<vector<>> planes which this class replaces.
+//                A plane may also be stored in a temporary file (see
+//                setScratchDirectory()), so that bands of rows which are
+//                not in use can be dropped from memory with releaseRows().
+//
+
+#ifndef _IMAGEPLANE_H
+#define _IMAGEPLANE_H
+
+#include "MappedBuffer.h"
+#include "Utilities.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace rip {
+
+template <class TYPE>
+class ImagePlane {
+	public:
+
+		// RowSpan: a view of one row of the plane (valid until the plane
+		// is resized or destroyed).
+		class RowSpan {
+			public:
+				           RowSpan    (TYPE* data, ulongint size) : m_data(data), m_size(size) { }
+				TYPE&      operator[] (ulongint index) const { return m_data[index]; }
+				TYPE&      at         (ulongint index) const;
+				ulongint   size       (void) const { return m_size; }
+				TYPE*      data       (void) const { return m_data; }
+				TYPE*      begin      (void) const { return m_data; }
+				TYPE*      end        (void) const { return m_data + m_size; }
+			private:
+				TYPE*      m_data;
+				ulongint   m_size;
+		};
+
+		                ImagePlane    (void);
+		                ImagePlane    (ulongint rows, ulongint cols,
+		                               bool alignRows = false);
+		                ImagePlane    (const ImagePlane& plane) = delete;
+		                ImagePlane    (ImagePlane&& plane);
+		               ~ImagePlane    () { }
+
+		ImagePlane&     operator=     (const ImagePlane& plane) = delete;
+		ImagePlane&     operator=     (ImagePlane&& plane);
+
+		void            resize        (ulongint rows, ulongint cols,
+		                               bool alignRows = false);
+		void            clear         (void);
+		void            fill          (TYPE value);
+
+		void            setScratchDirectory (const std::string& directory,
+		                                     bool state = true);
+		bool            isFileBacked  (void) const { return !m_mapped.empty(); }
+		void            releaseRows   (ulongint startrow, ulongint count);
+
+		ulongint        getRows       (void) const { return m_rows; }
+		ulongint        getCols       (void) const { return m_cols; }
+		ulongint        getStride     (void) const { return m_stride; }
+		bool            empty         (void) const { return m_rows == 0; }
+
+		TYPE*           getRow        (ulongint row) { return m_base + row * m_stride; }
+		const TYPE*     getRow        (ulongint row) const { return m_base + row * m_stride; }
+		RowSpan         operator[]    (ulongint row) { return RowSpan(getRow(row), m_cols); }
+		RowSpan         at            (ulongint row);
+
+		// Compatibility with std::vector<std::vector<TYPE> > planes:
+		ulongint        size          (void) const { return m_rows; }
+		void            copyTo        (std::vector<std::vector<TYPE> >& output) const;
+
+	private:
+		// m_storage: the memory for all rows (including alignment padding).
+		std::vector<TYPE> m_storage;
+
+		// m_mapped: the rows when the plane is stored in a temporary file
+		// (m_storage is empty then).
+		MappedBuffer m_mapped;
+
+		// m_scratch: resize() puts the plane in a temporary file in the
+		// m_scratchDir directory (empty = $TMPDIR) if true.
+		bool         m_scratch = false;
+		std::string  m_scratchDir;
+
+		// m_base: the start of the first row inside of m_storage.
+		TYPE*     m_base;
+
+		// m_rows: the number of rows in the image.
+		ulongint  m_rows;
+
+		// m_cols: the number of columns in the image.
+		ulongint  m_cols;
+
+		// m_stride: the number of elements from the start of one row
+		// to the start of the next.
+		ulongint  m_stride;
+};
+
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+//  Templates --
+//
+
+//////////////////////////////
+//
+// ImagePlane::RowSpan::at -- Access a column of the row, with bounds
+//     checking like std::vector::at().
+//
+
+template <class TYPE>
+TYPE& ImagePlane<TYPE>::RowSpan::at(ulongint index) const {
+	if (index >= m_size) {
+		throw std::out_of_range("ImagePlane column index out of range");
+	}
+	return m_data[index];
+}
+
+
+
+//////////////////////////////
+//
+// ImagePlane::ImagePlane -- Constructors.
+//
+
+template <class TYPE>
+ImagePlane<TYPE>::ImagePlane(void) {
+	m_base   = NULL;
+	m_rows   = 0;
+	m_cols   = 0;
+	m_stride = 0;
+}
+
+
+template <class TYPE>
+ImagePlane<TYPE>::ImagePlane(ulongint rows, ulongint cols, bool alignRows) {
+	m_base   = NULL;
+	m_rows   = 0;
+	m_cols   = 0;
+	m_stride = 0;
+	resize(rows, cols, alignRows);
+}
+
+
+template <class TYPE>
+ImagePlane<TYPE>::ImagePlane(ImagePlane&& plane) {
+	m_storage = std::move(plane.m_storage);
+	m_mapped  = std::move(plane.m_mapped);
+	m_scratch = plane.m_scratch;
+	m_scratchDir = plane.m_scratchDir;
+	m_base    = plane.m_base;
+	m_rows    = plane.m_rows;
+	m_cols    = plane.m_cols;
+	m_stride  = plane.m_stride;
+	plane.clear();
+}
+
+
+
+//////////////////////////////
+//
+// ImagePlane::operator= -- Move assignment.
+//
+
+template <class TYPE>
+ImagePlane<TYPE>& ImagePlane<TYPE>::operator=(ImagePlane&& plane) {
+	if (this == &plane) {
+		return *this;
+	}
+	m_storage = std::move(plane.m_storage);
+	m_mapped  = std::move(plane.m_mapped);
+	m_scratch = plane.m_scratch;
+	m_scratchDir = plane.m_scratchDir;
+	m_base    = plane.m_base;
+	m_rows    = plane.m_rows;
+	m_cols    = plane.m_cols;
+	m_stride  = plane.m_stride;
+	plane.clear();
+	return *this;
+}
+
+
+
+//////////////////////////////
+//
+// ImagePlane::resize -- Allocate the plane for the given size, with all
+//     elements set to zero (previous contents are not kept).  If alignRows
+//     is true, each row starts on a 64-byte boundary.  A plane with a
+//     scratch directory is stored in a temporary file (or in memory if the
+//     file cannot be created).
+//
+
+template <class TYPE>
+void ImagePlane<TYPE>::resize(ulongint rows, ulongint cols, bool alignRows) {
+	const ulongint alignment = 64;
+	ulongint stride = cols;
+	ulongint padding = 0;
+	if (alignRows && (alignment % sizeof(TYPE) == 0)) {
+		ulongint elements = alignment / sizeof(TYPE);
+		stride  = (cols + elements - 1) / elements * elements;
+		padding = elements - 1;
+	}
+
+	m_storage.clear();
+	m_storage.shrink_to_fit();
+	m_mapped.clear();
+	if (m_scratch && (rows * stride > 0) &&
+			m_mapped.create((ulonglongint)rows * stride * sizeof(TYPE), m_scratchDir)) {
+		// mappings start on a page boundary, so the rows are aligned:
+		m_base   = (TYPE*)m_mapped.data();
+		m_rows   = rows;
+		m_cols   = cols;
+		m_stride = stride;
+		return;
+	}
+	m_storage.resize(rows * stride + padding);
+	m_base = m_storage.data();
+	if (padding > 0) {
+		ulongint misalignment = (ulongint)m_base % alignment;
+		if (misalignment) {
+			m_base += (alignment - misalignment) / sizeof(TYPE);
+		}
+	}
+	m_rows   = rows;
+	m_cols   = cols;
+	m_stride = stride;
+}
+
+
+
+//////////////////////////////
+//
+// ImagePlane::clear -- Release the memory for the plane.
+//
+
+template <class TYPE>
+void ImagePlane<TYPE>::clear(void) {
+	m_storage.clear();
+	m_storage.shrink_to_fit();
+	m_mapped.clear();
+	m_base   = NULL;
+	m_rows   = 0;
+	m_cols   = 0;
+	m_stride = 0;
+}
+
+
+
+//////////////////////////////
+//
+// ImagePlane::setScratchDirectory -- Store the plane in a temporary file
+//     in the directory (empty = $TMPDIR or /tmp) from the next resize(),
+//     or in memory if state is false.
+//
+
+template <class TYPE>
+void ImagePlane<TYPE>::setScratchDirectory(const std::string& directory, bool state) {
+	m_scratch    = state;
+	m_scratchDir = directory;
+}
+
+
+
+//////////////////////////////
+//
+// ImagePlane::releaseRows -- Write the rows to the temporary file of the
+//     plane and drop them from memory until they are accessed again.
+//     Does nothing for planes in memory.
+//
+
+template <class TYPE>
+void ImagePlane<TYPE>::releaseRows(ulongint startrow, ulongint count) {
+	if (m_mapped.empty() || (startrow >= m_rows)) {
+		return;
+	}
+	if (count > m_rows - startrow) {
+		count = m_rows - startrow;
+	}
+	m_mapped.release((ulonglongint)startrow * m_stride * sizeof(TYPE),
+			(ulonglongint)count * m_stride * sizeof(TYPE));
+}
+
+
+
+//////////////////////////////
+//
+// ImagePlane::fill -- Set all elements of the plane to the given value.
+//
+
+template <class TYPE>
+void ImagePlane<TYPE>::fill(TYPE value) {
+	for (ulongint r=0; r<m_rows; r++) {
+		TYPE* row = getRow(r);
+		for (ulongint c=0; c<m_cols; c++) {
+			row[c] = value;
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// ImagePlane::at -- Access a row of the plane, with bounds checking
+//     like std::vector::at().
+//
+
+template <class TYPE>
+typename ImagePlane<TYPE>::RowSpan ImagePlane<TYPE>::at(ulongint row) {
+	if (row >= m_rows) {
+		throw std::out_of_range("ImagePlane row index out of range");
+	}
+	return RowSpan(getRow(row), m_cols);
+}
+
+
+
+//////////////////////////////
+//
+// ImagePlane::copyTo -- Copy the plane into a vector of row vectors, for
+//     code which has not yet been converted to ImagePlane.
+//
+
+template <class TYPE>
+void ImagePlane<TYPE>::copyTo(std::vector<std::vector<TYPE> >& output) const {
+	output.resize(m_rows);
+	for (ulongint r=0; r<m_rows; r++) {
+		const TYPE* row = getRow(r);
+		output[r].assign(row, row + m_cols);
+	}
+}
+
+
+} // end namespace rip
+
+
+#endif /* _IMAGEPLANE_H */
+
+
+
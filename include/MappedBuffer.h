@@ -0,0 +1,58 @@
+//
+// Creation Date: Fri Oct 16 23:59:48 PDT 2026
+// Last Modified: Fri Oct 16 23:59:48 PDT 2026
+// Filename:      MappedBuffer.h
+// Web Address:
+// Syntax:        C++
+// vim:           ts=3:nowrap:ft=text
+//
+// Description:   Block of memory stored in an anonymous temporary file and
+//                mapped into the address space, so that image planes
+//                larger than the available memory can be processed.  The
+//                file is removed from its directory as soon as it has been
+//                created, so nothing is left behind if the program stops.
+//                Parts of the buffer which are not needed for a while can
+//                be written out and dropped from memory with release();
+//                they are read back from the file when next accessed.
+//
+
+#ifndef _MAPPEDBUFFER_H
+#define _MAPPEDBUFFER_H
+
+#include "Utilities.h"
+
+#include <string>
+
+namespace rip  {
+
+class MappedBuffer {
+	public:
+		                MappedBuffer  (void);
+		                MappedBuffer  (const MappedBuffer& buffer) = delete;
+		                MappedBuffer  (MappedBuffer&& buffer);
+		               ~MappedBuffer  ();
+
+		MappedBuffer&   operator=     (const MappedBuffer& buffer) = delete;
+		MappedBuffer&   operator=     (MappedBuffer&& buffer);
+
+		bool            create        (ulonglongint bytes,
+		                               const std::string& directory);
+		void            clear         (void);
+		void            release       (ulonglongint offset, ulonglongint bytes);
+
+		void*           data          (void) const { return m_data; }
+		ulonglongint    size          (void) const { return m_size; }
+		bool            empty         (void) const { return m_data == NULL; }
+
+	private:
+		void*           m_data = NULL;
+		ulonglongint    m_size = 0;
+		int             m_file = -1;
+};
+
+} // end rip namespace
+
+#endif /* _MAPPEDBUFFER_H */
+
+
+
@@ -0,0 +1,73 @@
+//
+// Creation Date: Fri Oct 16 23:59:02 PDT 2026
+// Last Modified: Fri Oct 16 23:59:02 PDT 2026
+// Filename:      PerfCounters.h
+// Web Address:
+// Syntax:        C++
+// vim:           ts=3:nowrap:ft=text
+//
+// Description:   Hardware performance counters of the calling thread
+//                (processor cycles, instructions, last-level cache misses,
+//                branch misses and data TLB misses), read with the Linux
+//                perf_event_open() system call.  Only user-space events
+//                are counted.  Each counter is opened on its own, so that
+//                a processor without one of the events still provides the
+//                others.  On other systems, in containers without access
+//                to the performance monitoring unit, or when
+//                /proc/sys/kernel/perf_event_paranoid forbids it, the
+//                counters are unavailable and read as -1.
+//
+
+#ifndef _PERFCOUNTERS_H
+#define _PERFCOUNTERS_H
+
+#include "Utilities.h"
+
+#include <string>
+
+namespace rip  {
+
+// PerfCounterType: the events measured by PerfCounters.
+enum PerfCounterType {
+	PERF_CYCLES        = 0,
+	PERF_INSTRUCTIONS  = 1,
+	PERF_LLC_MISSES    = 2,
+	PERF_BRANCH_MISSES = 3,
+	PERF_DTLB_MISSES   = 4,
+	PERF_COUNTER_COUNT = 5
+};
+
+
+// PerfValues: a reading of all counters (-1 = counter not available).
+class PerfValues {
+	public:
+		longlongint  value[PERF_COUNTER_COUNT] = {-1, -1, -1, -1, -1};
+};
+
+
+class PerfCounters {
+	public:
+		                   PerfCounters       (void);
+		                  ~PerfCounters       ();
+
+		bool               open               (void);
+		void               close              (void);
+		bool               isAvailable        (void) const;
+		const std::string& getError           (void) const { return m_error; }
+		PerfValues         read               (void) const;
+
+		static const char* getCounterName     (int type);
+		static const char* getCounterLabel    (int type);
+
+	private:
+		int          m_fd[PERF_COUNTER_COUNT] = {-1, -1, -1, -1, -1};
+		bool         m_opened = false;
+		std::string  m_error;  // why no counter could be opened
+};
+
+} // end rip namespace
+
+#endif /* _PERFCOUNTERS_H */
+
+
+
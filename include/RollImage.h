@@ -15,6 +15,8 @@
 
 #include <vector>
 #include <fstream>
+#include <map>
+#include <mutex>
 #include <iostream>
 #include <utility>
 #include <string>
@@ -25,10 +27,16 @@
 #endif
 
 #include "TiffFile.h"
+#include "BitPlane.h"
+#include "ImagePlane.h"
+#include "RunLengthPlane.h"
 #include "HoleInfo.h"
 #include "ShiftInfo.h"
 #include "TearInfo.h"
 #include "RollOptions.h"
+#include "ComponentLabeler.h"
+#include "TaskGraph.h"
+#include "StageProfiler.h"
 
 #ifndef DONOTUSEFFT
    #include "MidiFile.h"
@@ -80,6 +88,17 @@ namespace rip  {
 #define PIX_DEBUG7            32    /* debugging pixel type 7 purple                    */
 
 
+// Analysis data read and written by the steps of analyze() (TaskGraph masks):
+#define DATA_PIXELS         (1UL << 0)   /* pixelType, pixelRuns, holeComponents   */
+#define DATA_MARGINS        (1UL << 1)   /* soft and hard margin indexes           */
+#define DATA_LEADER         (1UL << 2)   /* leader indexes, first/last music rows  */
+#define DATA_DRIFT          (1UL << 3)   /* driftCorrection                        */
+#define DATA_HOLES          (1UL << 4)   /* holes, antidust and their HoleInfo     */
+#define DATA_BADHOLES       (1UL << 5)   /* badHoles                               */
+#define DATA_TEARS          (1UL << 6)   /* bassTears, trebleTears                 */
+#define DATA_SHIFTS         (1UL << 7)   /* shifts                                 */
+#define DATA_TRACKER        (1UL << 8)   /* histograms, hole spacing, trackerArray */
+
 typedef unsigned char pixtype;
 
 class RollImage : public TiffFile, public RollOptions {
@@ -87,7 +106,8 @@ class RollImage : public TiffFile, public RollOptions {
 		                 RollImage                    (void);
 		                ~RollImage                    ();
 
-		void	          loadGreenChannel              (int threshold);
+		void	          loadGreenChannel              (int threshold,
+		                                               bool keepMonochrome = true);
 		void            analyze                       (void);
 		void            analyzeHoles                  (void);
 		void            mergePixelOverlay             (std::fstream& output);
@@ -151,14 +171,30 @@ class RollImage : public TiffFile, public RollOptions {
 		void            setWarningOn                  (void);
 		void            setWarningOff                 (void);
 		std::string     getDruid                      (std::string input = "");
+		const std::vector<double>& getSmoothedLeftMargin  (double gain);
+		const std::vector<double>& getSmoothedRightMargin (double gain);
+		void            clearMarginSignals            (void);
+		StageProfiler&  getProfiler                   (void) { return m_profiler; }
+		ulonglongint    getDataBytes                  (ulongint mask);
+		void            addDataCounters               (ulongint mask);
 
 		// pixelType: a bitmask which contains enumerated types for the
 		// functions of pixels (the PIX_* defines above):
-		std::vector<std::vector<pixtype> > pixelType;
+		ImagePlane<pixtype> pixelType;
+
+		// pixelRuns: run-length encoded pixel classes, used instead of
+		// pixelType from loading until analyzeHoles() when
+		// getRunLengthPixels() is true (pixelType is empty until then).
+		RunLengthPlane pixelRuns;
+
+		// paperMask: one bit per pixel, set for PIX_PAPER pixels of the
+		// loaded image (analyze() never changes the class of paper pixels).
+		BitPlane paperMask;
 
 		// monochrome: a monochrome version of the roll image (typically
-		// the green channel):
-		std::vector<std::vector<ucharint> >   monochrome;
+		// the green channel).  Empty if loadGreenChannel() was told not
+		// to keep it:
+		ImagePlane<ucharint> monochrome;
 
 		// leftMarginIndex: The row-by-row margin to the left roll edge:
 		std::vector<int>                  leftMarginIndex;
@@ -199,6 +235,11 @@ class RollImage : public TiffFile, public RollOptions {
 		// antidust: List of holes on roll which are too small to be musical.
 		std::vector<HoleInfo*> antidust;
 
+		// holeComponents -- pixel runs of the holes and antidust found by
+		// analyzeHoles(), used to recolor a hole without flood filling
+		// (see HoleInfo::component).
+		ComponentLabeler holeComponents;
+
 		// trackerArray -- holes sorted by tracker position
 		std::vector<std::vector<HoleInfo*> > trackerArray;
 
@@ -238,6 +279,22 @@ class RollImage : public TiffFile, public RollOptions {
 		void       waterfallUpMargins          (void);
 		void       waterfallLeftMargins        (void);
 		void       waterfallRightMargins       (void);
+		void       getRawMarginRuns            (void);
+		void       waterfallDownMarginRuns     (void);
+		void       waterfallUpMarginRuns       (void);
+		void       waterfallLeftMarginRuns     (void);
+		void       waterfallRightMarginRuns    (void);
+		void       expandPixelRuns             (void);
+		void       floodFillMargins            (void);
+		void       floodFillMarginBand         (ulongint startrow, ulongint endrow);
+		void       fillMarginSpans             (std::vector<ComponentRun>& stack,
+		                                        ulongint startrow, ulongint endrow);
+		ulongint   fillMarginSpan              (ulongint row, ulongint col,
+		                                        std::vector<ComponentRun>& stack);
+		void       floodFillMarginRuns         (void);
+		void       fillMarginRun               (ulongint row, ulongint col,
+		                                        std::vector<ComponentRun>& stack);
+		void       storePaperMask              (void);
 		ulongint   findLeftLeaderBoundary      (std::vector<int>& margin, double avg,
 		                                        ulongint cols, ulongint searchlength);
 		ulongint   findRightLeaderBoundary     (std::vector<int>& margin, double avg,
@@ -252,9 +309,8 @@ class RollImage : public TiffFile, public RollOptions {
 		void       setPreleaderIndex           (ulongint value);
 		void       setLeaderIndex              (ulongint value);
 		void       analyzeHardMargins          (ulongint leaderBoundary);
-		void       fillHoleInfo                (HoleInfo& hi, ulongint r, ulongint c, int& counter);
 		void       fillTearInfo                (TearInfo& ti, ulongint r, ulongint c, int& counter);
-		void       extractHole                 (ulongint row, ulongint col);
+		void       extractHole                 (ComponentLabeler& labeler, ulongint index);
 		void       markPosteriorLeader         (void);
 		void       markHoleBB                  (HoleInfo& hi);
 		double     getTrackerShiftScore        (double shift);
@@ -264,15 +320,10 @@ class RollImage : public TiffFile, public RollOptions {
 		ulongint   findPeak                    (std::vector<double>& array, ulongint r,
 		                                        ulongint& peakindex, double& peakvalue);
 		void       invalidateEdgeHoles         (void);
-		void       fillHoleSimple              (ulongint r, ulongint c, int target, int type, int& counter);
+		void       paintHole                   (HoleInfo& hi, int type);
 		void       clearHole                   (HoleInfo& hi, int type);
 		void       clear                       (void);
 		void       calculateHoleDescriptors    (void);
-		bool       calculateHolePerimeter      (HoleInfo& hole);
-		int        findNextPerimeterPoint      (std::pair<ulongint, ulongint>& point, 
-		                                        int dir);
-		double     calculateCentralMoment      (HoleInfo& hole, int p, int q);
-		double     calculateNormalCentralMoment(HoleInfo& hole, int p, int q);
 		double     calculateMajorAxis          (HoleInfo& hole);
 		void       invalidateSkewedHoles       (void);
 		void       drawMajorAxis               (HoleInfo& hi);
@@ -301,8 +352,23 @@ class RollImage : public TiffFile, public RollOptions {
 		void       storeCorrectedCentroidHistogram(void);
 		void       calculateTrackerSpacings2   (void);
 		string     my_to_string                (int value);
+		const std::vector<double>& getMarginSignal (int side, double gain);
+		void       prepareMarginSignals        (const std::vector<double>& gains);
+		void       updateMarginSignals         (const std::vector<std::pair<int, double> >& keys);
+		void       invalidateMarginSignals     (void);
+		void       refreshMarginSignals        (void);
+		void       releasePixelRows            (ulongint startrow, ulongint count);
+		void       releasePixelBand            (ulongint row, bool upward = false);
 
 	private:
+		// MarginSignal: a margin curve smoothed by smoothSignals(),
+		// which is current while version matches m_marginVersion.
+		class MarginSignal {
+			public:
+				ulongint            version = 0;
+				std::vector<double> values;
+		};
+
 
 //		bool       m_debug                     = false;
 //		bool       m_warning                   = false;
@@ -347,6 +413,30 @@ class RollImage : public TiffFile, public RollOptions {
 		std::vector<double> m_normalizedPosition;
 		std::vector<double> m_trackerShiftScores;
 
+		// m_channelMD5: MD5 checksum of the green channel, calculated while
+		// loading so that monochrome does not need to be kept for it.
+		std::string m_channelMD5;
+
+		// m_marginSignals: smoothed margin curves by side (0 = left,
+		// 1 = right) and gain (see getSmoothedLeftMargin()).
+		std::map<std::pair<int, double>, MarginSignal> m_marginSignals;
+
+		// m_marginVersion: incremented whenever leftMarginIndex or
+		// rightMarginIndex change (see invalidateMarginSignals()).
+		ulongint   m_marginVersion;
+
+		// m_marginSignalLock: steps which read the margin signals may run
+		// at the same time.
+		std::mutex m_marginSignalLock;
+
+		// m_bandRows: rows in each band of the pixel planes when they are
+		// stored in temporary files (0 = planes in memory).  See
+		// RollOptions::setBandMemory().
+		ulongint   m_bandRows;
+
+		// m_profiler: stage measurements (off unless enabled by the caller).
+		StageProfiler m_profiler;
+
 };
 
 } // end rip namespace
@@ -13,6 +13,7 @@
 #ifndef _ROLLOPTIONS_H
 #define _ROLLOPTIONS_H
 
+#include <string>
 #include <utility>
 #include <iostream>
 
@@ -60,10 +61,25 @@ class RollOptions {
 
 		double   getBridgeFactor              (void);
 		int      getExpectedTrackerHoleCount  (void);
+		double   getTrackerHolesPerInch       (void);
 		void     setThreshold                 (int value);
 		int      getThreshold                 (void);
+		void     setThreadCount               (int value);
+		int      getThreadCount               (void);
+		void     setRunLengthPixels           (bool value);
+		bool     getRunLengthPixels           (void);
+		void     setMarginFloodFill           (bool value);
+		bool     getMarginFloodFill           (void);
+		void     setSmoothingMode             (int value);
+		int      getSmoothingMode             (void);
+		void     setBandMemory                (ulonglongint bytes);
+		ulonglongint getBandMemory            (void);
+		void     setScratchDirectory          (const std::string& directory);
+		const std::string& getScratchDirectory (void);
 
 	protected: // (maybe make private, but will have to create accessor functions)
+		void     setGreenWelteLayout          (void);
+
 		// m_minTrackerSpacingToPaperEdge: minimum distance from paper
 		// edge to first tracker line on the roll.  The units are in terms
 		// of spacing between tracker lines.
@@ -127,6 +143,9 @@ class RollOptions {
 		// m_trackerHoles == number of holes in the tracker bar
 		int m_trackerHoles = 0;
 
+		// m_trackerHolesPerInch == spacing of the tracker bar holes.
+		double m_trackerHolesPerInch = 0.0;
+
 		// m_bass_midi == first MIDI note/expression hole on bass side of paper.
 		int m_bass_midi = 0;
 
@@ -151,6 +170,31 @@ class RollOptions {
 		// m_threshold: brightness threshold (0-255) for separation of paper and non-paper.
 		int m_threshold        = 249;
 
+		// m_threadCount: number of threads for parallel analysis steps
+		// (0 = the shared ThreadPool count, 1 = no extra threads).
+		int m_threadCount      = 0;
+
+		// m_runLengthPixels: store pixel classes as runs (instead of one
+		// byte per pixel) from loading until hole extraction.
+		bool m_runLengthPixels = false;
+
+		// m_marginFloodFill: find the margins with a flood fill from the
+		// image edges instead of the directional waterfall passes.
+		bool m_marginFloodFill = false;
+
+		// m_smoothingMode: how the margin curves are smoothed (see
+		// SmoothingMode in Smoothing.h; 0 = exact).
+		int m_smoothingMode    = 0;
+
+		// m_bandMemory: memory budget in bytes for the pixel planes, which
+		// are then kept in temporary files and processed in bands of rows
+		// (0 = keep the full planes in memory).
+		ulonglongint m_bandMemory = 0;
+
+		// m_scratchDirectory: directory for the temporary files of the
+		// pixel planes (empty = $TMPDIR or /tmp).
+		std::string m_scratchDirectory;
+
 		// m_tempo_additive_acceleration_per_foot: the roll acceleration emulation.  This
 		// is the amount added to the tempo BPM for after each foot of the roll.  Value of
 		// 0.22 is from Wayne Stankhe.  The tempo is always starting at "60" and the value
@@ -0,0 +1,178 @@
+//
+// Creation Date: Fri Oct 16 23:12:08 PDT 2026
+// Last Modified: Fri Oct 16 23:12:08 PDT 2026
+// Filename:      RollSynthesizer.h
+// Web Address:
+// Syntax:        C++
+// vim:           ts=3:nowrap:ft=text
+//
+// Description:   Generate synthetic piano-roll images with a known list of
+//                holes, tears and shifts.  The tracker-bar layout comes from
+//                the RollOptions roll type, and the roll is built from a
+//                random seed so that the same settings always produce the
+//                same image.  The image is written as an uncompressed RGB
+//                TIFF (or BigTIFF), and the ground truth in ATON format.
+//
+
+#ifndef _ROLLSYNTHESIZER_H
+#define _ROLLSYNTHESIZER_H
+
+#include "RollOptions.h"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace rip  {
+
+// SynthHole: a punched hole in the synthetic roll.
+class SynthHole {
+	public:
+		ulongint    row      = 0;     // first row of the hole
+		ulongint    length   = 0;     // number of rows
+		double      col      = 0.0;   // center column at the first row
+		double      width    = 0.0;   // width in columns
+		int         position = 0;     // tracker-bar position (1 = bass edge)
+		int         midi     = 0;     // MIDI key of the tracker-bar position
+		ulongint    note     = 0;     // holes of a bridged chain share a note
+		ulongint    offtime  = 0;     // end row of the note (the last chained hole)
+		bool        attack   = true;  // first hole of its note
+		bool        rewind   = false; // rewind hole at the end of the roll
+};
+
+
+// SynthTear: a triangular tear into the bass or treble edge of the paper.
+class SynthTear {
+	public:
+		ulongint    row      = 0;     // first row of the tear
+		ulongint    length   = 0;     // number of rows
+		double      depth    = 0.0;   // columns into the paper at the middle
+		bool        treble   = false; // false = bass edge
+};
+
+
+// SynthShift: a sideways step of the paper made by the operator.
+class SynthShift {
+	public:
+		ulongint    row      = 0;     // first row of the movement
+		ulongint    length   = 0;     // rows over which the paper moves
+		double      amount   = 0.0;   // columns (positive = towards treble)
+};
+
+
+// SynthDust: a bright speck on the paper or a dark speck in the margin.
+class SynthDust {
+	public:
+		ulongint    row      = 0;
+		ulongint    col      = 0;
+		ulongint    size     = 0;     // square size in pixels
+		bool        dark     = false;
+};
+
+
+class RollSynthesizer : public RollOptions {
+	public:
+		                   RollSynthesizer   (void);
+		                  ~RollSynthesizer   ();
+
+		bool               setRollType       (const std::string& type);
+		void               setDpi            (double value);
+		double             getDpi            (void) const { return m_dpi; }
+		void               setLength         (double feet);
+		void               setRows           (ulongint value);
+		void               setHoleDensity    (double value);
+		void               setHoleWidth      (double value);
+		void               setBridgeRate     (double value);
+		void               setDrift          (double inches);
+		void               setShiftCount     (int value);
+		void               setTearCount      (int value);
+		void               setDustRate       (double perfoot);
+		void               setLeader         (double inches);
+		void               setPreleader      (double inches);
+		void               setSeed           (ulonglongint value);
+		void               setBigTiff        (bool value);
+
+		bool               generate          (void);
+		ulongint           getRows           (void) const { return m_rows; }
+		ulongint           getCols           (void) const { return m_cols; }
+		void               renderRow         (ulongint row,
+		                                      std::vector<ucharint>& rgb) const;
+		bool               writeTiff         (const std::string& filename);
+
+		const std::vector<SynthHole>&  getHoles  (void) const { return m_holes; }
+		const std::vector<SynthTear>&  getTears  (void) const { return m_tears; }
+		const std::vector<SynthShift>& getShifts (void) const { return m_shifts; }
+		ulongint           getNoteCount      (void) const { return m_notes; }
+
+		std::ostream&      printTruth        (std::ostream& out);
+		bool               writeTruth        (const std::string& filename);
+
+	protected:
+		double             getRandom         (void);
+		double             getRandom         (double low, double high);
+		double             getOffset         (ulongint row) const;
+		void               getPaperEdges     (ulongint row, double& left,
+		                                      double& right) const;
+		void               getHoleColumns    (double center, long& first,
+		                                      long& last) const;
+		bool               isPunchable       (int position);
+		void               makeHoles         (void);
+		void               makeTears         (void);
+		void               makeShifts        (void);
+		void               makeDust          (void);
+		void               writeTiffHeader   (std::ostream& out, bool bigtiff);
+
+	private:
+		// Settings:
+		double       m_dpi         = 300.0;  // pixels per inch in both directions
+		double       m_feet        = 6.0;    // roll length when m_rows is not set
+		ulongint     m_setRows     = 0;      // explicit image length
+		double       m_density     = 0.25;   // fraction of music rows punched per track
+		double       m_holeWidth   = 0.0;    // fraction of spacing (0 = roll default)
+		double       m_bridgeRate  = 0.2;    // fraction of notes made of chained holes
+		double       m_drift       = 0.02;   // inches of slow sideways drift
+		int          m_shiftCount  = 2;
+		int          m_tearCount   = 2;
+		double       m_dustRate    = 10.0;   // specks per foot
+		double       m_leader      = 7.0;    // inches of tapered leader
+		double       m_preleader   = 1.0;    // inches of narrow strap before the leader
+		ulonglongint m_seed        = 1;
+		bool         m_bigTiff     = false;
+
+		// Layout (computed by generate()):
+		bool         m_generated   = false;
+		ulongint     m_rows        = 0;
+		ulongint     m_cols        = 0;
+		double       m_spacing     = 0.0;    // columns between tracker-bar holes
+		double       m_paperLeft   = 0.0;    // bass edge of the paper without drift
+		double       m_paperWidth  = 0.0;
+		double       m_firstTrack  = 0.0;    // column of tracker position 1
+		double       m_punchWidth  = 0.0;    // hole width in columns
+		double       m_driftPhase  = 0.0;
+		ulongint     m_preleaderRow = 0;
+		ulongint     m_leaderRow   = 0;
+		ulongint     m_firstHole   = 0;
+		ulongint     m_lastHole    = 0;
+		ulongint     m_notes       = 0;
+
+		std::vector<SynthHole>  m_holes;     // sorted by starting row
+		std::vector<SynthTear>  m_tears;
+		std::vector<SynthShift> m_shifts;
+		std::vector<SynthDust>  m_dust;      // sorted by row
+
+		// m_trackHoles: indexes into m_holes for each tracker position.
+		std::vector<std::vector<ulongint>> m_trackHoles;
+
+		// m_texture: paper brightness noise, read at an offset for each row.
+		std::vector<ucharint> m_texture;
+
+		std::mt19937_64 m_random;
+};
+
+} // end rip namespace
+
+#endif /* _ROLLSYNTHESIZER_H */
+
+
+
@@ -0,0 +1,104 @@
+//
+// Creation Date: Fri Oct 16 15:08:52 PDT 2026
+// Last Modified: Fri Oct 16 15:08:52 PDT 2026
+// Filename:      RunLengthPlane.h
+// Web Address:
+// Syntax:        C++
+// vim:           ts=3:nowrap:ft=text
+//
+// Description:   Run-length encoded image plane for pixel classes.  Each
+//                row is stored as a list of runs of equal values, which
+//                is much smaller than one byte per pixel since most of a
+//                roll image is paper.  Scans and replacements work on
+//                whole runs rather than on individual pixels.
+//
+
+#ifndef _RUNLENGTHPLANE_H
+#define _RUNLENGTHPLANE_H
+
+#include "ImagePlane.h"
+
+#include <utility>
+#include <vector>
+
+namespace rip  {
+
+// PixelRun: a run of pixels with the same value, starting at column
+// start and ending at the start of the next run in the row (or at the
+// end of the row for the last run).
+class PixelRun {
+	public:
+		unsigned int start;
+		ucharint     value;
+};
+
+// ColumnSpan: columns [first, second) of a row.
+typedef std::pair<ulongint, ulongint> ColumnSpan;
+
+
+class RunLengthPlane {
+	public:
+		                   RunLengthPlane     (void);
+		                  ~RunLengthPlane     ();
+
+		void               resize             (ulongint rows, ulongint cols,
+		                                       ucharint value = 0);
+		void               clear              (void);
+		ulongint           getRows            (void) const { return m_rows.size(); }
+		ulongint           getCols            (void) const { return m_cols; }
+		bool               empty              (void) const { return m_rows.empty(); }
+
+		void               encodeRow          (ulongint row, const ucharint* pixels);
+		void               decodeRow          (ulongint row, ucharint* pixels) const;
+		void               releaseRow         (ulongint row);
+		void               expandTo           (ImagePlane<ucharint>& plane);
+
+		const std::vector<PixelRun>& getRuns  (ulongint row) const { return m_rows[row]; }
+		ulongint           getRunEnd          (ulongint row, ulongint index) const;
+		ucharint           getValue           (ulongint row, ulongint col) const;
+		ulongint           getRunCount        (void) const;
+		ulongint           getMemorySize      (void) const;
+
+		long               findValue          (ulongint row, ulongint startcol,
+		                                       ucharint value) const;
+		long               findValueReverse   (ulongint row, ulongint startcol,
+		                                       ucharint value) const;
+		ulongint           countValues        (ulongint row, ulongint startcol,
+		                                       ulongint endcol, ucharint lowest,
+		                                       ucharint highest) const;
+		void               replaceValues      (ulongint row, ulongint startcol,
+		                                       ulongint endcol, ucharint lowest,
+		                                       ucharint highest, ucharint value);
+
+		void               spreadValue        (ulongint fromrow, ulongint torow,
+		                                       ucharint value, ucharint barrier,
+		                                       std::vector<ColumnSpan>& spans);
+		void               spreadValueRight   (ulongint row, ucharint value,
+		                                       ucharint barrier,
+		                                       std::vector<ColumnSpan>& spans);
+		void               spreadValueLeft    (ulongint row, ucharint value,
+		                                       ucharint barrier,
+		                                       std::vector<ColumnSpan>& spans);
+
+	protected:
+		void               setSpans           (ulongint row,
+		                                       const std::vector<ColumnSpan>& spans,
+		                                       ucharint value);
+		static void        appendRun          (std::vector<PixelRun>& runs,
+		                                       ulongint start, ucharint value);
+
+	private:
+		// m_rows: the runs of each row, in column order.  Adjacent runs
+		// always have different values.
+		std::vector<std::vector<PixelRun> > m_rows;
+
+		// m_cols: the number of columns in each row.
+		ulongint m_cols = 0;
+};
+
+} // end rip namespace
+
+#endif /* _RUNLENGTHPLANE_H */
+
+
+
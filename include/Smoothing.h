@@ -0,0 +1,54 @@
+//
+// Creation Date: Fri Oct 16 20:31:18 PDT 2026
+// Last Modified: Fri Oct 16 20:31:18 PDT 2026
+// Filename:      Smoothing.h
+// Web Address:
+// Syntax:        C++
+// vim:           ts=3:nowrap:ft=text
+//
+// Description:   Engine for the bidirectional first-order IIR filter of
+//                exponentialSmoothing().  Several signals (such as the
+//                left and right margins at several gains) are filtered at
+//                once, one signal per SIMD lane, which gives the same
+//                result as filtering them one at a time.  Long signals
+//                can also be filtered in blocks on the shared ThreadPool,
+//                and single-precision and fixed-point versions are
+//                available when the last bits of the result do not matter.
+//
+
+#ifndef _SMOOTHING_H
+#define _SMOOTHING_H
+
+#include "Utilities.h"
+
+#include <string>
+#include <vector>
+
+namespace rip  {
+
+// SmoothingMode: how smoothSignals() filters the signals.
+enum SmoothingMode {
+	SMOOTH_EXACT  = 0,  // double precision, identical to exponentialSmoothing()
+	SMOOTH_BLOCKS = 1,  // double precision, blocks filtered in parallel
+	SMOOTH_FLOAT  = 2,  // single precision
+	SMOOTH_FIXED  = 3   // 16.16 fixed point
+};
+
+void           smoothSignals              (std::vector<std::vector<double>*>& signals,
+                                           const std::vector<double>& gains,
+                                           int mode = SMOOTH_EXACT);
+void           exponentialSmoothingLanes  (std::vector<std::vector<double>*>& signals,
+                                           const std::vector<double>& gains);
+void           exponentialSmoothingBlocks (std::vector<double>& signal, double gain,
+                                           ulongint blocksize = 65536);
+void           exponentialSmoothingFloat  (std::vector<double>& signal, double gain);
+void           exponentialSmoothingFixed  (std::vector<double>& signal, double gain);
+int            findSmoothingMode          (const std::string& name);
+const char*    getSmoothingModeName       (int mode);
+
+} // end rip namespace
+
+#endif /* _SMOOTHING_H */
+
+
+
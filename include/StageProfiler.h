@@ -0,0 +1,150 @@
+//
+// Creation Date: Fri Oct 16 22:05:41 PDT 2026
+// Last Modified: Fri Oct 16 22:05:41 PDT 2026
+// Filename:      StageProfiler.h
+// Web Address:
+// Syntax:        C++
+// vim:           ts=3:nowrap:ft=text
+//
+// Description:   Timing and memory measurements of processing stages.  A
+//                ScopedStage object measures the code in its scope: wall
+//                time, processor time, the increase of the peak resident
+//                memory, and an estimate of the bytes of data read or
+//                written (given by the caller).  Stages may be nested and
+//                may run at the same time on several threads.  The records
+//                can be printed as an ATON PROFILE section, as JSON, or
+//                as a Chrome/Perfetto trace (with counters such as the
+//                number of holes found over time).  Optionally the
+//                hardware performance counters of the thread which runs
+//                each stage are recorded as well (see PerfCounters).
+//
+
+#ifndef _STAGEPROFILER_H
+#define _STAGEPROFILER_H
+
+#include "PerfCounters.h"
+#include "Utilities.h"
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rip  {
+
+// StageRecord: measurements of one run of a stage.
+class StageRecord {
+	public:
+		std::string  name;
+		ulongint     depth        = 0;    // nesting level on its thread
+		ulongint     thread       = 0;    // 0 = first thread seen, 1 = next...
+		double       startTime    = 0.0;  // seconds since the profiler started
+		double       wallTime     = 0.0;  // seconds
+		double       cpuTime      = 0.0;  // process CPU seconds
+		longlongint  peakRssDelta = 0;    // bytes added to the peak RSS
+		ulonglongint bytes        = 0;    // estimated bytes touched
+		PerfValues   counters;            // events on the stage's thread (-1 = none)
+		bool         finished     = false;
+};
+
+
+// CounterRecord: value of a named counter at a time.
+class CounterRecord {
+	public:
+		std::string  name;
+		double       time   = 0.0;  // seconds since the profiler started
+		double       value  = 0.0;
+};
+
+
+class StageProfiler {
+	public:
+		                   StageProfiler      (void);
+		                  ~StageProfiler      ();
+
+		void               setEnabled         (bool value);
+		bool               isEnabled          (void) const { return m_enabled; }
+		void               setHardwareCounters (bool value);
+		bool               getHardwareCounters (void) const { return m_hardware; }
+		std::string        getHardwareCounterStatus (void);
+		void               clear              (void);
+
+		ulongint           beginStage         (const std::string& name,
+		                                       ulonglongint bytes = 0);
+		void               endStage           (ulongint index,
+		                                       ulonglongint bytes = 0);
+		std::vector<StageRecord> getRecords   (void);
+		void               addCounter         (const std::string& name,
+		                                       double value);
+
+		std::ostream&      printChromeTrace   (std::ostream& out);
+		bool               writeChromeTrace   (const std::string& filename);
+
+		std::ostream&      printAton          (std::ostream& out);
+		std::ostream&      printJson          (std::ostream& out);
+		bool               writeJson          (const std::string& filename);
+
+		static double      getCpuTime         (void);
+		static longlongint getPeakRss         (void);
+
+	protected:
+		ulongint           getThreadIndex     (void);
+		PerfValues         readHardwareCounters (void);
+		double             getElapsed         (void) const;
+
+	private:
+		bool m_enabled = false;
+		bool m_hardware = false;
+
+		// m_hardwareError: why the counters of a thread could not be opened.
+		std::string m_hardwareError;
+		bool        m_hardwareOpened = false;
+
+		// m_records: the stages in the order that they were started.
+		std::vector<StageRecord> m_records;
+
+		// Values at the start of each record (by record index):
+		std::vector<double>      m_startCpu;
+		std::vector<longlongint> m_startRss;
+		std::vector<PerfValues>  m_startCounters;
+
+		// m_counters: values given to addCounter() in time order.
+		std::vector<CounterRecord> m_counters;
+
+		// m_threads: small numbers for the threads which ran stages.
+		std::map<std::thread::id, ulongint> m_threads;
+
+		std::chrono::steady_clock::time_point m_origin;
+		std::mutex m_lock;
+};
+
+
+
+// ScopedStage: measure a stage from construction to destruction (does
+// nothing if the profiler is not enabled).
+
+class ScopedStage {
+	public:
+		                   ScopedStage        (StageProfiler& profiler,
+		                                       const std::string& name,
+		                                       ulonglongint bytes = 0);
+		                  ~ScopedStage        ();
+
+		void               addBytes           (ulonglongint bytes) { m_bytes += bytes; }
+
+	private:
+		StageProfiler& m_profiler;
+		ulongint       m_index;
+		ulonglongint   m_bytes = 0;
+		bool           m_active;
+};
+
+} // end rip namespace
+
+#endif /* _STAGEPROFILER_H */
+
+
+
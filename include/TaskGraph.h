@@ -0,0 +1,83 @@
+//
+// Creation Date: Fri Oct 16 18:02:36 PDT 2026
+// Last Modified: Fri Oct 16 18:02:36 PDT 2026
+// Filename:      TaskGraph.h
+// Web Address:
+// Syntax:        C++
+// vim:           ts=3:nowrap:ft=text
+//
+// Description:   Dependency graph of processing steps.  Each task declares
+//                the data it reads and writes as bitmasks, and a task
+//                depends on every earlier task which writes data that it
+//                uses, or which uses data that it writes.  Tasks with no
+//                conflicts can then run at the same time on several
+//                threads, while the results stay the same as running the
+//                tasks one after another in the order they were added.
+//                Tasks are run on the shared ThreadPool.
+//
+
+#ifndef _TASKGRAPH_H
+#define _TASKGRAPH_H
+
+#include "Utilities.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace rip  {
+
+class ThreadPool;
+
+// TASK_ALL: data mask for a task which must run by itself.
+#define TASK_ALL  (~0UL)
+
+class TaskGraph {
+	public:
+		                   TaskGraph          (void);
+		                  ~TaskGraph          ();
+
+		void               clear              (void);
+		ulongint           addTask            (const std::string& name,
+		                                       std::function<void(void)> function,
+		                                       ulongint reads, ulongint writes);
+		ulongint           addBarrier         (const std::string& name,
+		                                       std::function<void(void)> function);
+		ulongint           getTaskCount       (void) const { return m_tasks.size(); }
+		const std::string& getTaskName        (ulongint index) const;
+		const std::vector<ulongint>& getDependencies (ulongint index) const;
+
+		void               setThreadCount     (int count);
+		int                getThreadCount     (void) const;
+		void               run                (void);
+
+	protected:
+		class Task {
+			public:
+				std::string               name;
+				std::function<void(void)> function;
+				ulongint                  reads;
+				ulongint                  writes;
+				std::vector<ulongint>     dependencies;  // earlier tasks
+				std::vector<ulongint>     dependents;    // later tasks
+		};
+
+		void               runSerial          (void);
+		void               runParallel        (ThreadPool& pool);
+
+	private:
+		// m_tasks: the tasks in the order that they were added (which is
+		// also the order in which they are run by a single thread).
+		std::vector<Task> m_tasks;
+
+		// m_threadCount: number of threads to run tasks on (0 = the thread
+		// count of the shared ThreadPool).
+		int m_threadCount = 1;
+};
+
+} // end rip namespace
+
+#endif /* _TASKGRAPH_H */
+
+
+
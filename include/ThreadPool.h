@@ -0,0 +1,143 @@
+//
+// Creation Date: Fri Oct 16 19:14:52 PDT 2026
+// Last Modified: Fri Oct 16 19:14:52 PDT 2026
+// Filename:      ThreadPool.h
+// Web Address:
+// Syntax:        C++
+// vim:           ts=3:nowrap:ft=text
+//
+// Description:   Work-stealing thread pool shared by the library.  Each
+//                worker thread has its own queue of tasks; it takes new
+//                work from the back of its own queue and steals from the
+//                front of the other queues when its own is empty.  Threads
+//                which wait for a TaskGroup run queued tasks while waiting,
+//                so tasks may start other tasks without deadlocking (a
+//                waiting thread only runs tasks of the group it waits
+//                for, so a task which holds a lock while waiting cannot
+//                pick up an unrelated task that needs the same lock).  A
+//                pool with a thread count of 1 has no worker threads and
+//                runs everything inline on the calling thread (useful for
+//                debugging).
+//
+
+#ifndef _THREADPOOL_H
+#define _THREADPOOL_H
+
+#include "Utilities.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rip  {
+
+class TaskGroup;
+
+// ThreadPoolStatistics: counts of the work done by a pool.
+class ThreadPoolStatistics {
+	public:
+		ulongint threads;      // thread count (including the calling thread)
+		ulongint tasks;        // tasks run by the pool
+		ulongint steals;       // tasks taken from another thread's queue
+		ulongint inlineTasks;  // tasks run inline because there are no workers
+		ulongint loops;        // calls to parallelFor()
+};
+
+
+class ThreadPool {
+	public:
+		                   ThreadPool         (int count = 0);
+		                  ~ThreadPool         ();
+
+		static ThreadPool& getShared          (void);
+		static int         getDefaultThreadCount (void);
+
+		void               setThreadCount     (int count);
+		int                getThreadCount     (void) const;
+		void               parallelFor        (ulongint start, ulongint end,
+		                                       ulongint grain,
+		                                       const std::function<void(ulongint, ulongint)>& function);
+		void               parallelForEach    (ulongint count,
+		                                       const std::function<void(ulongint)>& function,
+		                                       ulongint grain = 1);
+
+		ThreadPoolStatistics getStatistics    (void) const;
+		void               resetStatistics    (void);
+
+	protected:
+		friend class TaskGroup;
+
+		class Task {
+			public:
+				std::function<void(void)> function;
+				TaskGroup*                group;
+		};
+
+		class Queue {
+			public:
+				std::mutex       lock;
+				std::deque<Task> tasks;
+		};
+
+		void               submit             (Task&& task);
+		bool               runOneTask         (const TaskGroup* group = NULL);
+		bool               popTask            (Task& task, const TaskGroup* group);
+		void               runTask            (Task& task);
+		void               workerLoop         (ulongint index);
+		void               startWorkers       (ulongint count);
+		void               stopWorkers        (void);
+		bool               hasWorkers         (void) const { return !m_workers.empty(); }
+
+	private:
+		// m_queues: task queues.  Queue 0 is used by threads which are not
+		// workers of the pool, and queue i by worker i.
+		std::vector<std::unique_ptr<Queue> > m_queues;
+
+		// m_workers: the worker threads.
+		std::vector<std::thread> m_workers;
+
+		// Idle workers sleep on m_wakeup until m_queued is non-zero.
+		std::mutex              m_sleepLock;
+		std::condition_variable m_wakeup;
+		std::atomic<ulongint>   m_queued;
+		bool                    m_stop = false;
+
+		// Statistics:
+		std::atomic<ulongint>   m_tasks;
+		std::atomic<ulongint>   m_steals;
+		std::atomic<ulongint>   m_inlineTasks;
+		std::atomic<ulongint>   m_loops;
+};
+
+
+
+// TaskGroup: set of tasks run on a pool which can be waited for together.
+
+class TaskGroup {
+	public:
+		                   TaskGroup          (ThreadPool& pool = ThreadPool::getShared());
+		                  ~TaskGroup          ();
+
+		void               run                (std::function<void(void)> function);
+		void               wait               (void);
+
+	protected:
+		friend class ThreadPool;
+		void               finishTask         (void);
+
+	private:
+		ThreadPool&           m_pool;
+		std::atomic<ulongint> m_pending;
+};
+
+} // end rip namespace
+
+#endif /* _THREADPOOL_H */
+
+
+
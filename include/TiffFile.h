@@ -21,6 +21,7 @@
 #include <vector>
 
 #include "TiffHeader.h"
+#include "ImagePlane.h"
 
 namespace rip  {
 
@@ -37,7 +38,14 @@ class TiffFile : public std::fstream, public TiffHeader {
 		std::string readString                  (ulongint count);
 		ucharint    read1UByte                  (void);
 		void        getImageGreenChannel        (std::vector<std::vector<ucharint> >& image);
+		void        getImageGreenChannel        (ImagePlane<ucharint>& image);
 		bool        goToPixelIndex              (ulonglongint pindex);
+		bool        mapPixelData                (void);
+		void        allowPixelMapping           (bool state = true);
+		void        unmapPixelData              (void);
+		bool        isPixelDataMapped           (void) const;
+		const ucharint* getRowPixels            (ulongint rowindex);
+		void        releaseRowPixels            (ulongint startrow, ulongint count);
 		bool        goToRowColumnIndex          (ulongint rowindex, ulongint colindex);
 		std::string getFilename                 (void);
 
@@ -49,6 +57,23 @@ class TiffFile : public std::fstream, public TiffHeader {
 		std::string m_filename;
 		// std::fstream m_input;
 
+		// m_mapbase: start of the memory-mapped file (NULL if not mapped).
+		ucharint*     m_mapbase    = NULL;
+
+		// m_maplength: byte size of the memory-mapped region.
+		ulonglongint  m_maplength  = 0;
+
+		// m_mapfailed: true if mapping was tried but not possible, in
+		// which case rows are read into m_rowbuffer instead.
+		bool          m_mapfailed  = false;
+
+		// m_allowMapping: false to always read rows from the file stream
+		// (for comparing the two ways of reading).
+		bool          m_allowMapping = true;
+
+		// m_rowbuffer: storage for one row when the file is not mapped.
+		std::vector<ucharint> m_rowbuffer;
+
 };
 
 } // end rip namespace
@@ -56,10 +56,35 @@ int            getMaximum                 (std::vector<int>& array, ulongint sta
                                            ulongint length = 0);
 ulongint       maxValueIndex              (std::vector<ulongint> array);
 void           exponentialSmoothing       (std::vector<double>& array, double gain);
+double         getSpectralMagnitude       (const std::vector<double>& signal,
+                                           double frequency);
+double         findSpectralPeak           (const std::vector<double>& signal,
+                                           double lowfreq, double highfreq,
+                                           double tolerance);
 bool           goToByteIndex              (std::fstream& file, ulonglongint offset);
 
+// Pixel kernels (vectorized with runtime CPU dispatch):
+enum SimdLevel {
+	SIMD_SCALAR = 0,  // portable C++ loop
+	SIMD_SSSE3  = 1,  // 16 pixels per iteration (pshufb)
+	SIMD_AVX2   = 2,  // 32 pixels per iteration
+	SIMD_AVX512 = 3   // 64 pixels per iteration (AVX-512BW)
+};
+void           extractRgbChannel          (ucharint* output, const ucharint* rgb,
+                                           ulongint count, int channel);
+void           extractGreenChannel        (ucharint* output, const ucharint* rgb,
+                                           ulongint count);
+void           markAboveThreshold         (ucharint* output, const ucharint* input,
+                                           ulongint count, ucharint threshold);
+void           packBelowThreshold         (ulonglongint* output, const ucharint* input,
+                                           ulongint count, ucharint threshold);
+int            getSimdLevel               (void);
+int            getMaxSimdLevel            (void);
+int            setSimdLevel               (int level);
+const char*    getSimdLevelName           (int level);
+
 template <class TYPE>
-double         getAverage                 (std::vector<TYPE>& array, ulongint startindex = 0,
+double         getAverage                 (const std::vector<TYPE>& array, ulongint startindex = 0,
                                            ulongint length = 0);
 
 
@@ -74,7 +99,7 @@ double         getAverage                 (std::vector<TYPE>& array, ulongint st
 //
 
 template <class TYPE>
-double getAverage(std::vector<TYPE>& array, ulongint startindex, ulongint length) {
+double getAverage(const std::vector<TYPE>& array, ulongint startindex, ulongint length) {
 	ulongint stopindex = array.size() - 1;
 	if (length > 0) {
 		stopindex = startindex + length - 1;
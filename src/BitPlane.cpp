@@ -0,0 +1,204 @@
+//
+// Creation Date: Fri Oct 16 16:21:07 PDT 2026
+// Last Modified: Fri Oct 16 16:21:07 PDT 2026
+// Filename:      BitPlane.cpp
+// Web Address:
+// Syntax:        C++
+// vim:           ts=3:nowrap:ft=text
+//
+// Description:   Two-dimensional mask with one bit per pixel.
+//
+
+#include "BitPlane.h"
+
+using namespace std;
+
+namespace rip  {
+
+
+//////////////////////////////
+//
+// BitPlane::BitPlane -- Constructor.
+//
+
+BitPlane::BitPlane(void) {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// BitPlane::~BitPlane -- Destructor.
+//
+
+BitPlane::~BitPlane() {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// BitPlane::resize -- Allocate the mask with all bits cleared.
+//
+
+void BitPlane::resize(ulongint rows, ulongint cols) {
+	m_words.clear();
+	m_words.shrink_to_fit();
+	m_rows   = rows;
+	m_cols   = cols;
+	m_stride = (cols + 63) / 64;
+	m_words.resize(rows * m_stride, 0);
+}
+
+
+
+//////////////////////////////
+//
+// BitPlane::clear -- Release the memory for the mask.
+//
+
+void BitPlane::clear(void) {
+	m_words.clear();
+	m_words.shrink_to_fit();
+	m_rows   = 0;
+	m_cols   = 0;
+	m_stride = 0;
+}
+
+
+
+//////////////////////////////
+//
+// BitPlane::getBit -- Return the bit for a single pixel.
+//
+
+bool BitPlane::getBit(ulongint row, ulongint col) const {
+	return (getRow(row)[col / 64] >> (col % 64)) & 1;
+}
+
+
+
+//////////////////////////////
+//
+// BitPlane::findSet -- Return the first column at or after startcol
+//    which has its bit set, or -1 if there is none.
+//
+
+long BitPlane::findSet(ulongint row, ulongint startcol) const {
+	if (startcol >= m_cols) {
+		return -1;
+	}
+	const ulonglongint* words = getRow(row);
+	ulongint w = startcol / 64;
+	ulonglongint word = words[w] & (~0ULL << (startcol % 64));
+	while (word == 0) {
+		if (++w >= m_stride) {
+			return -1;
+		}
+		word = words[w];
+	}
+	return (long)(w * 64 + __builtin_ctzll(word));
+}
+
+
+
+//////////////////////////////
+//
+// BitPlane::findSetReverse -- Return the last column at or before
+//    startcol which has its bit set, or -1 if there is none.
+//
+
+long BitPlane::findSetReverse(ulongint row, ulongint startcol) const {
+	if (m_cols == 0) {
+		return -1;
+	}
+	if (startcol >= m_cols) {
+		startcol = m_cols - 1;
+	}
+	const ulonglongint* words = getRow(row);
+	ulongint w = startcol / 64;
+	ulonglongint word = words[w] & (~0ULL >> (63 - startcol % 64));
+	while (word == 0) {
+		if (w-- == 0) {
+			return -1;
+		}
+		word = words[w];
+	}
+	return (long)(w * 64 + 63 - __builtin_clzll(word));
+}
+
+
+
+//////////////////////////////
+//
+// BitPlane::findClear -- Return the first column at or after startcol
+//    which has its bit cleared, or -1 if there is none.
+//
+
+long BitPlane::findClear(ulongint row, ulongint startcol) const {
+	if (startcol >= m_cols) {
+		return -1;
+	}
+	const ulonglongint* words = getRow(row);
+	ulongint w = startcol / 64;
+	ulonglongint word = ~words[w] & (~0ULL << (startcol % 64));
+	while (word == 0) {
+		if (++w >= m_stride) {
+			return -1;
+		}
+		word = ~words[w];
+	}
+	ulongint col = w * 64 + __builtin_ctzll(word);
+	// bits past the end of the row are zero, but are not pixels:
+	return col < m_cols ? (long)col : -1;
+}
+
+
+
+//////////////////////////////
+//
+// BitPlane::countSet -- Return the number of set bits in columns
+//    [startcol, endcol) of a row.
+//
+
+ulongint BitPlane::countSet(ulongint row, ulongint startcol, ulongint endcol) const {
+	if (endcol > m_cols) {
+		endcol = m_cols;
+	}
+	if (startcol >= endcol) {
+		return 0;
+	}
+	const ulonglongint* words = getRow(row);
+	ulongint first = startcol / 64;
+	ulongint last  = (endcol - 1) / 64;
+	ulonglongint startmask = ~0ULL << (startcol % 64);
+	ulonglongint endmask   = ~0ULL >> (63 - (endcol - 1) % 64);
+	if (first == last) {
+		return __builtin_popcountll(words[first] & startmask & endmask);
+	}
+	ulongint count = __builtin_popcountll(words[first] & startmask);
+	for (ulongint w=first+1; w<last; w++) {
+		count += __builtin_popcountll(words[w]);
+	}
+	count += __builtin_popcountll(words[last] & endmask);
+	return count;
+}
+
+
+
+//////////////////////////////
+//
+// BitPlane::getMemorySize -- Return the number of bytes used for the bits.
+//
+
+ulongint BitPlane::getMemorySize(void) const {
+	return m_words.capacity() * sizeof(ulonglongint);
+}
+
+
+} // end rip namespace
+
+
+
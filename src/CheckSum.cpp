@@ -481,6 +481,72 @@ string CheckSum::getMD5Sum(vector<vector<unsigned char> >& data) {
 
 
 
+//////////////////////////////
+//
+// CheckSum::getMD5Sum -- Checksum of the pixels of an image plane, row
+//    by row (padding at the ends of rows is not included).
+//
+
+string CheckSum::getMD5Sum(const rip::ImagePlane<unsigned char>& data) {
+	startMD5Sum();
+	for (rip::ulongint r=0; r<data.getRows(); r++) {
+		addToMD5Sum(data.getRow(r), data.getCols());
+	}
+	return finishMD5Sum();
+}
+
+
+
+//////////////////////////////
+//
+// CheckSum::startMD5Sum -- Begin an incremental md5sum calculation.
+//    Add data with addToMD5Sum(), and then get the checksum with
+//    finishMD5Sum().
+//
+
+void CheckSum::startMD5Sum(void) {
+	MD5Init(&m_md5context);
+}
+
+
+
+//////////////////////////////
+//
+// CheckSum::addToMD5Sum -- Add more data to an incremental md5sum.
+//
+
+void CheckSum::addToMD5Sum(const unsigned char* data, unsigned long length) {
+	while (length > 0) {
+		unsigned int amount = length > 0x40000000 ? 0x40000000 : (unsigned int)length;
+		MD5Update(&m_md5context, (unsigned char*)data, amount);
+		data   += amount;
+		length -= amount;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// CheckSum::finishMD5Sum -- Return the md5sum of the data given to
+//    addToMD5Sum() since the last call to startMD5Sum().
+//
+
+string CheckSum::finishMD5Sum(void) {
+	stringstream outvalue;
+	unsigned char digest[16] = {0};
+	MD5Final(digest, &m_md5context);
+	for (int i=0; i<16; i++) {
+		if ((int)digest[i] < 16) {
+			outvalue << "0";
+		}
+		outvalue << hex << (int)digest[i] << dec;
+	}
+	return outvalue.str();
+}
+
+
+
 //////////////////////////////
 //
 // CheckSum::getMD5Sum -- interface to the previous functions.
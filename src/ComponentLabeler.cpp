@@ -0,0 +1,624 @@
+//
+// Creation Date: Fri Oct 16 12:20:41 PDT 2026
+// Last Modified: Fri Oct 16 12:20:41 PDT 2026
+// Filename:      ComponentLabeler.cpp
+// Web Address:
+// Syntax:        C++
+// vim:           ts=3:nowrap:ft=text
+//
+// Description:   Run-based connected-component labeling (8-connectivity).
+//
+
+#include "ComponentLabeler.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+using namespace std;
+
+namespace rip  {
+
+
+//////////////////////////////
+//
+// ComponentLabeler::ComponentLabeler -- Constructor.
+//
+
+ComponentLabeler::ComponentLabeler(void) {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// ComponentLabeler::~ComponentLabeler -- Destructor.
+//
+
+ComponentLabeler::~ComponentLabeler() {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// ComponentLabeler::clear -- Remove the results of the last labeling.
+//
+
+void ComponentLabeler::clear(void) {
+	m_runs.clear();
+	m_rowStart.clear();
+	m_parent.clear();
+	m_components.clear();
+	m_componentRuns.clear();
+}
+
+
+
+//////////////////////////////
+//
+// ComponentLabeler::setSeedWindow -- Only report components which have
+//    at least one pixel in rows [startrow, endrow) and columns
+//    [startcol, endcol).  The entry point of a component is its first
+//    pixel inside of this window.  By default the window is the entire
+//    plane.
+//
+
+void ComponentLabeler::setSeedWindow(ulongint startrow, ulongint endrow,
+		ulongint startcol, ulongint endcol) {
+	m_startrow = startrow;
+	m_endrow   = endrow;
+	m_startcol = startcol;
+	m_endcol   = endcol;
+	m_window   = true;
+}
+
+
+
+//////////////////////////////
+//
+// ComponentLabeler::label -- Find the connected components of pixels in
+//    the plane which are equal to target.  Components are sorted by their
+//    entry points (row-major order), which is the order in which a
+//    raster scan of the seed window would first encounter them.  Returns
+//    the number of components.
+//
+
+ulongint ComponentLabeler::label(ImagePlane<ucharint>& plane, ucharint target) {
+	return labelPlane(plane, target);
+}
+
+
+ulongint ComponentLabeler::label(RunLengthPlane& plane, ucharint target) {
+	return labelPlane(plane, target);
+}
+
+
+
+//////////////////////////////
+//
+// ComponentLabeler::labelPlane -- Split the plane into bands, label them
+//    (in parallel when there are several bands) and join the results.
+//
+
+template <class PLANE>
+ulongint ComponentLabeler::labelPlane(PLANE& plane, ucharint target) {
+	clear();
+	ulongint rows = plane.getRows();
+	if (!m_window) {
+		m_startrow = 0;
+		m_endrow   = rows;
+		m_startcol = 0;
+		m_endcol   = plane.getCols();
+	}
+
+	// Split the image into horizontal bands (one per thread), but do not
+	// make the bands too thin to be worth a thread:
+	ulongint minBandRows = 256;
+	ulongint bandcount = (ulongint)getThreadCount();
+	if (bandcount > rows / minBandRows) {
+		bandcount = rows / minBandRows;
+	}
+	if (bandcount < 1) {
+		bandcount = 1;
+	}
+	vector<Band> bands(bandcount);
+	for (ulongint i=0; i<bandcount; i++) {
+		bands[i].startrow = rows * i / bandcount;
+		bands[i].endrow   = rows * (i + 1) / bandcount;
+	}
+
+	ThreadPool::getShared().parallelForEach(bandcount, [this, &plane, target, &bands](ulongint i) {
+		labelBand(plane, target, bands[i]);
+	});
+
+	joinBands(bands);
+	collectComponents();
+	return m_components.size();
+}
+
+
+
+//////////////////////////////
+//
+// ComponentLabeler::setThreadCount -- Set the number of bands which are
+//    labeled in parallel.  0 means the thread count of the shared
+//    ThreadPool.
+//
+
+void ComponentLabeler::setThreadCount(int count) {
+	m_threadCount = count;
+}
+
+
+
+//////////////////////////////
+//
+// ComponentLabeler::setSkipMask -- Give a mask of pixels which cannot
+//    be target pixels (for example the paper mask of RollImage), so that
+//    label() does not have to look at them.  The mask must stay valid
+//    while label() is running.  NULL removes the mask.
+//
+
+void ComponentLabeler::setSkipMask(const BitPlane* mask) {
+	m_skipmask = mask;
+}
+
+
+
+//////////////////////////////
+//
+// ComponentLabeler::getThreadCount -- Returns the number of threads
+//    which will be used for labeling.
+//
+
+int ComponentLabeler::getThreadCount(void) {
+	if (m_threadCount > 0) {
+		return m_threadCount;
+	}
+	return ThreadPool::getShared().getThreadCount();
+}
+
+
+
+//////////////////////////////
+//
+// ComponentLabeler::getRuns -- Return the runs of the given component, in
+//    row-major order (ComponentInfo::runcount gives the number of runs).
+//
+
+const ComponentRun* ComponentLabeler::getRuns(ulongint index) {
+	return m_componentRuns.data() + m_components[index].runstart;
+}
+
+
+
+//////////////////////////////
+//
+// ComponentLabeler::paintComponent -- Set all pixels of a component
+//    to the given value.
+//
+
+void ComponentLabeler::paintComponent(ImagePlane<ucharint>& plane, ulongint index,
+		ucharint value) {
+	ComponentInfo& info = m_components[index];
+	const ComponentRun* runs = getRuns(index);
+	for (ulongint i=0; i<info.runcount; i++) {
+		ucharint* row = plane.getRow(runs[i].row);
+		std::fill(row + runs[i].start, row + runs[i].end, value);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// ComponentLabeler::paintComponent -- Set the pixels of a component to
+//    the given value, but only the ones which currently have a value in
+//    the range from lowest to highest (so that markings which have been
+//    drawn over the component are kept).
+//
+
+void ComponentLabeler::paintComponent(ImagePlane<ucharint>& plane, ulongint index,
+		ucharint value, ucharint lowest, ucharint highest) {
+	ComponentInfo& info = m_components[index];
+	const ComponentRun* runs = getRuns(index);
+	for (ulongint i=0; i<info.runcount; i++) {
+		ucharint* row = plane.getRow(runs[i].row);
+		for (ulongint c=runs[i].start; c<runs[i].end; c++) {
+			if ((row[c] >= lowest) && (row[c] <= highest)) {
+				row[c] = value;
+			}
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// findRunRoot -- Union-find lookup with path halving.
+//
+
+static unsigned int findRunRoot(vector<unsigned int>& parent, unsigned int index) {
+	while (parent[index] != index) {
+		parent[index] = parent[parent[index]];
+		index = parent[index];
+	}
+	return index;
+}
+
+
+
+//////////////////////////////
+//
+// uniteRuns -- Join the sets of two runs, keeping the earlier run as the
+//    root so that every run has a parent index which is not larger than
+//    its own index.
+//
+
+static void uniteRuns(vector<unsigned int>& parent, unsigned int a, unsigned int b) {
+	a = findRunRoot(parent, a);
+	b = findRunRoot(parent, b);
+	if (a < b) {
+		parent[b] = a;
+	} else if (b < a) {
+		parent[a] = b;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// mergeRunRows -- Join runs on rows [startrow, endrow) with the runs
+//    that they touch on the previous row (including diagonally).  The row
+//    numbers are indexes into rowStart.
+//
+
+static void mergeRunRows(vector<ComponentRun>& runs, vector<ulongint>& rowStart,
+		vector<unsigned int>& parent, ulongint startrow, ulongint endrow) {
+	for (ulongint r=startrow; r<endrow; r++) {
+		if (r == 0) {
+			continue;
+		}
+		ulongint i    = rowStart[r-1];
+		ulongint iend = rowStart[r];
+		ulongint j    = rowStart[r];
+		ulongint jend = rowStart[r+1];
+		while ((i < iend) && (j < jend)) {
+			ComponentRun& above = runs[i];
+			ComponentRun& below = runs[j];
+			if (above.end < below.start) {
+				i++;
+			} else if (below.end < above.start) {
+				j++;
+			} else {
+				uniteRuns(parent, (unsigned int)i, (unsigned int)j);
+				if (above.end <= below.end) {
+					i++;
+				} else {
+					j++;
+				}
+			}
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// ComponentLabeler::labelBand -- First pass for one band of rows: store
+//    the runs of target pixels in each row, and join the runs which touch
+//    within the band.  Bands only read from the plane, so they can be
+//    labeled in separate threads.  Rows of a plane which is stored in a
+//    temporary file are dropped from memory after they have been read.
+//
+
+void ComponentLabeler::labelBand(ImagePlane<ucharint>& plane, ucharint target,
+		Band& band) {
+	ulongint cols = plane.getCols();
+	ulongint bandrows = band.endrow - band.startrow;
+	band.rowStart.resize(bandrows + 1);
+	ComponentRun run;
+	for (ulongint r=band.startrow; r<band.endrow; r++) {
+		band.rowStart[r - band.startrow] = band.runs.size();
+		const ucharint* pixels = plane.getRow(r);
+		ulongint c = 0;
+		while (c < cols) {
+			// Pixels in [c, end) can contain target pixels:
+			ulongint end = cols;
+			if (m_skipmask) {
+				long next = m_skipmask->findClear(r, c);
+				if (next < 0) {
+					break;
+				}
+				c = next;
+				next = m_skipmask->findSet(r, c);
+				end = next < 0 ? cols : (ulongint)next;
+			}
+			while (c < end) {
+				if (pixels[c] != target) {
+					c++;
+					continue;
+				}
+				run.row = (unsigned int)r;
+				run.start = (unsigned int)c;
+				while ((c < end) && (pixels[c] == target)) {
+					c++;
+				}
+				run.end = (unsigned int)c;
+				band.runs.push_back(run);
+			}
+		}
+		if (plane.isFileBacked() && ((r + 1 - band.startrow) % 256 == 0)) {
+			plane.releaseRows(r + 1 - 256, 256);
+		}
+	}
+	band.rowStart[bandrows] = band.runs.size();
+	linkBand(band);
+}
+
+
+void ComponentLabeler::labelBand(RunLengthPlane& plane, ucharint target,
+		Band& band) {
+	ulongint bandrows = band.endrow - band.startrow;
+	band.rowStart.resize(bandrows + 1);
+	ComponentRun run;
+	for (ulongint r=band.startrow; r<band.endrow; r++) {
+		band.rowStart[r - band.startrow] = band.runs.size();
+		const vector<PixelRun>& pixelruns = plane.getRuns(r);
+		for (ulongint i=0; i<pixelruns.size(); i++) {
+			if (pixelruns[i].value != target) {
+				continue;
+			}
+			run.row   = (unsigned int)r;
+			run.start = pixelruns[i].start;
+			run.end   = (unsigned int)plane.getRunEnd(r, i);
+			band.runs.push_back(run);
+		}
+	}
+	band.rowStart[bandrows] = band.runs.size();
+	linkBand(band);
+}
+
+
+
+//////////////////////////////
+//
+// ComponentLabeler::linkBand -- Join the runs which touch within a band.
+//
+
+void ComponentLabeler::linkBand(Band& band) {
+	ulongint bandrows = band.endrow - band.startrow;
+	band.parent.resize(band.runs.size());
+	for (ulongint i=0; i<band.parent.size(); i++) {
+		band.parent[i] = (unsigned int)i;
+	}
+	mergeRunRows(band.runs, band.rowStart, band.parent, 1, bandrows);
+}
+
+
+
+//////////////////////////////
+//
+// ComponentLabeler::joinBands -- Concatenate the runs of all bands, and
+//    then join the components which cross the seams between bands (only
+//    the first row of each band needs to be compared with the row above).
+//
+
+void ComponentLabeler::joinBands(vector<Band>& bands) {
+	ulongint total = 0;
+	for (ulongint i=0; i<bands.size(); i++) {
+		total += bands[i].runs.size();
+	}
+	m_runs.reserve(total);
+	m_parent.reserve(total);
+	m_rowStart.clear();
+
+	for (ulongint i=0; i<bands.size(); i++) {
+		Band& band = bands[i];
+		unsigned int offset = (unsigned int)m_runs.size();
+		m_runs.insert(m_runs.end(), band.runs.begin(), band.runs.end());
+		for (ulongint j=0; j<band.parent.size(); j++) {
+			m_parent.push_back(band.parent[j] + offset);
+		}
+		for (ulongint j=0; j+1<band.rowStart.size(); j++) {
+			m_rowStart.push_back(band.rowStart[j] + offset);
+		}
+		vector<ComponentRun>().swap(band.runs);
+		vector<unsigned int>().swap(band.parent);
+		vector<ulongint>().swap(band.rowStart);
+	}
+	m_rowStart.push_back(m_runs.size());
+
+	for (ulongint i=1; i<bands.size(); i++) {
+		mergeRunRows(m_runs, m_rowStart, m_parent, bands[i].startrow,
+				bands[i].startrow + 1);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// ComponentLabeler::collectComponents -- Second pass: calculate the
+//    properties of each component and group its runs.
+//
+
+void ComponentLabeler::collectComponents(void) {
+	const unsigned int none = 0xffffffff;
+	ulongint runcount = m_runs.size();
+
+	// Parents always come before their children, so one forward pass
+	// resolves every run to its root.
+	for (ulongint i=0; i<runcount; i++) {
+		m_parent[i] = m_parent[m_parent[i]];
+	}
+
+	vector<ComponentInfo> found;
+	vector<unsigned int> rootComponent(runcount, none);
+	for (ulongint i=0; i<runcount; i++) {
+		ComponentRun& run = m_runs[i];
+		unsigned int root = m_parent[i];
+		if (rootComponent[root] == none) {
+			rootComponent[root] = (unsigned int)found.size();
+			ComponentInfo info;
+			info.area     = 0;
+			info.minrow   = run.row;
+			info.mincol   = run.start;
+			info.maxrow   = run.row;
+			info.maxcol   = run.end - 1;
+			info.rowsum   = 0;
+			info.colsum   = 0;
+			info.entryrow = none;
+			info.entrycol = none;
+			info.runstart = 0;
+			info.runcount = 0;
+			info.baserow  = run.row;
+			info.basecol  = run.start;
+			info.drsum    = 0.0;
+			info.dcsum    = 0.0;
+			info.drdrsum  = 0.0;
+			info.dcdcsum  = 0.0;
+			info.drdcsum  = 0.0;
+			found.push_back(info);
+		}
+		ComponentInfo& info = found[rootComponent[root]];
+		ulonglongint length = run.end - run.start;
+		info.area   += length;
+		info.rowsum += length * run.row;
+		info.colsum += length * (run.start + run.end - 1) / 2;
+		info.runcount++;
+		if (run.start < info.mincol) {
+			info.mincol = run.start;
+		}
+		if (run.end - 1 > info.maxcol) {
+			info.maxcol = run.end - 1;
+		}
+		info.maxrow = run.row;  // runs are in row order
+
+		// Second-order sums for the run, relative to the base pixel:
+		double n  = (double)length;
+		double dr = (double)run.row - (double)info.baserow;
+		double c0 = (double)run.start - (double)info.basecol;
+		double c1 = c0 + n - 1.0;
+		double dcsum = n * (c0 + c1) / 2.0;
+		info.drsum   += n * dr;
+		info.dcsum   += dcsum;
+		info.drdrsum += n * dr * dr;
+		info.dcdcsum += n * (c0 + c1) * (c0 + c1) / 4.0 + n * (n * n - 1.0) / 12.0;
+		info.drdcsum += dr * dcsum;
+
+		if ((info.entryrow == none) && (run.row >= m_startrow) &&
+				(run.row < m_endrow) && (run.start < m_endcol) &&
+				(run.end > m_startcol)) {
+			info.entryrow = run.row;
+			info.entrycol = std::max((ulongint)run.start, m_startcol);
+		}
+	}
+
+	// Keep components in the seed window, sorted by entry point:
+	vector<unsigned int> order;
+	for (ulongint i=0; i<found.size(); i++) {
+		if (found[i].entryrow != none) {
+			order.push_back((unsigned int)i);
+		}
+	}
+	std::sort(order.begin(), order.end(),
+		[&found](unsigned int a, unsigned int b) {
+			if (found[a].entryrow != found[b].entryrow) {
+				return found[a].entryrow < found[b].entryrow;
+			}
+			return found[a].entrycol < found[b].entrycol;
+		});
+
+	vector<unsigned int> newIndex(found.size(), none);
+	m_components.resize(order.size());
+	ulongint total = 0;
+	for (ulongint i=0; i<order.size(); i++) {
+		newIndex[order[i]] = (unsigned int)i;
+		m_components[i] = found[order[i]];
+		m_components[i].runstart = total;
+		total += m_components[i].runcount;
+	}
+
+	// Group the runs by component (staying in row-major order):
+	m_componentRuns.resize(total);
+	vector<ulongint> position(m_components.size());
+	for (ulongint i=0; i<m_components.size(); i++) {
+		position[i] = m_components[i].runstart;
+	}
+	for (ulongint i=0; i<runcount; i++) {
+		unsigned int index = newIndex[rootComponent[m_parent[i]]];
+		if (index != none) {
+			m_componentRuns[position[index]++] = m_runs[i];
+		}
+	}
+
+	for (ulongint i=0; i<m_components.size(); i++) {
+		calculateShape(m_components[i]);
+	}
+
+	// The run list and union-find data are no longer needed:
+	vector<ComponentRun>().swap(m_runs);
+	vector<unsigned int>().swap(m_parent);
+	vector<ulongint>().swap(m_rowStart);
+}
+
+
+
+//////////////////////////////
+//
+// ComponentLabeler::calculateShape -- Calculate the central moments and
+//    the perimeter of a component.  The perimeter follows the outer
+//    left and right edges of the rows in the component: the first and last
+//    rows contribute their widths, and the edges between successive rows
+//    contribute the length of the step from one row to the next (so a
+//    w x h rectangle has a perimeter of 2w + 2h).
+//
+
+void ComponentLabeler::calculateShape(ComponentInfo& info) {
+	double n = (double)info.area;
+	info.moment20 = info.dcdcsum - info.dcsum * info.dcsum / n;
+	info.moment02 = info.drdrsum - info.drsum * info.drsum / n;
+	info.moment11 = info.drdcsum - info.drsum * info.dcsum / n;
+
+	const ComponentRun* runs = m_componentRuns.data() + info.runstart;
+	double perimeter = 0.0;
+	double lastleft  = 0.0;
+	double lastright = 0.0;
+	ulongint i = 0;
+	while (i < info.runcount) {
+		// Outer extent of all runs on this row:
+		unsigned int row = runs[i].row;
+		double left  = runs[i].start;
+		double right = runs[i].end;
+		for (i++; (i < info.runcount) && (runs[i].row == row); i++) {
+			right = runs[i].end;
+		}
+		if (row == info.minrow) {
+			perimeter += right - left;
+		} else {
+			perimeter += std::hypot(1.0, left - lastleft);
+			perimeter += std::hypot(1.0, right - lastright);
+		}
+		if (row == info.maxrow) {
+			perimeter += right - left;
+		}
+		lastleft  = left;
+		lastright = right;
+	}
+	// half of a row above the first row and below the last row, on each side:
+	info.perimeter = perimeter + 2.0;
+}
+
+
+} // end rip namespace
+
+
+
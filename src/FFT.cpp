@@ -15,7 +15,11 @@
 
 #ifndef DONOTUSEFFT
 
+#include <cmath>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
 
 using namespace std::complex_literals;
 
@@ -51,7 +55,7 @@ void FFT(std::vector<mycomplex>& output, std::vector<mycomplex>& input) {
    }
 
    output = input;
-   fft_destructive(output);
+   FFTPlan::getPlan(N).transform(output);
 }
 
 
@@ -167,6 +171,247 @@ int bitrev(int n, int B) {
 
 
 
+///////////////////////////////////////////////////////////////////////////
+//
+// FFTPlan --
+//
+
+//////////////////////////////
+//
+// FFTPlan::FFTPlan -- Constructor.  The size must be a power of two.
+//
+
+FFTPlan::FFTPlan(int size) : m_size(0) {
+	if (size > 0) {
+		setSize(size);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// FFTPlan::~FFTPlan -- Destructor.
+//
+
+FFTPlan::~FFTPlan() {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// FFTPlan::getPlan -- Return the shared plan for transforms of the given
+//    size, creating it the first time that the size is used.  Safe to call
+//    from several threads.
+//
+
+const FFTPlan& FFTPlan::getPlan(int size) {
+	static std::mutex lock;
+	static std::map<int, std::unique_ptr<FFTPlan>> plans;
+	std::lock_guard<std::mutex> guard(lock);
+	std::unique_ptr<FFTPlan>& plan = plans[size];
+	if (!plan) {
+		plan.reset(new FFTPlan(size));
+	}
+	return *plan;
+}
+
+
+
+//////////////////////////////
+//
+// FFTPlan::setSize -- Calculate the tables for the given transform size.
+//    Returns false if the size is not a power of two.
+//
+
+bool FFTPlan::setSize(int size) {
+	if (!isPowerOfTwo(size)) {
+		std::cerr << "FFT plan size must be a power of 2: " << size << std::endl;
+		return false;
+	}
+	m_size = size;
+	m_twiddles.resize(size / 2);
+	double pi = 4.0 * atan(1.0);
+	for (int k=0; k<size/2; k++) {
+		double angle = -2.0 * pi * k / size;
+		m_twiddles[k] = mycomplex(cos(angle), sin(angle));
+	}
+	makeBitReversal(m_bitrev, size);
+	makeBitReversal(m_halfBitrev, size / 2);
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// FFTPlan::transform -- Replace the complex data (which must have the size
+//    of the plan) with its spectrum.
+//
+
+void FFTPlan::transform(std::vector<mycomplex>& data) const {
+	if ((int)data.size() != m_size) {
+		std::cerr << "FFT data size " << data.size()
+		          << " does not match plan size " << m_size << std::endl;
+		return;
+	}
+	transformInPlace(data.data(), m_size, m_bitrev, 1);
+}
+
+
+
+//////////////////////////////
+//
+// FFTPlan::transformReal -- Calculate the spectrum of a real signal, which
+//    is zero-padded if it is shorter than the plan size.  Only the bins from
+//    0 to size/2 are stored in the output (the others are their complex
+//    conjugates).  The even and odd samples are transformed together as one
+//    complex signal of half the length, which is then split into the
+//    spectrum of the full signal.
+//
+
+void FFTPlan::transformReal(std::vector<mycomplex>& output,
+		const std::vector<double>& input) const {
+	int half = m_size / 2;
+	if ((half == 0) || ((int)input.size() > m_size)) {
+		std::cerr << "FFT input size " << input.size()
+		          << " does not fit plan size " << m_size << std::endl;
+		output.clear();
+		return;
+	}
+
+	std::vector<mycomplex> packed(half, 0.0);
+	int count = (int)input.size();
+	for (int j=0; j<half; j++) {
+		double even = 2*j   < count ? input[2*j]   : 0.0;
+		double odd  = 2*j+1 < count ? input[2*j+1] : 0.0;
+		packed[j] = mycomplex(even, odd);
+	}
+	transformInPlace(packed.data(), half, m_halfBitrev, 2);
+
+	output.resize(half + 1);
+	output[0]    = mycomplex(packed[0].real() + packed[0].imag(), 0.0);
+	output[half] = mycomplex(packed[0].real() - packed[0].imag(), 0.0);
+	for (int k=1; k<half; k++) {
+		double zr = packed[k].real();
+		double zi = packed[k].imag();
+		double cr = packed[half-k].real();
+		double ci = -packed[half-k].imag();
+		// spectrum of the even samples:
+		double er = 0.5 * (zr + cr);
+		double ei = 0.5 * (zi + ci);
+		// spectrum of the odd samples:
+		double orr = 0.5 * (zi - ci);
+		double oi  = -0.5 * (zr - cr);
+		double wr = m_twiddles[k].real();
+		double wi = m_twiddles[k].imag();
+		output[k] = mycomplex(er + wr * orr - wi * oi, ei + wr * oi + wi * orr);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// FFTPlan::transformInPlace -- Iterative decimation-in-time transform of
+//    size samples (a power of two which divides the plan size), using every
+//    stride-th twiddle factor of the plan.  Pairs of radix-2 stages are
+//    done together as radix-4 butterflies, so each pass over the data does
+//    the work of two stages.  The arithmetic is written out on the real
+//    and imaginary parts so that the compiler can vectorize it.
+//
+
+void FFTPlan::transformInPlace(mycomplex* data, int size,
+		const std::vector<int>& bitrev, int stride) const {
+	for (int i=0; i<size; i++) {
+		int r = bitrev[i];
+		if (r > i) {
+			std::swap(data[i], data[r]);
+		}
+	}
+
+	double* x = reinterpret_cast<double*>(data);
+	int stages = 0;
+	while ((1 << stages) < size) {
+		stages++;
+	}
+
+	int length = 1;  // size of the transforms merged in the next pass
+	if (stages % 2) {
+		for (int i=0; i<size; i+=2) {
+			double ar = x[2*i],   ai = x[2*i+1];
+			double br = x[2*i+2], bi = x[2*i+3];
+			x[2*i]   = ar + br;  x[2*i+1] = ai + bi;
+			x[2*i+2] = ar - br;  x[2*i+3] = ai - bi;
+		}
+		length = 2;
+	}
+
+	const mycomplex* twiddles = m_twiddles.data();
+	while (length < size) {
+		int step1 = (size / (2 * length)) * stride;  // twiddles of 2*length
+		int step2 = (size / (4 * length)) * stride;  // twiddles of 4*length
+		for (int group=0; group<size; group+=4*length) {
+			for (int k=0; k<length; k++) {
+				double w1r = twiddles[k*step1].real();
+				double w1i = twiddles[k*step1].imag();
+				double w2r = twiddles[k*step2].real();
+				double w2i = twiddles[k*step2].imag();
+				double* a = x + 2*(group + k);
+				double* b = a + 2*length;
+				double* c = b + 2*length;
+				double* d = c + 2*length;
+
+				// first stage: b and d times the order-2*length twiddle
+				double br = b[0] * w1r - b[1] * w1i;
+				double bi = b[0] * w1i + b[1] * w1r;
+				double dr = d[0] * w1r - d[1] * w1i;
+				double di = d[0] * w1i + d[1] * w1r;
+				double sr = a[0] + br, si = a[1] + bi;
+				double tr = a[0] - br, ti = a[1] - bi;
+				double ur = c[0] + dr, ui = c[1] + di;
+				double vr = c[0] - dr, vi = c[1] - di;
+
+				// second stage: order-4*length twiddle, and -i times it
+				// for the odd half
+				double pr = ur * w2r - ui * w2i;
+				double pi = ur * w2i + ui * w2r;
+				double qr = vr * w2i + vi * w2r;
+				double qi = vi * w2i - vr * w2r;
+
+				a[0] = sr + pr;  a[1] = si + pi;
+				c[0] = sr - pr;  c[1] = si - pi;
+				b[0] = tr + qr;  b[1] = ti + qi;
+				d[0] = tr - qr;  d[1] = ti - qi;
+			}
+		}
+		length *= 4;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// FFTPlan::makeBitReversal -- Store the bit reversal of each index for
+//    transforms of the given size.
+//
+
+void FFTPlan::makeBitReversal(std::vector<int>& table, int size) {
+	table.assign(size, 0);
+	int bits = 0;
+	while ((1 << bits) < size) {
+		bits++;
+	}
+	for (int i=1; i<size; i++) {
+		table[i] = (table[i >> 1] >> 1) | ((i & 1) << (bits - 1));
+	}
+}
+
+
+
 } // end namespace rip
 
 
@@ -62,6 +62,9 @@ void HoleInfo::clear(void) {
 	perimeter       = 0.0;
 	circularity     = 0.0;
 	majoraxis       = 0.0;
+	moment20        = 0.0;
+	moment02        = 0.0;
+	moment11        = 0.0;
 	coldrift        = 0.0;
 	leadinghcor     = 0.0;
 	trailinghcor    = 0.0;
@@ -70,6 +73,7 @@ void HoleInfo::clear(void) {
 	snakebite       = false;
 	offtime         = 0;
 	midikey         = -1;
+	component       = -1;
 }
 
 
@@ -0,0 +1,197 @@
+//
+// Creation Date: Fri Oct 16 23:59:48 PDT 2026
+// Last Modified: Fri Oct 16 23:59:48 PDT 2026
+// Filename:      MappedBuffer.cpp
+// Web Address:
+// Syntax:        C++
+// vim:           ts=3:nowrap:ft=text
+//
+// Description:   Block of memory stored in an anonymous temporary file.
+//
+
+#include "MappedBuffer.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#ifndef _WIN32
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace rip  {
+
+
+//////////////////////////////
+//
+// MappedBuffer::MappedBuffer -- Constructors.
+//
+
+MappedBuffer::MappedBuffer(void) {
+	// do nothing
+}
+
+
+MappedBuffer::MappedBuffer(MappedBuffer&& buffer) {
+	m_data = buffer.m_data;
+	m_size = buffer.m_size;
+	m_file = buffer.m_file;
+	buffer.m_data = NULL;
+	buffer.m_size = 0;
+	buffer.m_file = -1;
+}
+
+
+
+//////////////////////////////
+//
+// MappedBuffer::~MappedBuffer -- Destructor.
+//
+
+MappedBuffer::~MappedBuffer() {
+	clear();
+}
+
+
+
+//////////////////////////////
+//
+// MappedBuffer::operator= -- Move assignment.
+//
+
+MappedBuffer& MappedBuffer::operator=(MappedBuffer&& buffer) {
+	if (this == &buffer) {
+		return *this;
+	}
+	clear();
+	m_data = buffer.m_data;
+	m_size = buffer.m_size;
+	m_file = buffer.m_file;
+	buffer.m_data = NULL;
+	buffer.m_size = 0;
+	buffer.m_file = -1;
+	return *this;
+}
+
+
+
+//////////////////////////////
+//
+// MappedBuffer::create -- Allocate a zeroed buffer of the given size in a
+//    temporary file in the directory (or in $TMPDIR or /tmp if the
+//    directory is empty).  Returns false if the file cannot be created or
+//    mapped, leaving the buffer empty.  The directory should be on a disk
+//    rather than a memory file system such as tmpfs, or the buffer will
+//    still occupy memory.
+//
+
+bool MappedBuffer::create(ulonglongint bytes, const string& directory) {
+	clear();
+	if (bytes == 0) {
+		return false;
+	}
+#ifdef _WIN32
+	cerr << "Warning: file-backed image planes are not available" << endl;
+	return false;
+#else
+	string dir = directory;
+	if (dir.empty()) {
+		const char* tmpdir = getenv("TMPDIR");
+		dir = (tmpdir && *tmpdir) ? tmpdir : "/tmp";
+	}
+	string pattern = dir + "/rip-plane-XXXXXX";
+	vector<char> name(pattern.begin(), pattern.end());
+	name.push_back('\0');
+	int file = mkstemp(name.data());
+	if (file < 0) {
+		cerr << "Warning: cannot create a scratch file in " << dir << ": "
+		     << strerror(errno) << endl;
+		return false;
+	}
+	unlink(name.data());
+	if (ftruncate(file, (off_t)bytes) != 0) {
+		cerr << "Warning: cannot size a scratch file in " << dir << ": "
+		     << strerror(errno) << endl;
+		close(file);
+		return false;
+	}
+	void* data = mmap(NULL, (size_t)bytes, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+	if (data == MAP_FAILED) {
+		cerr << "Warning: cannot map a scratch file in " << dir << ": "
+		     << strerror(errno) << endl;
+		close(file);
+		return false;
+	}
+	m_data = data;
+	m_size = bytes;
+	m_file = file;
+	return true;
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// MappedBuffer::clear -- Unmap the buffer and close its file (which
+//    deletes it).
+//
+
+void MappedBuffer::clear(void) {
+#ifndef _WIN32
+	if (m_data) {
+		munmap(m_data, (size_t)m_size);
+	}
+	if (m_file >= 0) {
+		close(m_file);
+	}
+#endif
+	m_data = NULL;
+	m_size = 0;
+	m_file = -1;
+}
+
+
+
+//////////////////////////////
+//
+// MappedBuffer::release -- Write a range of the buffer to its file and
+//    drop it from memory.  The contents are kept: the pages are read back
+//    from the file when they are accessed again.  The range is extended
+//    to whole pages.
+//
+
+void MappedBuffer::release(ulonglongint offset, ulonglongint bytes) {
+#ifndef _WIN32
+	if (!m_data || (offset >= m_size) || (bytes == 0)) {
+		return;
+	}
+	if (bytes > m_size - offset) {
+		bytes = m_size - offset;
+	}
+	static const ulonglongint pagesize = (ulonglongint)sysconf(_SC_PAGESIZE);
+	ulonglongint start = offset / pagesize * pagesize;
+	ulonglongint end = (offset + bytes + pagesize - 1) / pagesize * pagesize;
+	if (end > m_size) {
+		end = m_size;
+	}
+	char* base = (char*)m_data + start;
+	msync(base, (size_t)(end - start), MS_SYNC);
+	madvise(base, (size_t)(end - start), MADV_DONTNEED);
+	#ifdef POSIX_FADV_DONTNEED
+		posix_fadvise(m_file, (off_t)start, (off_t)(end - start), POSIX_FADV_DONTNEED);
+	#endif
+#endif
+}
+
+
+} // end rip namespace
+
+
+
@@ -0,0 +1,228 @@
+//
+// Creation Date: Fri Oct 16 23:59:02 PDT 2026
+// Last Modified: Fri Oct 16 23:59:02 PDT 2026
+// Filename:      PerfCounters.cpp
+// Web Address:
+// Syntax:        C++
+// vim:           ts=3:nowrap:ft=text
+//
+// Description:   Hardware performance counters of the calling thread.
+//
+
+#include "PerfCounters.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+	#include <linux/perf_event.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace rip  {
+
+
+//////////////////////////////
+//
+// PerfCounters::PerfCounters -- Constructor.  The counters are not
+//    opened until open() is called.
+//
+
+PerfCounters::PerfCounters(void) {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// PerfCounters::~PerfCounters -- Destructor.
+//
+
+PerfCounters::~PerfCounters() {
+	close();
+}
+
+
+
+//////////////////////////////
+//
+// PerfCounters::open -- Start counting the events of the calling thread.
+//    Returns false if none of the counters can be opened, in which case
+//    getError() gives the reason.  Counters which the processor does not
+//    support are left unavailable.
+//
+
+bool PerfCounters::open(void) {
+	if (m_opened) {
+		return isAvailable();
+	}
+	m_opened = true;
+
+#ifdef __linux__
+	const ulongint configs[PERF_COUNTER_COUNT][2] = {
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES    },
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS  },
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES  },
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+		{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB
+				| (PERF_COUNT_HW_CACHE_OP_READ << 8)
+				| (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) }
+	};
+
+	int lasterror = 0;
+	for (int i=0; i<PERF_COUNTER_COUNT; i++) {
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size           = sizeof(attr);
+		attr.type           = (unsigned int)configs[i][0];
+		attr.config         = configs[i][1];
+		attr.exclude_kernel = 1;
+		attr.exclude_hv     = 1;
+		// Scale the counts if the kernel has to share the hardware
+		// counters between more events than it has registers for:
+		attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED |
+		                      PERF_FORMAT_TOTAL_TIME_RUNNING;
+		long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+		if (fd < 0) {
+			lasterror = errno;
+			continue;
+		}
+		m_fd[i] = (int)fd;
+	}
+	if (!isAvailable()) {
+		switch (lasterror) {
+			case EACCES:
+			case EPERM:
+				m_error = "not permitted (see /proc/sys/kernel/perf_event_paranoid)";
+				break;
+			case ENOENT:
+			case ENODEV:
+			case EOPNOTSUPP:
+				m_error = "no hardware performance counters";
+				break;
+			case ENOSYS:
+				m_error = "perf_event_open is not supported by the kernel";
+				break;
+			default:
+				m_error = strerror(lasterror);
+				break;
+		}
+		return false;
+	}
+	return true;
+#else
+	m_error = "only available on Linux";
+	return false;
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// PerfCounters::close -- Stop counting.
+//
+
+void PerfCounters::close(void) {
+	for (int i=0; i<PERF_COUNTER_COUNT; i++) {
+#ifdef __linux__
+		if (m_fd[i] >= 0) {
+			::close(m_fd[i]);
+		}
+#endif
+		m_fd[i] = -1;
+	}
+	m_opened = false;
+}
+
+
+
+//////////////////////////////
+//
+// PerfCounters::isAvailable -- True if at least one counter is open.
+//
+
+bool PerfCounters::isAvailable(void) const {
+	for (int i=0; i<PERF_COUNTER_COUNT; i++) {
+		if (m_fd[i] >= 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+//////////////////////////////
+//
+// PerfCounters::read -- Current values of the counters since open(), or
+//    -1 for the counters that are not available.
+//
+
+PerfValues PerfCounters::read(void) const {
+	PerfValues output;
+#ifdef __linux__
+	for (int i=0; i<PERF_COUNTER_COUNT; i++) {
+		if (m_fd[i] < 0) {
+			continue;
+		}
+		// value, time enabled, time running
+		ulonglongint data[3] = {0, 0, 0};
+		if (::read(m_fd[i], data, sizeof(data)) != (ssize_t)sizeof(data)) {
+			continue;
+		}
+		if ((data[2] > 0) && (data[2] < data[1])) {
+			output.value[i] = (longlongint)((double)data[0] * data[1] / data[2]);
+		} else {
+			output.value[i] = (longlongint)data[0];
+		}
+	}
+#endif
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// PerfCounters::getCounterName -- Lower-case name of a counter (for JSON).
+//
+
+const char* PerfCounters::getCounterName(int type) {
+	switch (type) {
+		case PERF_CYCLES:        return "cycles";
+		case PERF_INSTRUCTIONS:  return "instructions";
+		case PERF_LLC_MISSES:    return "llc_misses";
+		case PERF_BRANCH_MISSES: return "branch_misses";
+		case PERF_DTLB_MISSES:   return "dtlb_misses";
+	}
+	return "unknown";
+}
+
+
+
+//////////////////////////////
+//
+// PerfCounters::getCounterLabel -- Upper-case name of a counter (for ATON).
+//
+
+const char* PerfCounters::getCounterLabel(int type) {
+	switch (type) {
+		case PERF_CYCLES:        return "CYCLES";
+		case PERF_INSTRUCTIONS:  return "INSTRUCTIONS";
+		case PERF_LLC_MISSES:    return "LLC_MISSES";
+		case PERF_BRANCH_MISSES: return "BRANCH_MISSES";
+		case PERF_DTLB_MISSES:   return "DTLB_MISSES";
+	}
+	return "UNKNOWN";
+}
+
+
+} // end rip namespace
+
+
+
@@ -14,15 +14,24 @@
 #include "HoleInfo.h"
 #include "ShiftInfo.h"
 #include "CheckSum.h"
+#include "ComponentLabeler.h"
+#include "TaskGraph.h"
+#include "Smoothing.h"
+#include "ThreadPool.h"
 
 #include <algorithm>
 #include <string>
 #include <cmath>
+#include <functional>
 
 using namespace std;
 
 namespace rip  {
 
+// HOLE_GRAIN: number of holes handled by each task of the parallel loops
+// over holes.
+static const ulongint HOLE_GRAIN = 512;
+
 
 //////////////////////////////
 //
@@ -64,6 +73,9 @@ void RollImage::clear(void) {
 	m_dustscorebass             = -1.0;
 	m_dustscoretreble           = -1.0;
 	m_averageHoleWidth          = -1.0;
+	m_marginVersion             = 1;
+	m_bandRows                  = 0;
+	m_marginSignals.clear();
 }
 
 
@@ -121,24 +133,86 @@ string RollImage::my_to_string(int value) {
 //
 // RollImage::loadGreenChannel -- Load the green channel of the input image
 //   and trim at the brightness threshold for the paper/hole boundary.
+//   The image is processed one row at a time: the green samples of a row
+//   are extracted and then classified into pixelType while the row is
+//   still in the cache.  If keepMonochrome is false, the grey levels
+//   are discarded after classification (only pixelType is needed for
+//   analysis, and the CHANNEL_MD5 checksum is calculated here).  If
+//   getRunLengthPixels() is true, the classes are stored as runs in
+//   pixelRuns, and pixelType is not allocated until analyzeHoles().
+//   paperMask is also filled in, with one bit for each paper pixel.
 //
 
-void RollImage::loadGreenChannel(int threshold) {
+void RollImage::loadGreenChannel(int threshold, bool keepMonochrome) {
 	setThreshold(threshold);
 	ulongint rows = getRows();
 	ulongint cols = getCols();
-	this->getImageGreenChannel(monochrome);
-	pixelType.resize(rows);
+	// RGB input, plus the classes and the monochrome channel if kept:
+	ScopedStage stage(m_profiler, "loadGreenChannel",
+			(ulonglongint)rows * cols * (keepMonochrome ? 5 : 4));
+	ucharint limit = (ucharint)getThreshold();
+
+	CheckSum checksum;
+	checksum.startMD5Sum();
+
+	// With a memory budget, the pixel planes are kept in temporary files
+	// and each long pass over the image keeps only the current and the
+	// previous band of rows in memory:
+	m_bandRows = 0;
+	bool banded = getBandMemory() > 0;
+	monochrome.setScratchDirectory(getScratchDirectory(), banded);
+	pixelType.setScratchDirectory(getScratchDirectory(), banded);
+	if (banded) {
+		ulonglongint rowbytes = (ulonglongint)cols * (keepMonochrome ? 2 : 1);
+		m_bandRows = (ulongint)(getBandMemory() / (2 * rowbytes));
+		if (m_bandRows < 64) {
+			m_bandRows = 64;
+		}
+	}
+
+	vector<ucharint> scratch;
+	if (keepMonochrome) {
+		monochrome.resize(rows, cols, true);
+	} else {
+		monochrome.clear();
+		scratch.resize(cols);
+	}
+	paperMask.resize(rows, cols);
+	bool runlength = getRunLengthPixels();
+	vector<ucharint> classes;
+	if (runlength) {
+		pixelType.clear();
+		pixelRuns.resize(rows, cols);
+		classes.resize(cols);
+	} else {
+		pixelRuns.clear();
+		pixelType.resize(rows, cols, true);
+	}
+
 	for (ulongint r=0; r<rows; r++) {
-		pixelType[r].resize(getCols());
-		for (ulongint c=0; c<cols; c++) {
-			if (aboveThreshold(monochrome[r][c], getThreshold())) {
-				pixelType[r][c] = PIX_NONPAPER;
-			} else {
-				pixelType[r][c] = PIX_PAPER;
-			}
+		ucharint* green = keepMonochrome ? monochrome.getRow(r) : scratch.data();
+		extractGreenChannel(green, getRowPixels(r), cols);
+		checksum.addToMD5Sum(green, cols);
+		packBelowThreshold(paperMask.getRow(r), green, cols, limit);
+		// PIX_NONPAPER is 1 and PIX_PAPER is 0:
+		if (runlength) {
+			markAboveThreshold(classes.data(), green, cols, limit);
+			pixelRuns.encodeRow(r, classes.data());
+		} else {
+			markAboveThreshold(pixelType.getRow(r), green, cols, limit);
+		}
+		if ((r + 1) % 256 == 0) {
+			releaseRowPixels(r + 1 - 256, 256);
 		}
+		if ((r + 1) % 4096 == 0) {
+			m_profiler.addCounter("bytes read", (double)(r + 1) * cols * 3);
+		}
+		releasePixelBand(r + 1);
 	}
+	releasePixelRows(0, rows);
+	releaseRowPixels(rows - rows % 256, rows % 256);
+	m_profiler.addCounter("bytes read", (double)rows * cols * 3);
+	m_channelMD5 = checksum.finishMD5Sum();
 }
 
 
@@ -153,57 +227,121 @@ void RollImage::analyze(void) {
 #ifndef DONOTUSEFFT
 	start_time = std::chrono::system_clock::now();
 #endif
+	ScopedStage stage(m_profiler, "analyze");
+
+	// Each step is declared with the data that it reads and writes, and
+	// steps which do not conflict may run at the same time (for example
+	// analyzeShifts() only needs the final margins).  The results are the
+	// same as running the steps in this order.
+	TaskGraph steps;
+	steps.setThreadCount(getThreadCount());
+	auto addStep = [this, &steps](const string& name, ulongint reads,
+			ulongint writes, std::function<void(void)> function) {
+		string message = "STEP " + my_to_string(steps.getTaskCount() + 1) + ": " + name + "\n";
+		steps.addTask(name, [this, name, message, function, reads, writes]() {
+			if (m_debug) { cerr << message << std::flush; }
+			ScopedStage stage(m_profiler, name);
+			function();
+			if (m_bandRows > 0) {
+				// drop the rows that the step left in memory (including
+				// rows touched at random, such as by hole painting):
+				releasePixelRows(0, getRows());
+			}
+			if (m_profiler.isEnabled()) {
+				stage.addBytes(getDataBytes(reads | writes));
+				addDataCounters(writes);
+			}
+		}, reads, writes);
+	};
+
+	addStep("analyzeBasicMargins",
+			0, DATA_PIXELS | DATA_MARGINS,
+			[this]() { analyzeBasicMargins(); });
+	addStep("analyzeLeaders",
+			0, DATA_PIXELS | DATA_MARGINS | DATA_LEADER,
+			[this]() { analyzeLeaders(); });
+	addStep("analyzeAdvancedMargins",
+			DATA_LEADER, DATA_PIXELS | DATA_MARGINS,
+			[this]() { analyzeAdvancedMargins(); });
+	addStep("generateDriftCorrection",
+			DATA_MARGINS | DATA_LEADER, DATA_DRIFT | DATA_HOLES,
+			[this]() { generateDriftCorrection(0.01); });
+	addStep("analyzeHoles",
+			DATA_MARGINS, DATA_PIXELS | DATA_LEADER | DATA_HOLES | DATA_BADHOLES,
+			[this]() { analyzeHoles(); });
+	// analyzeTears() also moves the margins out of small tears:
+	addStep("analyzeTears",
+			DATA_LEADER, DATA_PIXELS | DATA_MARGINS | DATA_TEARS,
+			[this]() { analyzeTears(); });
+	addStep("analyzeShifts",
+			DATA_MARGINS | DATA_LEADER, DATA_SHIFTS,
+			[this]() { analyzeShifts(); });
+	addStep("generateDriftCorrection",
+			DATA_MARGINS | DATA_LEADER, DATA_DRIFT | DATA_HOLES,
+			[this]() { generateDriftCorrection(0.01); });
+	addStep("calculateHoleDescriptors",
+			0, DATA_HOLES,
+			[this]() { calculateHoleDescriptors(); });
+	addStep("invalidateSkewedHoles",
+			0, DATA_PIXELS | DATA_HOLES | DATA_BADHOLES,
+			[this]() { invalidateSkewedHoles(); });
+	addStep("markPosteriorLeader",
+			DATA_LEADER, DATA_PIXELS,
+			[this]() { markPosteriorLeader(); });
+	addStep("analyzeTrackerBarSpacing",
+			DATA_MARGINS | DATA_DRIFT | DATA_HOLES, DATA_TRACKER,
+			[this]() {
+				storeCorrectedCentroidHistogram();
+				analyzeRawRowPositions();
+				analyzeTrackerBarSpacing();
+			});
+	addStep("analyzeTrackerBarPositions",
+			0, DATA_TRACKER,
+			[this]() {
+				// analyzeTrackerBarPositions();
+				calculateTrackerSpacings2();
+			});
+	addStep("analyzeHorizontalHolePosition",
+			DATA_DRIFT, DATA_HOLES | DATA_TRACKER,
+			[this]() { analyzeHorizontalHolePosition(); });
+	addStep("analyzeMidiKeyMapping",
+			DATA_MARGINS | DATA_LEADER | DATA_DRIFT, DATA_TRACKER,
+			[this]() { analyzeMidiKeyMapping(); });
+	addStep("invalidateEdgeHoles",
+			DATA_TRACKER, DATA_PIXELS | DATA_HOLES | DATA_BADHOLES,
+			[this]() { invalidateEdgeHoles(); });
+	addStep("invalidateOffTrackerHoles",
+			DATA_DRIFT | DATA_TRACKER, DATA_HOLES,
+			[this]() { invalidateOffTrackerHoles(); });
+	addStep("recalculateFirstMusicHole",
+			DATA_HOLES | DATA_TRACKER, DATA_PIXELS | DATA_LEADER | DATA_BADHOLES,
+			[this]() { recalculateFirstMusicHole(); });
+	addStep("addDriftInfoToHoles",
+			DATA_DRIFT, DATA_HOLES,
+			[this]() { addDriftInfoToHoles(); });
+	addStep("addAntidustToBadHoles",
+			DATA_LEADER | DATA_HOLES, DATA_BADHOLES,
+			[this]() { addAntidustToBadHoles(50); });
+	addStep("assignMusicHoleIds",
+			DATA_TRACKER, DATA_HOLES,
+			[this]() { assignMusicHoleIds(); });
+	addStep("groupHoles",
+			DATA_TRACKER, DATA_HOLES,
+			[this]() { groupHoles(); });
+	addStep("analyzeSnakeBites",
+			0, DATA_PIXELS | DATA_HOLES | DATA_TRACKER,
+			[this]() { analyzeSnakeBites(); });
+	steps.run();
+	clearMarginSignals();
 
-	if (m_debug) { cerr << "STEP 1: analyzeBasicMargins" << endl; }
-	analyzeBasicMargins();
-	if (m_debug) { cerr << "STEP 2: analyzeLeaders" << endl; }
-	analyzeLeaders();
-	if (m_debug) { cerr << "STEP 3: analyzeAdvancedMargins" << endl; }
-	analyzeAdvancedMargins();
-	if (m_debug) { cerr << "STEP 4: generateDriftCorrection" << endl; }
-	generateDriftCorrection(0.01);
-	if (m_debug) { cerr << "STEP 5: analyzeHoles" << endl; }
-	analyzeHoles();
-	if (m_debug) { cerr << "STEP 6: analyzeTears" << endl; }
-	analyzeTears();
-	if (m_debug) { cerr << "STEP 7: analyzeShifts" << endl; }
-	analyzeShifts();
-	if (m_debug) { cerr << "STEP 8: generateDriftCorrection" << endl; }
-	generateDriftCorrection(0.01);
-	if (m_debug) { cerr << "STEP 9: calculateHoleDescriptors" << endl; }
-	calculateHoleDescriptors();
-	if (m_debug) { cerr << "STEP 10: invalidateSkewedHoles" << endl; }
-	invalidateSkewedHoles();
-	if (m_debug) { cerr << "STEP 11: markPosteriorLeader" << endl; }
-	markPosteriorLeader();
-	if (m_debug) { cerr << "STEP 12: analyzeTrackerBarSpacing" << endl; }
-	storeCorrectedCentroidHistogram();
-	analyzeRawRowPositions();
-	analyzeTrackerBarSpacing();
-	if (m_debug) { cerr << "STEP 13: analyzeTrackerBarPositions" << endl; }
-	// analyzeTrackerBarPositions();
-	calculateTrackerSpacings2();
-	if (m_debug) { cerr << "STEP 14: analyzeHorizontalHolePosition" << endl; }
-	analyzeHorizontalHolePosition();
-	if (m_debug) { cerr << "STEP 15: analyzeMidiKeyMapping" << endl; }
-	analyzeMidiKeyMapping();
-	if (m_debug) { cerr << "STEP 16: invalidateEdgeHoles" << endl; }
-	invalidateEdgeHoles();
-	if (m_debug) { cerr << "STEP 17: invalidateOffTrackerHoles" << endl; }
-	invalidateOffTrackerHoles();
-	if (m_debug) { cerr << "STEP 18: recalculateFirstMusicHole" << endl; }
-	recalculateFirstMusicHole();
-	if (m_debug) { cerr << "STEP 19: addDriftInfoToHoles" << endl; }
-	addDriftInfoToHoles();
-	if (m_debug) { cerr << "STEP 20: addAntidustToBadHoles" << endl; }
-	addAntidustToBadHoles(50);
-	if (m_debug) { cerr << "STEP 21: assignMusicHoleIds" << endl; }
-	assignMusicHoleIds();
-	if (m_debug) { cerr << "STEP 22: groupHoles" << endl; }
-	groupHoles();
-	if (m_debug) { cerr << "STEP 23: analyzeSnakeBites" << endl; }
-	analyzeSnakeBites();
 	if (m_debug) { cerr << "STEP 24: FINSHED WITH ANALYSIS!" << endl; }
+	if (m_debug) {
+		ThreadPoolStatistics stats = ThreadPool::getShared().getStatistics();
+		cerr << "THREAD POOL: " << stats.threads << " threads, "
+		     << stats.tasks << " tasks, " << stats.steals << " steals, "
+		     << stats.inlineTasks << " inline tasks, "
+		     << stats.loops << " parallel loops" << endl;
+	}
 
 #ifndef DONOTUSEFFT
 	stop_time = std::chrono::system_clock::now();
@@ -434,19 +572,21 @@ void RollImage::addAntidustToBadHoles(ulongint areaThreshold) {
 
 //////////////////////////////
 //
-// RollImage::calculateHoleDescriptors -- also circularity
+// RollImage::calculateHoleDescriptors -- Circularity and major axis angle
+//    of holes, from the perimeter and central moments which were measured
+//    when the holes were extracted.  Each hole is independent, so the
+//    holes are processed in parallel.
 //
+
 void RollImage::calculateHoleDescriptors(void) {
-	for (ulongint i=0; i<holes.size(); i++) {
-		int status = calculateHolePerimeter(*holes[i]);
-		if (!status) {
-			// bad region so don't do any more calculations.
-			continue;
+	ThreadPool::getShared().parallelForEach(holes.size(), [this](ulongint i) {
+		if (holes[i]->perimeter <= 0.0) {
+			return;
 		}
 		holes[i]->circularity = 4 * M_PI * holes[i]->area /
 			holes[i]->perimeter / holes[i]->perimeter;
 		holes[i]->majoraxis = calculateMajorAxis(*holes[i]);
-	}
+	}, HOLE_GRAIN);
 }
 
 
@@ -554,31 +694,6 @@ void RollImage::assignMidiKeyNumbersToHoles(void) {
 
 
 
-//////////////////////////////
-//
-// RollImage::calculateCentralMoment --
-//
-
-double RollImage::calculateCentralMoment(HoleInfo& hole, int p, int q) {
-	std::pair<double, double> center = hole.centroid;
-	int ro = hole.origin.first;
-	int co = hole.origin.second;
-	double moment = 0.0;
-	ulongint r, c;
-	for (r=0; r<hole.width.first; r++) {
-		for (c=0; c<hole.width.second; c++) {
-			if (pixelType[r+ro][c+co] != PIX_HOLE) {
-				continue;
-			}
-			moment += pow(c+co - center.second, p) *
-					pow(r+ro - center.first, q);
-		}
-	}
-	return moment;
-}
-
-
-
 //////////////////////////////
 //
 // RollImage::calculateMajorAxis -- Major axis in degrees, with
@@ -586,9 +701,9 @@ double RollImage::calculateCentralMoment(HoleInfo& hole, int p, int q) {
 //
 
 double RollImage::calculateMajorAxis(HoleInfo& hole) {
-	double m11 = calculateCentralMoment(hole, 1, 1);
-	double m20 = calculateCentralMoment(hole, 2, 0);
-	double m02 = calculateCentralMoment(hole, 0, 2);
+	double m11 = hole.moment11;
+	double m20 = hole.moment20;
+	double m02 = hole.moment02;
 
 	double tan = 2 * m11 / (m20 - m02);
 	double angle = 0.5 * atan(tan);
@@ -599,116 +714,6 @@ double RollImage::calculateMajorAxis(HoleInfo& hole) {
 
 
 
-//////////////////////////////
-//
-// RollImage::calculateNormalCentralMoment --
-//
-
-double RollImage::calculateNormalCentralMoment(HoleInfo& hole, int p,
-		int q) {
-	double m00 = hole.area;
-	double norm = pow(m00, (double)(p+q+2)/2);
-	return calculateCentralMoment(hole, p, q) / norm;
-}
-
-
-
-//////////////////////////////
-//
-// RollImage::calculateHolePerimeter --
-//
-
-bool RollImage::calculateHolePerimeter(HoleInfo& hole) {
-	hole.perimeter = 0.0;
-	ulongint r;
-	long c;
-	r = hole.entry.first;
-	for (c=(int)hole.entry.second; c>=0; c--) {
-		if (pixelType.at(r).at(c) == PIX_PAPER) {
-			break;
-		}
-	}
-	if (pixelType[r][c] != PIX_PAPER) {
-		return 1;
-	}
-	pair<ulongint, ulongint> start(r, c);
-	pair<ulongint, ulongint> successor; // next point after starting point
-
-	pair<ulongint, ulongint> previous = start;
-	pair<ulongint, ulongint> current = previous;
-	int direction = 0;
-	direction = findNextPerimeterPoint(current, direction);
-	successor = current;
-	bool done = start == successor;
-
-	// pixelType[start.first][start.second] = PIX_DEBUG2;
-	// pixelType[successor.first][successor.second] = PIX_DEBUG2;
-
-	double sum = 0.0;
-
-	int counter = 0;
-	while (!done) {
-		previous = current;
-		direction = (direction + 6) % 8;
-		direction = findNextPerimeterPoint(current, direction);
-		if (direction < -100) {
-			// bad perimeter (on image edge)
-			return 0;
-		}
-		done = (current == successor) && (previous == start);
-		if (!done) {
-			//pixelType[current.first][current.second] = PIX_DEBUG5;
-			if (direction % 2) {
-				sum += 1.41421356237;
-			} else {
-				sum += 1;
-			}
-		}
-		if (++counter >= 100000) {
-			// failsafe
-			std::cerr << "PERIMETER SEARCH TOO LARGE" << std::endl;
-			break;
-		}
-	}
-
-	hole.perimeter = 0.95 * sum;
-	return 1;
-}
-
-
-
-//////////////////////////////
-//
-// RollImage::findNextPerimeterPoint --
-//
-
-int RollImage::findNextPerimeterPoint(pair<ulongint, ulongint>& point, int dir) {
-	int delta[][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1},
-		{-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
-	int r, c;
-	for (int i=0; i<7; i++) {
-		c = point.second + delta[dir][0];
-		r = point.first  + delta[dir][1];
-		if (c >= (int)getCols()) {
-			return -1000;
-		}
-		if (r >= (int)getRows()) {
-			return -1000;
-		}
-		if (pixelType.at(r).at(c) == PIX_HOLE) {
-			dir = (dir+1) % 8;
-		} else {
-			// pixelType[r][c] = PIX_DEBUG5;
-			point.first  = r;
-			point.second = c;
-			break;
-		}
-	}
-	return dir;
-}
-
-
-
 //////////////////////////////
 //
 // RollImage::analyzeMidiKeyMapping -- assign tracker bar positions
@@ -865,26 +870,38 @@ void RollImage::invalidateEdgeHoles(void) {
 // RollImage::invalidateSkewedHoles --  If non-circular holes are not
 //   vertically aligned, then they cannot be music holes, or the music
 //   holes are defective in some way.  Remove those holes to the badHole list.
+//   The holes are checked in parallel (clearHole() only changes the pixels
+//   of its own hole), and the bad holes of each block of holes are then
+//   added to badHoles in the original order.
 //
 
 void RollImage::invalidateSkewedHoles(void) {
-	for (ulongint i=0; i<holes.size(); i++) {
-		if (holes[i]->circularity > getCircularityThreshold()) {
-			// hole is too round to determine skew.
-			continue;
-		}
-		if (fabs(holes[i]->majoraxis) < getMajorAxisCutoff()) {
-			// hole is basically aligned in correct direction
-			continue;
-		}
-		// hole has a problem, probably a rip/tear/etc.
-		// std::cerr << "REMOVING " << holes[i]->origin.first
-		//		<< "\t" << holes[i]->circularity
-		//		<< "\t" << holes[i]->majoraxis
-		//		<< std::endl;
-		clearHole(*holes[i], PIX_BADHOLE_SKEWED);
-		holes[i]->reason = "skewed";
-		badHoles.push_back(holes[i]);
+	ulongint grain = HOLE_GRAIN;
+	std::vector<std::vector<HoleInfo*> > skewed((holes.size() + grain - 1) / grain);
+	ThreadPool::getShared().parallelFor(0, holes.size(), grain,
+			[this, grain, &skewed](ulongint start, ulongint end) {
+		std::vector<HoleInfo*>& found = skewed[start / grain];
+		for (ulongint i=start; i<end; i++) {
+			if (holes[i]->circularity > getCircularityThreshold()) {
+				// hole is too round to determine skew.
+				continue;
+			}
+			if (fabs(holes[i]->majoraxis) < getMajorAxisCutoff()) {
+				// hole is basically aligned in correct direction
+				continue;
+			}
+			// hole has a problem, probably a rip/tear/etc.
+			// std::cerr << "REMOVING " << holes[i]->origin.first
+			//		<< "\t" << holes[i]->circularity
+			//		<< "\t" << holes[i]->majoraxis
+			//		<< std::endl;
+			clearHole(*holes[i], PIX_BADHOLE_SKEWED);
+			holes[i]->reason = "skewed";
+			found.push_back(holes[i]);
+		}
+	});
+	for (ulongint i=0; i<skewed.size(); i++) {
+		badHoles.insert(badHoles.end(), skewed[i].begin(), skewed[i].end());
 	}
 }
 
@@ -897,12 +914,24 @@ void RollImage::invalidateSkewedHoles(void) {
 
 void RollImage::clearHole(HoleInfo& hi, int type) {
 	hi.setNonHole();
-	ulongint r = hi.entry.first;
-	ulongint c = hi.entry.second;
-	int target = pixelType[r][c];
-	int counter = 0;
-	fillHoleSimple(r, c, target, type, counter);
-	hi.setNonHole();
+	paintHole(hi, type);
+}
+
+
+
+//////////////////////////////
+//
+// RollImage::paintHole -- Set the pixel type of a hole from its stored
+//    pixel runs.  Only pixels which still have a hole type are changed,
+//    so bounding boxes of neighboring holes drawn over the hole are kept.
+//
+
+void RollImage::paintHole(HoleInfo& hi, int type) {
+	if (hi.component < 0) {
+		return;
+	}
+	holeComponents.paintComponent(pixelType, hi.component, type,
+			PIX_ANTIDUST, PIX_BADHOLE_ASPECT);
 }
 
 
@@ -1153,7 +1182,11 @@ void RollImage::storeCorrectedCentroidHistogram(void) {
 //
 // RollImage::analyzeTrackerBarSpacing -- Calculate the expected spacing of the
 //    tracker-bar holes.  Search for the first harmonic in the Fourier Transform
-//    which is at the frequency of the spacing of the holes.
+//    which is at the frequency of the spacing of the holes: a short FFT finds
+//    the nearest bin, and the peak between the neighboring bins is found with
+//    Goertzel evaluations of the spectrum (so the result does not depend on
+//    zero padding).  Without the FFT (DONOTUSEFFT), the bins are also found
+//    with the Goertzel filter.
 //
 
 void RollImage::analyzeTrackerBarSpacing(void) {
@@ -1165,52 +1198,67 @@ void RollImage::analyzeTrackerBarSpacing(void) {
 	leftside += padding;
 	rightside -= padding;
 
-	std::vector<mycomplex> spectrum;
-	int factor = 16;
-	std::vector<mycomplex> input(4096 * factor);
-	for (ulongint i=0; i<4096; i++) {
+	// Coarse search: find the largest bin of the spectrum of the
+	// histogram, skipping periods longer than 1000 pixels or shorter
+	// than 4 pixels.
+	ulongint size = 4096;
+	std::vector<double> input(size);
+	for (ulongint i=0; i<size; i++) {
 		input.at(i) = correctedCentroidHistogram.at(i);
 	}
-	for (ulongint i=4096; i<input.size(); i++) {
-		input.at(i) = 0.0;
-	}
-
+	ulongint minbin = 4;
+	ulongint maxbin = size / 4;
+	std::vector<double> magnitudeSpectrum(maxbin + 1, 0.0);
 #ifndef DONOTUSEFFT
-
-	FFT(spectrum, input);
-
-	vector<double> magnitudeSpectrum(spectrum.size());
-	int maxmagi = factor*2;
-	for (ulongint i=0 ;i<spectrum.size(); i++) {
+	std::vector<mycomplex> spectrum;
+	FFTPlan::getPlan(size).transformReal(spectrum, input);
+	for (ulongint i=minbin; i<=maxbin; i++) {
 		magnitudeSpectrum.at(i) = std::abs(spectrum.at(i));
-		if (i <= 50) {
-			continue;
-		}
-		if (i > spectrum.size()/4) {
-			continue;
-		}
-		if (magnitudeSpectrum.at(i) > magnitudeSpectrum.at(maxmagi)) {
-			maxmagi = i;
-		}
 	}
-
-	double y1 = magnitudeSpectrum.at(maxmagi-1);
-	double y2 = magnitudeSpectrum.at(maxmagi);
-	double y3 = magnitudeSpectrum.at(maxmagi+1);
-
-	double estimate = 4096.0 * factor / maxmagi;
-	double b = (y3 - y2)/2.0;
-	double a = y1/2.0 - y2 + y3/2.0;
-	double newi = -b / 2 / a / factor ;
-
-	// cerr << "PIXEL SEPARATION: " << estimate << " pixels\n";
-	// cerr << "REFINED PIXEL SEPARATION: " << newi << " pixels\n";
-	// cerr << "FINAL ANSWER: " << (estimate + newi) << " pixels\n";
-
-	holeSeparation = estimate + newi;
 #else
-	holeSeparation = 37.5;    /* for 8 holes/inch */
+	for (ulongint i=minbin; i<=maxbin; i++) {
+		magnitudeSpectrum.at(i) = getSpectralMagnitude(input, (double)i / size);
+	}
 #endif /* DONOTUSEFFT */
+	// The bins do not line up with the harmonics, so the largest bin may
+	// belong to a higher harmonic than the largest true peak.  Refine the
+	// largest local maxima of the bins: each true peak is within one bin
+	// of its local maximum, so zoom in on that band of the continuous
+	// spectrum (to 1/100000 of a bin, which is a few millionths of a
+	// pixel at 8 holes/inch), and keep the highest peak.
+	std::vector<std::pair<double, ulongint>> candidates;
+	for (ulongint i=minbin+1; i<maxbin; i++) {
+		double value = magnitudeSpectrum.at(i);
+		if ((value > magnitudeSpectrum.at(i-1)) && (value >= magnitudeSpectrum.at(i+1))) {
+			candidates.push_back(std::make_pair(value, i));
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(),
+			std::greater<std::pair<double, ulongint>>());
+	if (candidates.size() > 4) {
+		candidates.resize(4);
+	}
+	double peak = 0.0;
+	double peakMagnitude = -1.0;
+	for (ulongint i=0; i<candidates.size(); i++) {
+		ulongint bin = candidates[i].second;
+		double frequency = findSpectralPeak(input, (bin - 1.0) / size,
+				(bin + 1.0) / size, 0.00001 / size);
+		double magnitude = getSpectralMagnitude(input, frequency);
+		if (magnitude > peakMagnitude) {
+			peakMagnitude = magnitude;
+			peak = frequency;
+		}
+	}
+	if (peak <= 0.0) {
+		cerr << "Warning: no tracker-bar spacing found, assuming 8 holes/inch" << endl;
+		holeSeparation = 37.5;
+		return;
+	}
+
+	// cerr << "REFINED PIXEL SEPARATION: " << 1.0 / peak << " pixels\n";
+
+	holeSeparation = 1.0 / peak;
 
 	// cerr << "\n\nspectrum:\n";
 	// for (ulongint i=0; i<spectrum.size(); i++) {
@@ -1231,6 +1279,7 @@ void RollImage::describeTears(void) {
 	ulongint cols = getCols();
 
 	for (ulongint r=0; r<rows; r++) {
+		releasePixelBand(r);
 		for (ulongint c=0; c<cols/2; c++) {
 			if (pixelType[r][c] != PIX_TEAR) {
 				continue;
@@ -1240,6 +1289,7 @@ void RollImage::describeTears(void) {
 	}
 
 	for (ulongint r=0; r<rows; r++) {
+		releasePixelBand(r);
 		for (ulongint c=cols/2; c<cols; c++) {
 			if (pixelType[r][c] != PIX_TEAR) {
 				continue;
@@ -1374,6 +1424,7 @@ void RollImage::removeTearLeft(ulongint minrow, ulongint maxrow, ulongint mincol
 			pixelType[r][c] = PIX_MARGIN;
 			if (leftMarginIndex[r] < (int)c) {
 				leftMarginIndex[r] = c;
+				invalidateMarginSignals();
 			}
 		}
 	}
@@ -1397,6 +1448,7 @@ void RollImage::removeTearRight(ulongint minrow, ulongint maxrow, ulongint minco
 			pixelType[r][c] = PIX_MARGIN;
 			if (leftMarginIndex[r] > (int)c) {
 				leftMarginIndex[r] = c;
+				invalidateMarginSignals();
 			}
 		}
 	}
@@ -1412,27 +1464,16 @@ void RollImage::removeTearRight(ulongint minrow, ulongint maxrow, ulongint minco
 void RollImage::analyzeTears(void) {
 
 	ulongint rows = getRows();
-	std::vector<double> fastLeft(rows);
-	std::vector<double> fastRight(rows);
-	std::vector<double> mediumLeft(rows);
-	std::vector<double> mediumRight(rows);
-	std::vector<double> slowLeft(rows);
-	std::vector<double> slowRight(rows);
+	prepareMarginSignals({0.100, 0.050, 0.001});
+	const std::vector<double>& fastLeft    = getSmoothedLeftMargin(0.100);
+	const std::vector<double>& fastRight   = getSmoothedRightMargin(0.100);
+	const std::vector<double>& mediumLeft  = getSmoothedLeftMargin(0.050);
+	const std::vector<double>& mediumRight = getSmoothedRightMargin(0.050);
+	const std::vector<double>& slowLeft    = getSmoothedLeftMargin(0.001);
+	const std::vector<double>& slowRight   = getSmoothedRightMargin(0.001);
 
-	for (ulongint r=0; r<rows; r++) {
-		fastLeft[r]    = leftMarginIndex[r];
-		mediumLeft[r]  = leftMarginIndex[r];
-		slowLeft[r]    = leftMarginIndex[r];
-		fastRight[r]   = rightMarginIndex[r];
-		mediumRight[r] = rightMarginIndex[r];
-		slowRight[r]   = rightMarginIndex[r];
-	}
-	exponentialSmoothing(fastLeft,    0.100);
-	exponentialSmoothing(fastRight,   0.100);
-	exponentialSmoothing(mediumLeft,  0.050);
-	exponentialSmoothing(mediumRight, 0.050);
-	exponentialSmoothing(slowLeft,    0.001);
-	exponentialSmoothing(slowRight,   0.001);
+	// changed: the margins were adjusted since the curves were calculated.
+	bool changed = false;
 
 	ulongint startr = getFirstMusicHoleStart();
 	int rfactor = 300;  // expansion of tear search windows
@@ -1517,6 +1558,7 @@ void RollImage::analyzeTears(void) {
 	for (ulongint r=startr; r<rows; r++) {
 		if (stableLeft[r] && !stableRight[r]) {
 			int startindex = slowLeft[r] + avgwidth;
+			changed |= rightMarginIndex[r] != startindex;
 			rightMarginIndex[r] = startindex;
 			for (c=startindex; (c > 0) && (pixelType[r][c] == PIX_MARGIN); c--) {
 				pixelType[r][c] = PIX_TEAR;
@@ -1533,6 +1575,7 @@ void RollImage::analyzeTears(void) {
 
 		if (stableRight[r] && !stableLeft[r]) {
 			int startindex = slowRight[r] - avgwidth;
+			changed |= leftMarginIndex[r] != startindex;
 			leftMarginIndex[r] = startindex;
 			for (c=cols/2; c>=startindex; c--) {
 				if (pixelType[r][c] == PIX_MARGIN) {
@@ -1544,20 +1587,11 @@ void RollImage::analyzeTears(void) {
 
 
 	// recalculate curves
-	for (ulongint r=0; r<rows; r++) {
-		fastLeft[r]    = leftMarginIndex[r];
-		mediumLeft[r]  = leftMarginIndex[r];
-		slowLeft[r]    = leftMarginIndex[r];
-		fastRight[r]   = rightMarginIndex[r];
-		mediumRight[r] = rightMarginIndex[r];
-		slowRight[r]   = rightMarginIndex[r];
-	}
-	exponentialSmoothing(fastLeft,    0.100);
-	exponentialSmoothing(fastRight,   0.100);
-	exponentialSmoothing(mediumLeft,  0.050);
-	exponentialSmoothing(mediumRight, 0.050);
-	exponentialSmoothing(slowLeft,    0.001);
-	exponentialSmoothing(slowRight,   0.001);
+	if (changed) {
+		invalidateMarginSignals();
+		refreshMarginSignals();
+		changed = false;
+	}
 
 	int xvalue = 10;
 	// Initial marking of tears:
@@ -1570,6 +1604,7 @@ void RollImage::analyzeTears(void) {
 		}
 		if (leftMarginIndex[r] > slowLeft[r]) {
 			leftMarginIndex[r] = slowLeft[r];
+			changed = true;
 		}
 		for (c=slowLeft[r]; c<cols/2; c++) {
 			if (pixelType[r][c] == PIX_MARGIN) {
@@ -1586,6 +1621,7 @@ void RollImage::analyzeTears(void) {
 			continue;
 		}
 		if (rightMarginIndex[r] < slowRight[r]) {
+			changed |= rightMarginIndex[r] != (int)slowRight[r];
 			rightMarginIndex[r] = slowRight[r];
 		}
 		for (c=cols/2; c < slowRight[r]; c++) {
@@ -1597,20 +1633,11 @@ void RollImage::analyzeTears(void) {
 
 
 	// recalculate curves
-	for (ulongint r=0; r<rows; r++) {
-		fastLeft[r]    = leftMarginIndex[r];
-		mediumLeft[r]  = leftMarginIndex[r];
-		slowLeft[r]    = leftMarginIndex[r];
-		fastRight[r]   = rightMarginIndex[r];
-		mediumRight[r] = rightMarginIndex[r];
-		slowRight[r]   = rightMarginIndex[r];
-	}
-	exponentialSmoothing(fastLeft,    0.100);
-	exponentialSmoothing(fastRight,   0.100);
-	exponentialSmoothing(mediumLeft,  0.050);
-	exponentialSmoothing(mediumRight, 0.050);
-	exponentialSmoothing(slowLeft,    0.001);
-	exponentialSmoothing(slowRight,   0.001);
+	if (changed) {
+		invalidateMarginSignals();
+		refreshMarginSignals();
+		changed = false;
+	}
 
 	// do another fill to get closer to true edges without tears
 	for (ulongint r=startr; r<rows; r++) {
@@ -1622,6 +1649,7 @@ void RollImage::analyzeTears(void) {
 		}
 		if (leftMarginIndex[r] > slowLeft[r]) {
 				leftMarginIndex[r] = slowLeft[r];
+				changed = true;
 		}
 		for (c=slowLeft[r]; c<cols/2; c++) {
 			if (pixelType[r][c] == PIX_MARGIN) {
@@ -1638,6 +1666,7 @@ void RollImage::analyzeTears(void) {
 			continue;
 		}
 		if (rightMarginIndex[r] < slowRight[r]) {
+				changed |= rightMarginIndex[r] != (int)slowRight[r];
 				rightMarginIndex[r] = slowRight[r];
 		}
 		for (c=cols/2; c < slowRight[r]; c++) {
@@ -1649,20 +1678,11 @@ void RollImage::analyzeTears(void) {
 
 
 	// recaulate curves again
-	for (ulongint r=0; r<rows; r++) {
-		fastLeft[r]    = leftMarginIndex[r];
-		mediumLeft[r]  = leftMarginIndex[r];
-		slowLeft[r]    = leftMarginIndex[r];
-		fastRight[r]   = rightMarginIndex[r];
-		mediumRight[r] = rightMarginIndex[r];
-		slowRight[r]   = rightMarginIndex[r];
-	}
-	exponentialSmoothing(fastLeft,    0.100);
-	exponentialSmoothing(fastRight,   0.100);
-	exponentialSmoothing(mediumLeft,  0.050);
-	exponentialSmoothing(mediumRight, 0.050);
-	exponentialSmoothing(slowLeft,    0.001);
-	exponentialSmoothing(slowRight,   0.001);
+	if (changed) {
+		invalidateMarginSignals();
+		refreshMarginSignals();
+		changed = false;
+	}
 	// fill between the margin and the slow edges
 	for (ulongint r=startr; r<rows; r++) {
 		if (stableRegion[r]) {
@@ -1675,6 +1695,7 @@ void RollImage::analyzeTears(void) {
 		for (c=start; c>=slowLeft[r]; c--) {
 			if (pixelType[r][c] != PIX_PAPER) {
 				pixelType[r][c] = PIX_TEAR;
+				changed |= leftMarginIndex[r] != c;
 				leftMarginIndex[r] = c;
 			}
 		}
@@ -1691,12 +1712,16 @@ void RollImage::analyzeTears(void) {
 		for (c=start; c<=slowRight[r]; c++) {
 			if (pixelType[r][c] != PIX_PAPER) {
 				pixelType[r][c] = PIX_TEAR;
+				changed |= rightMarginIndex[r] != c;
 				rightMarginIndex[r] = c;
 			}
 		}
 	}
 
 
+	if (changed) {
+		invalidateMarginSignals();
+	}
 	describeTears();
 
 /*
@@ -1747,27 +1772,13 @@ void RollImage::analyzeTears(void) {
 
 void RollImage::analyzeShifts(void) {
 	ulongint rows = getRows();
-	std::vector<double> fastLeft(rows);
-	std::vector<double> fastRight(rows);
-	std::vector<double> mediumLeft(rows);
-	std::vector<double> mediumRight(rows);
-	std::vector<double> slowLeft(rows);
-	std::vector<double> slowRight(rows);
-
-	for (ulongint r=0; r<rows; r++) {
-		fastLeft[r]    = leftMarginIndex[r];
-		mediumLeft[r]  = leftMarginIndex[r];
-		slowLeft[r]    = leftMarginIndex[r];
-		fastRight[r]   = rightMarginIndex[r];
-		mediumRight[r] = rightMarginIndex[r];
-		slowRight[r]   = rightMarginIndex[r];
-	}
-	exponentialSmoothing(fastLeft,    0.100);
-	exponentialSmoothing(fastRight,   0.100);
-	exponentialSmoothing(mediumLeft,  0.050);
-	exponentialSmoothing(mediumRight, 0.050);
-	exponentialSmoothing(slowLeft,    0.001);
-	exponentialSmoothing(slowRight,   0.001);
+	prepareMarginSignals({0.100, 0.050, 0.001});
+	const std::vector<double>& fastLeft    = getSmoothedLeftMargin(0.100);
+	const std::vector<double>& fastRight   = getSmoothedRightMargin(0.100);
+	const std::vector<double>& mediumLeft  = getSmoothedLeftMargin(0.050);
+	const std::vector<double>& mediumRight = getSmoothedRightMargin(0.050);
+	const std::vector<double>& slowLeft    = getSmoothedLeftMargin(0.001);
+	const std::vector<double>& slowRight   = getSmoothedRightMargin(0.001);
 
 	int wfactor = 5;    // trigger deviation between slow margin and raw margin
 
@@ -2032,16 +2043,8 @@ ulongint RollImage::findPeak(std::vector<double>& array, ulongint r, ulongint& p
 void RollImage::generateDriftCorrection(double gain) {
 
 	ulongint rows = getRows();
-	std::vector<double> lmargin(rows);
-	std::vector<double> rmargin(rows);
-
-	for (ulongint r=0; r<rows; r++) {
-		lmargin[r] = leftMarginIndex[r];
-		rmargin[r] = rightMarginIndex[r];
-	}
-
-	exponentialSmoothing(lmargin, gain);
-	exponentialSmoothing(rmargin, gain);
+	const std::vector<double>& lmargin = getSmoothedLeftMargin(gain);
+	const std::vector<double>& rmargin = getSmoothedRightMargin(gain);
 
 	ulongint startrow = getLeaderIndex() + 100;
 	ulongint endrow   = getRows() - 100;
@@ -2070,6 +2073,205 @@ void RollImage::generateDriftCorrection(double gain) {
 
 
 
+//////////////////////////////
+//
+// RollImage::getSmoothedLeftMargin -- Return leftMarginIndex smoothed with
+//    exponentialSmoothing() at the given gain.  The curve is calculated the
+//    first time that it is needed and kept until the margins change (see
+//    invalidateMarginSignals()), so the tear, shift and drift analyses
+//    share the same curves.
+//
+
+const std::vector<double>& RollImage::getSmoothedLeftMargin(double gain) {
+	return getMarginSignal(0, gain);
+}
+
+
+
+//////////////////////////////
+//
+// RollImage::getSmoothedRightMargin -- Same as getSmoothedLeftMargin() for
+//    rightMarginIndex.
+//
+
+const std::vector<double>& RollImage::getSmoothedRightMargin(double gain) {
+	return getMarginSignal(1, gain);
+}
+
+
+
+//////////////////////////////
+//
+// RollImage::getMarginSignal -- Return the smoothed curve for a margin
+//    side (0 = left, 1 = right), recalculating it if the margins changed
+//    since it was stored.  The returned vector stays at the same address
+//    until clearMarginSignals() is called.
+//
+
+const std::vector<double>& RollImage::getMarginSignal(int side, double gain) {
+	std::vector<std::pair<int, double> > keys(1, std::make_pair(side, gain));
+	updateMarginSignals(keys);
+	lock_guard<mutex> guard(m_marginSignalLock);
+	return m_marginSignals[keys[0]].values;
+}
+
+
+
+//////////////////////////////
+//
+// RollImage::prepareMarginSignals -- Calculate the left and right margin
+//    curves for several gains together, which lets smoothSignals() filter
+//    them side-by-side in SIMD lanes.
+//
+
+void RollImage::prepareMarginSignals(const std::vector<double>& gains) {
+	std::vector<std::pair<int, double> > keys;
+	for (ulongint i=0; i<gains.size(); i++) {
+		keys.push_back(std::make_pair(0, gains[i]));
+		keys.push_back(std::make_pair(1, gains[i]));
+	}
+	updateMarginSignals(keys);
+}
+
+
+
+//////////////////////////////
+//
+// RollImage::updateMarginSignals -- Recalculate the curves in the list
+//    which are out of date, all in one call to smoothSignals().  The lock
+//    is held while filtering, which is safe since threads waiting on the
+//    shared ThreadPool only run tasks of their own group.
+//
+
+void RollImage::updateMarginSignals(const std::vector<std::pair<int, double> >& keys) {
+	lock_guard<mutex> guard(m_marginSignalLock);
+	std::vector<std::vector<double>*> signals;
+	std::vector<double> gains;
+	for (ulongint i=0; i<keys.size(); i++) {
+		MarginSignal& signal = m_marginSignals[keys[i]];
+		if (signal.version == m_marginVersion) {
+			continue;
+		}
+		std::vector<int>& margin = keys[i].first ? rightMarginIndex : leftMarginIndex;
+		signal.values.assign(margin.begin(), margin.end());
+		signal.version = m_marginVersion;
+		signals.push_back(&signal.values);
+		gains.push_back(keys[i].second);
+	}
+	smoothSignals(signals, gains, getSmoothingMode());
+}
+
+
+
+//////////////////////////////
+//
+// RollImage::invalidateMarginSignals -- Called after leftMarginIndex or
+//    rightMarginIndex were changed.  The smoothed curves are recalculated
+//    the next time that they are requested.
+//
+
+void RollImage::invalidateMarginSignals(void) {
+	lock_guard<mutex> guard(m_marginSignalLock);
+	m_marginVersion++;
+}
+
+
+
+//////////////////////////////
+//
+// RollImage::refreshMarginSignals -- Recalculate all stored curves which
+//    are out of date, for functions that keep references to the curves
+//    while changing the margins.
+//
+
+void RollImage::refreshMarginSignals(void) {
+	std::vector<std::pair<int, double> > keys;
+	{
+		lock_guard<mutex> guard(m_marginSignalLock);
+		for (auto& it : m_marginSignals) {
+			keys.push_back(it.first);
+		}
+	}
+	updateMarginSignals(keys);
+}
+
+
+
+//////////////////////////////
+//
+// RollImage::getDataBytes -- Estimate the size in bytes of the analysis
+//    data in the DATA_* mask (used for the profile of the analysis steps,
+//    which declare the data that they read and write).
+//
+
+ulonglongint RollImage::getDataBytes(ulongint mask) {
+	ulonglongint rows = getRows();
+	ulonglongint cols = getCols();
+	ulonglongint bytes = 0;
+	if (mask & DATA_PIXELS) {
+		bytes += rows * cols * sizeof(pixtype);
+	}
+	if (mask & DATA_MARGINS) {
+		bytes += (leftMarginIndex.size() + rightMarginIndex.size()) * sizeof(int);
+	}
+	if (mask & DATA_DRIFT) {
+		bytes += driftCorrection.size() * sizeof(double);
+	}
+	if (mask & DATA_HOLES) {
+		bytes += holes.size() * sizeof(HoleInfo);
+	}
+	if (mask & DATA_BADHOLES) {
+		bytes += badHoles.size() * sizeof(HoleInfo);
+	}
+	if (mask & DATA_SHIFTS) {
+		bytes += shifts.size() * sizeof(ShiftInfo);
+	}
+	if (mask & DATA_TRACKER) {
+		bytes += (correctedCentroidHistogram.size()
+				+ uncorrectedCentroidHistogram.size()) * sizeof(int);
+	}
+	return bytes;
+}
+
+
+
+//////////////////////////////
+//
+// RollImage::addDataCounters -- Add the counts of the analysis results in
+//    the DATA_* mask to the profile (only for data which the calling step
+//    writes, since other steps may be changing the rest).
+//
+
+void RollImage::addDataCounters(ulongint mask) {
+	if (mask & DATA_HOLES) {
+		m_profiler.addCounter("holes", holes.size());
+	}
+	if (mask & DATA_BADHOLES) {
+		m_profiler.addCounter("bad holes", badHoles.size());
+	}
+	if (mask & DATA_TEARS) {
+		m_profiler.addCounter("tears", bassTears.size() + trebleTears.size());
+	}
+	if (mask & DATA_SHIFTS) {
+		m_profiler.addCounter("shifts", shifts.size());
+	}
+}
+
+
+
+//////////////////////////////
+//
+// RollImage::clearMarginSignals -- Free the memory of the smoothed margin
+//    curves.
+//
+
+void RollImage::clearMarginSignals(void) {
+	lock_guard<mutex> guard(m_marginSignalLock);
+	m_marginSignals.clear();
+}
+
+
+
 //////////////////////////////
 //
 // RollImage::markPosteriorLeader --
@@ -2105,7 +2307,11 @@ void RollImage::markPosteriorLeader(void) {
 
 //////////////////////////////
 //
-// RollImage::analyzeHoles --
+// RollImage::analyzeHoles -- Find the groups of non-paper pixels inside
+//    of the hard margins (after the leader).  A hole may extend outside of
+//    this region.  The image is labeled in parallel bands (see
+//    setThreadCount()), and holes are then processed in the order in
+//    which a scan of the region would encounter them.
 //
 
 void RollImage::analyzeHoles(void) {
@@ -2115,17 +2321,40 @@ void RollImage::analyzeHoles(void) {
 	ulongint endrow   = getRows();
 	holes.clear();
 	holes.reserve(getMaxHoleCount() + 1024);
+	if (endcol <= startcol) {
+		expandPixelRuns();
+		return;
+	}
 
-	for (ulongint r=startrow; r<endrow; r++) {
-		for (int c=startcol; c<endcol; c++) {
-			if (pixelType.at(r).at(c) == PIX_NONPAPER) {
-				extractHole(r, c);
-				if ((int)holes.size() > getMaxHoleCount()) {
-					cerr << "Too many holes, giving up after " << getMaxHoleCount() << " holes." << endl;
-					return;
-				}
+	holeComponents.clear();
+	holeComponents.setThreadCount(getThreadCount());
+	holeComponents.setSeedWindow(startrow, endrow, startcol, endcol);
+	holeComponents.setSkipMask(paperMask.empty() ? NULL : &paperMask);
+	ulongint count;
+	if (!pixelRuns.empty()) {
+		count = holeComponents.label(pixelRuns, PIX_NONPAPER);
+	} else {
+		count = holeComponents.label(pixelType, PIX_NONPAPER);
+	}
+	// Holes are painted into pixelType:
+	expandPixelRuns();
+	ulongint released = 0;  // rows above this are out of memory (banded mode)
+	for (ulongint i=0; i<count; i++) {
+		if (m_bandRows > 0) {
+			// components are in row order, so the bands which are two
+			// bands above the current component are finished:
+			ulongint row = holeComponents.getComponent(i).minrow;
+			if (row >= released + 2 * m_bandRows) {
+				ulongint amount = (row - released) / m_bandRows * m_bandRows - m_bandRows;
+				releasePixelRows(released, amount);
+				released += amount;
 			}
 		}
+		extractHole(holeComponents, i);
+		if ((int)holes.size() > getMaxHoleCount()) {
+			cerr << "Too many holes, giving up after " << getMaxHoleCount() << " holes." << endl;
+			return;
+		}
 	}
 }
 
@@ -2133,34 +2362,39 @@ void RollImage::analyzeHoles(void) {
 
 //////////////////////////////
 //
-// RollImage::extractHole --
+// RollImage::extractHole -- Store a component found by analyzeHoles()
+//    as a hole, or as antidust if it is too small to be a musical hole.
 //
 
-void RollImage::extractHole(ulongint row, ulongint col) {
+void RollImage::extractHole(ComponentLabeler& labeler, ulongint index) {
+	ComponentInfo& component = labeler.getComponent(index);
 	HoleInfo* hi = new HoleInfo;
 
-	hi->origin.first = row;
-	hi->origin.second = col;
-	hi->width.first = row;
-	hi->width.second = col;
-
-	int counter = 0;
-	fillHoleInfo(*hi, row, col, counter);
-	hi->entry.first  = row;
-	hi->entry.second = col;
-	hi->centroid.first  /= hi->area;
-	hi->centroid.second /= hi->area;
+	hi->origin.first    = component.minrow;
+	hi->origin.second   = component.mincol;
+	hi->area            = component.area;
+	hi->centroid.first  = (double)component.rowsum / hi->area;
+	hi->centroid.second = (double)component.colsum / hi->area;
+	hi->entry.first     = component.entryrow;
+	hi->entry.second    = component.entrycol;
+	hi->component       = index;
+	// 0.95 keeps circularity on the scale used for getCircularityThreshold():
+	hi->perimeter       = 0.95 * component.perimeter;
+	hi->moment20        = component.moment20;
+	hi->moment02        = component.moment02;
+	hi->moment11        = component.moment11;
 	// hi->coldrift set in RollImage::generateDriftCorrection.
 
-	ulongint testFirst = hi->origin.first;
-	ulongint testLast  = hi->width.first;
+	ulongint testFirst = component.minrow;
+	ulongint testLast  = component.maxrow;
 
-	// Convert lower right corner corrdinate into a width:
-	hi->width.first  = hi->width.first  - hi->origin.first;
-	hi->width.second = hi->width.second - hi->origin.second;
+	// Store lower right corner as a width:
+	hi->width.first  = component.maxrow - component.minrow;
+	hi->width.second = component.maxcol - component.mincol;
 
 	ulongint minarea = 100;
 	if (hi->area > minarea) {
+		labeler.paintComponent(pixelType, index, PIX_HOLE);
 		holes.push_back(hi);
 		if ((firstMusicRow == 0) || (testFirst < firstMusicRow)) {
 			firstMusicRow = testFirst;
@@ -2170,7 +2404,8 @@ void RollImage::extractHole(ulongint row, ulongint col) {
 		}
 	} else {
 		// Too small to be considered a musical hole.
-		clearHole(*hi, PIX_ANTIDUST);
+		labeler.paintComponent(pixelType, index, PIX_ANTIDUST);
+		hi->setNonHole();
 		hi->reason = "small";
 		hi->track = 0;
 		antidust.push_back(hi);
@@ -2181,258 +2416,662 @@ void RollImage::extractHole(ulongint row, ulongint col) {
 
 //////////////////////////////
 //
-// RollImage::fillHoleSimple --
+// RollImage::fillTearInfo --
 //
 
-void RollImage::fillHoleSimple(ulongint r, ulongint c, int target, int type, int& counter) {
+void RollImage::fillTearInfo(TearInfo& ti, ulongint r, ulongint c, int& counter) {
 	counter++;
-	if (counter > getMaxHoleCount()) {
-		// cerr << "CLEARING TOO LARGE A HOLE!" << endl;
+	if (counter > getMaxTearFill()) {
+		cerr << "ERROR TEAR TOO LARGE" << endl;
 		return;
 	}
+
 	if (r >= getRows()) {
 		return;
 	}
 	if (c >= getCols()) {
 		return;
 	}
-	if (pixelType.at(r).at(c) != target) {
-		return;
+
+	if (pixelType.at(r).at(c)== PIX_NONPAPER) {
+		pixelType.at(r).at(c) = PIX_TEAR;
+	} else if (pixelType.at(r).at(c) == PIX_MARGIN) {
+		pixelType.at(r).at(c) = PIX_TEAR;
 	} else {
-		pixelType.at(r).at(c) = type;
+		return;
 	}
-	if ((r > 0) && (c > 0)) {
-		fillHoleSimple(r-1, c-1, target, type, counter);
+
+	if (ti.origin.first == 0) {
+		ti.origin.first = r;
+	} else if (r < ti.origin.first) {
+		ti.origin.first = r;
 	}
-	if (r > 0) {
-		fillHoleSimple(r-1, c  , target, type, counter);
+
+	if (ti.origin.second == 0) {
+		ti.origin.second = c;
+	} else if (c < ti.origin.second) {
+		ti.origin.second = c;
+	}
+
+	if (ti.width.first == 0) {
+		ti.width.first = r;
+	} else if (r > ti.width.first) {
+		ti.width.first = r;
+	}
+
+	if (ti.width.second == 0) {
+		ti.width.second = c;
+	} else if (c > ti.width.second) {
+		ti.width.second = c;
+	}
+
+	ti.area++;
+	ti.centroid.first  += r;
+	// ti.centroid.second += c + driftCorrection[r];
+	ti.centroid.second += c ;
+
+	if ((c > 0) && (r > 0)) {
+		fillTearInfo(ti, r-1, c-1, counter);
 	}
 	if (r > 0) {
-		fillHoleSimple(r-1, c+1, target, type, counter);
+		fillTearInfo(ti, r-1, c  , counter);
+		fillTearInfo(ti, r-1, c+1, counter);
 	}
 	if (c > 0) {
-		fillHoleSimple(r  , c-1, target, type, counter);
+		fillTearInfo(ti, r  , c-1, counter);
 	}
-	fillHoleSimple(r  , c+1, target, type, counter);
+	fillTearInfo(ti, r  , c+1, counter);
 	if (c > 0) {
-		fillHoleSimple(r+1, c-1, target, type, counter);
+		fillTearInfo(ti, r+1, c-1, counter);
 	}
-	fillHoleSimple(r+1, c  , target, type, counter);
-	fillHoleSimple(r+1, c+1, target, type, counter);
+	fillTearInfo(ti, r+1, c  , counter);
+	fillTearInfo(ti, r+1, c+1, counter);
+}
+
+
 
+//////////////////////////////
+//
+// RollImage::analyzeAdvancedMargins -- Separate the hard and soft margins.
+//
+
+void RollImage::analyzeAdvancedMargins(void) {
+	analyzeHardMargins(getLeaderIndex());
+	m_analyzedAdvancedMargins = true;
 }
 
 
 
 //////////////////////////////
 //
-// RollImage::fillHoleInfo --
+// RollImage::analyzeBasicMargins --
 //
 
-void RollImage::fillHoleInfo(HoleInfo& hi, ulongint r, ulongint c, int& counter) {
-	counter++;
-	if (counter > 300000) {
-		cerr << "HOLE TOO BIG " << endl;
+void RollImage::analyzeBasicMargins(void) {
+	if (getMarginFloodFill()) {
+		if (!pixelRuns.empty()) {
+			floodFillMarginRuns();
+		} else {
+			floodFillMargins();
+		}
+		invalidateMarginSignals();
+		m_analyzedBasicMargins = true;
 		return;
 	}
 
-	if (r >= getRows()) {
+	if (!pixelRuns.empty()) {
+		getRawMarginRuns();
+		waterfallDownMarginRuns();
+		waterfallUpMarginRuns();
+		waterfallLeftMarginRuns();
+		waterfallRightMarginRuns();
+		invalidateMarginSignals();
+		m_analyzedBasicMargins = true;
 		return;
 	}
-	if (c >= getCols()) {
+
+	getRawMargins();
+	waterfallDownMargins();
+	waterfallUpMargins();
+	waterfallLeftMargins();
+	waterfallRightMargins();
+
+	invalidateMarginSignals();
+	m_analyzedBasicMargins = true;
+}
+
+
+//////////////////////////////
+//
+// RollImage::getRawMargins -- Identifies the pixel position of the
+//   left and right margins. The index value stored in the margins
+//   is the closest pixel in the margin to the paper, searched
+//   by moving horizontally from the edge of the image.  Dust will
+//   cause problems that are fixed later in waterfallDownMargins().
+//
+
+void RollImage::getRawMargins(void) {
+	ulongint rows = getRows();
+	ulongint cols = getCols();
+
+	leftMarginIndex.resize(rows);
+	rightMarginIndex.resize(rows);
+
+	int startcol = 5; // starting a little off of the margin due to digital noise
+	                  // the second and third columns.
+	if ((ulongint)startcol >= cols) {
+		std::fill(leftMarginIndex.begin(), leftMarginIndex.end(), 0);
+		std::fill(rightMarginIndex.begin(), rightMarginIndex.end(), 0);
 		return;
 	}
+	if (paperMask.empty()) {
+		storePaperMask();
+	}
 
-	if (pixelType.at(r).at(c) != PIX_NONPAPER) {
-		return;
-	} else {
-		pixelType.at(r).at(c) = PIX_HOLE;
+	// Everything between the image edge and the first paper pixel is
+	// non-paper, so it is all margin:
+	for (ulongint r=0; r<rows; r++) {
+		releasePixelBand(r);
+		ucharint* rowdata = pixelType.getRow(r);
+		long paper = paperMask.findSet(r, startcol);
+		ulongint end = paper < 0 ? cols : (ulongint)paper;
+		std::fill(rowdata + startcol, rowdata + end, (ucharint)PIX_MARGIN);
+		leftMarginIndex[r] = (int)end - 1;
+	}
+
+	releasePixelRows(0, rows);
+	for (ulongint r=0; r<rows; r++) {
+		releasePixelBand(r);
+		ucharint* rowdata = pixelType.getRow(r);
+		long paper = paperMask.findSetReverse(r, cols-1-startcol);
+		std::fill(rowdata + paper + 1, rowdata + cols - startcol, (ucharint)PIX_MARGIN);
+		rightMarginIndex[r] = (int)(paper + 1);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// RollImage::waterfallDownMargins -- Fill in margin areas that are blocked
+//     from the left/right by dust.
+//
+
+void RollImage::waterfallDownMargins(void) {
+	ulongint rows = getRows();
+	int cols = (int)getCols();
+
+	for (ulongint r=0; r<rows-1; r++) {
+		releasePixelBand(r);
+		ImagePlane<pixtype>::RowSpan row1 = pixelType[r];
+		ImagePlane<pixtype>::RowSpan row2 = pixelType[r+1];
+		for (int c=0; c<cols; c++) {
+			if (row1[c] != PIX_MARGIN) {
+				continue;
+			}
+			if (row2[c] != PIX_PAPER) {
+				row2[c] = PIX_MARGIN;
+				if (c < cols/2) {
+					if (c > leftMarginIndex[r+1]) {
+						leftMarginIndex[r+1] = c;
+					}
+				} else {
+					if (c < rightMarginIndex[r+1]) {
+						rightMarginIndex[r+1] = c;
+					}
+				}
+			}
+		}
 	}
-	if (r < hi.origin.first) {
-		hi.origin.first = r;
+}
+
+
+
+//////////////////////////////
+//
+// RollImage::waterfallUpMargins -- Fill in margin areas that are blocked
+//     from the left/right by dust by going up from bottom of image.
+//
+
+void RollImage::waterfallUpMargins(void) {
+	ulongint rows = getRows();
+	ulongint cols = getCols();
+
+	for (ulongint r=rows-1; r>0; r--) {
+		releasePixelBand(r, true);
+		ImagePlane<pixtype>::RowSpan row1 = pixelType.at(r);
+		ImagePlane<pixtype>::RowSpan row2 = pixelType.at(r-1);
+		for (ulongint c=0; c<cols; c++) {
+			if (row1.at(c) != PIX_MARGIN) {
+				continue;
+			}
+			if (row2.at(c) != PIX_PAPER) {
+				row2.at(c) = PIX_MARGIN;
+				if (c < cols/2) {
+					if (c > (ulongint)leftMarginIndex.at(r-1)) {
+						leftMarginIndex.at(r-1) = c;
+					}
+				} else {
+					if (c < (ulongint)rightMarginIndex.at(r-1)) {
+						rightMarginIndex.at(r-1) = c;
+					}
+				}
+			}
+		}
 	}
-	if (c < hi.origin.second) {
-		hi.origin.second = c;
+}
+
+
+
+//////////////////////////////
+//
+// RollImage::waterfallRightMargins -- Fill in margin areas that are blocked
+//     from up/down by dust by going right from the left side of the image.
+//     This function is needed to go around fingerprints to avoid spurious
+//     hole detection on the edges of the roll.
+//
+//     Margin only moves along a row, so each row is processed in one pass
+//     (rather than column by column over all rows).  Updates to the right
+//     margin for row r are stored in rightMarginIndex[r-1] (this was the
+//     result of the column-by-column loop) after comparing against
+//     rightMarginIndex[r], which the row below may already have changed
+//     at an earlier column.  Such an update is always to the left of the
+//     current column, so the comparison then always fails.  So each row
+//     only updates the row above until the first column at which the row
+//     below made an update.  Rows are processed from the bottom up, and
+//     the update to a row is applied after that row has been processed.
+//
+
+void RollImage::waterfallRightMargins(void) {
+	ulongint rows = getRows();
+	ulongint cols = getCols();
+
+	ulongint belowFirst = cols;  // first column updated by the row below
+	int      pending    = -1;    // update from the row below for this row
+	for (ulongint r=rows; r>0; ) {
+		r--;
+		releasePixelBand(r, true);
+		ucharint* rowdata = pixelType.getRow(r);
+		ulongint original = (ulongint)rightMarginIndex.at(r);
+		ulongint first = cols;
+		int last = -1;
+		for (ulongint c=0; c<cols-1; c++) {
+			if (rowdata[c] != PIX_MARGIN) {
+				continue;
+			}
+			if (rowdata[c+1] == PIX_PAPER) {
+				continue;
+			}
+			rowdata[c+1] = PIX_MARGIN;
+			if (c < cols/2) {
+				if (c+1 > (ulongint)leftMarginIndex[r]) {
+					leftMarginIndex[r] = c+1;
+				}
+			} else if ((c+1 < original) && (c <= belowFirst)) {
+				if (first == cols) {
+					first = c;
+				}
+				last = c+1;
+			}
+		}
+		if (pending >= 0) {
+			rightMarginIndex[r] = pending;
+		}
+		pending = last;
+		belowFirst = first;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// RollImage::waterfallLeftMargins -- Fill in margin areas that are blocked
+//     from up/down by dust by going left from the right side of the image.
+//     This function is needed to go around fingerprints to avoid spurious
+//     hole detection on the edges of the roll.  Rows do not depend on each
+//     other, so each row is processed in one pass.
+//
+
+void RollImage::waterfallLeftMargins(void) {
+	ulongint rows = getRows();
+	ulongint cols = getCols();
+
+	for (ulongint r=0; r<rows; r++) {
+		releasePixelBand(r);
+		ucharint* rowdata = pixelType.getRow(r);
+		for (ulongint c=cols-1; c>0; c--) {
+			if (rowdata[c] != PIX_MARGIN) {
+				continue;
+			}
+			if (rowdata[c-1] == PIX_PAPER) {
+				continue;
+			}
+			rowdata[c-1] = PIX_MARGIN;
+			if (c < cols/2) {
+				if (c-1 > (ulongint)leftMarginIndex[r]) {
+					leftMarginIndex[r] = c-1;
+				}
+			} else {
+				if (c-1 < (ulongint)rightMarginIndex[r]) {
+					rightMarginIndex[r] = c-1;
+				}
+			}
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// RollImage::floodFillMargins -- Alternative to getRawMargins() and the
+//     four waterfall passes (see setMarginFloodFill()): every non-paper
+//     pixel which is connected (horizontally or vertically) to the
+//     non-paper pixels at the starting columns of getRawMargins() is
+//     marked as margin, including pockets that the straight sweeps cannot
+//     reach.  leftMarginIndex/rightMarginIndex are the innermost margin
+//     pixels in the left/right half of each row.  The image is filled in
+//     parallel row bands (see setThreadCount()), and then the fill is
+//     continued across the seams between the bands.
+//
+
+void RollImage::floodFillMargins(void) {
+	ulongint rows = getRows();
+	ulongint cols = getCols();
+	ulongint startcol = 5;
+	if (cols <= startcol) {
+		leftMarginIndex.assign(rows, 0);
+		rightMarginIndex.assign(rows, 0);
+		return;
+	}
+	leftMarginIndex.assign(rows, (int)startcol - 1);
+	rightMarginIndex.assign(rows, (int)(cols - startcol));
+
+	ulongint minBandRows = 256;
+	ulongint bandcount = getThreadCount();
+	if (bandcount > rows / minBandRows) {
+		bandcount = rows / minBandRows;
 	}
-	if (r > hi.width.first) {
-		hi.width.first = r;
+	if (bandcount < 1) {
+		bandcount = 1;
 	}
-	if (c > hi.width.second) {
-		hi.width.second = c;
+	vector<ulongint> bandstart(bandcount + 1);
+	for (ulongint i=0; i<=bandcount; i++) {
+		bandstart[i] = rows * i / bandcount;
 	}
-	hi.area++;
-	hi.centroid.first  += r;
-	// hi.centroid.second += c + driftCorrection[r];
-	hi.centroid.second += c;
 
-	if ((r > 0) && (c > 0)) {
-		fillHoleInfo(hi, r-1, c-1, counter);
+	if (bandcount == 1) {
+		floodFillMarginBand(0, rows);
+	} else {
+		ThreadPool::getShared().parallelForEach(bandcount, [this, &bandstart](ulongint i) {
+			floodFillMarginBand(bandstart[i], bandstart[i+1]);
+		});
+
+		// Continue the fill across the seams between bands:
+		vector<ComponentRun> stack;
+		for (ulongint i=1; i<bandcount; i++) {
+			ucharint* above = pixelType.getRow(bandstart[i] - 1);
+			ucharint* below = pixelType.getRow(bandstart[i]);
+			for (ulongint c=0; c<cols; c++) {
+				if ((above[c] == PIX_MARGIN) && (below[c] == PIX_NONPAPER)) {
+					fillMarginSpan(bandstart[i], c, stack);
+				} else if ((below[c] == PIX_MARGIN) && (above[c] == PIX_NONPAPER)) {
+					fillMarginSpan(bandstart[i] - 1, c, stack);
+				}
+			}
+		}
+		fillMarginSpans(stack, 0, rows);
 	}
-	if (r > 0) {
-		fillHoleInfo(hi, r-1, c  , counter);
-		fillHoleInfo(hi, r-1, c+1, counter);
+
+	// Rows without paper are all margin (as in getRawMargins()):
+	if (paperMask.empty()) {
+		storePaperMask();
 	}
-	if (c > 0) {
-		fillHoleInfo(hi, r  , c-1, counter);
+	for (ulongint r=0; r<rows; r++) {
+		if (paperMask.findSet(r, 0) < 0) {
+			leftMarginIndex[r]  = (int)cols - 1;
+			rightMarginIndex[r] = 0;
+		}
 	}
-	fillHoleInfo(hi, r  , c+1, counter);
-	if (c > 0) {
-		fillHoleInfo(hi, r+1, c-1, counter);
+}
+
+
+
+//////////////////////////////
+//
+// RollImage::floodFillMarginBand -- Fill the margins of rows
+//     [startrow, endrow) without going outside of the band.
+//
+
+void RollImage::floodFillMarginBand(ulongint startrow, ulongint endrow) {
+	ulongint cols = getCols();
+	ulongint startcol = 5;
+	vector<ComponentRun> stack;
+	for (ulongint r=startrow; r<endrow; r++) {
+		if (pixelType.getRow(r)[startcol] == PIX_NONPAPER) {
+			fillMarginSpan(r, startcol, stack);
+		}
+		if (pixelType.getRow(r)[cols-1-startcol] == PIX_NONPAPER) {
+			fillMarginSpan(r, cols-1-startcol, stack);
+		}
+		fillMarginSpans(stack, startrow, endrow);
 	}
-	fillHoleInfo(hi, r+1, c  , counter);
-	fillHoleInfo(hi, r+1, c+1, counter);
 }
 
 
 
 //////////////////////////////
 //
-// RollImage::fillTearInfo --
+// RollImage::fillMarginSpans -- Process the stack of margin spans which
+//     have been filled, filling the non-paper pixels which touch them on
+//     the rows above and below (only for rows [startrow, endrow)).
 //
 
-void RollImage::fillTearInfo(TearInfo& ti, ulongint r, ulongint c, int& counter) {
-	counter++;
-	if (counter > getMaxTearFill()) {
-		cerr << "ERROR TEAR TOO LARGE" << endl;
-		return;
-	}
-
-	if (r >= getRows()) {
-		return;
-	}
-	if (c >= getCols()) {
-		return;
+void RollImage::fillMarginSpans(vector<ComponentRun>& stack, ulongint startrow,
+		ulongint endrow) {
+	while (!stack.empty()) {
+		ComponentRun span = stack.back();
+		stack.pop_back();
+		for (int dir=-1; dir<=1; dir+=2) {
+			if ((dir < 0) && (span.row <= startrow)) {
+				continue;
+			}
+			if ((dir > 0) && (span.row + 1 >= endrow)) {
+				continue;
+			}
+			ulongint r = span.row + dir;
+			const ucharint* rowdata = pixelType.getRow(r);
+			for (ulongint c=span.start; c<span.end; c++) {
+				if (rowdata[c] == PIX_NONPAPER) {
+					c = fillMarginSpan(r, c, stack);
+				}
+			}
+		}
 	}
+}
 
-	if (pixelType.at(r).at(c)== PIX_NONPAPER) {
-		pixelType.at(r).at(c) = PIX_TEAR;
-	} else if (pixelType.at(r).at(c) == PIX_MARGIN) {
-		pixelType.at(r).at(c) = PIX_TEAR;
-	} else {
-		return;
-	}
 
-	if (ti.origin.first == 0) {
-		ti.origin.first = r;
-	} else if (r < ti.origin.first) {
-		ti.origin.first = r;
-	}
 
-	if (ti.origin.second == 0) {
-		ti.origin.second = c;
-	} else if (c < ti.origin.second) {
-		ti.origin.second = c;
-	}
+//////////////////////////////
+//
+// RollImage::fillMarginSpan -- Mark the non-paper pixels to the left and
+//     right of (row, col) as margin, update the margin indexes and add the
+//     span to the stack.  Returns the last column of the span.
+//
 
-	if (ti.width.first == 0) {
-		ti.width.first = r;
-	} else if (r > ti.width.first) {
-		ti.width.first = r;
+ulongint RollImage::fillMarginSpan(ulongint row, ulongint col,
+		vector<ComponentRun>& stack) {
+	ulongint cols = getCols();
+	ulongint half = cols / 2;
+	ucharint* rowdata = pixelType.getRow(row);
+	ulongint start = col;
+	while ((start > 0) && (rowdata[start-1] == PIX_NONPAPER)) {
+		start--;
 	}
-
-	if (ti.width.second == 0) {
-		ti.width.second = c;
-	} else if (c > ti.width.second) {
-		ti.width.second = c;
+	ulongint end = col + 1;
+	while ((end < cols) && (rowdata[end] == PIX_NONPAPER)) {
+		end++;
 	}
+	std::fill(rowdata + start, rowdata + end, (ucharint)PIX_MARGIN);
 
-	ti.area++;
-	ti.centroid.first  += r;
-	// ti.centroid.second += c + driftCorrection[r];
-	ti.centroid.second += c ;
-
-	if ((c > 0) && (r > 0)) {
-		fillTearInfo(ti, r-1, c-1, counter);
-	}
-	if (r > 0) {
-		fillTearInfo(ti, r-1, c  , counter);
-		fillTearInfo(ti, r-1, c+1, counter);
+	if (start < half) {
+		int c = (int)std::min(end, half) - 1;
+		leftMarginIndex[row] = std::max(leftMarginIndex[row], c);
 	}
-	if (c > 0) {
-		fillTearInfo(ti, r  , c-1, counter);
-	}
-	fillTearInfo(ti, r  , c+1, counter);
-	if (c > 0) {
-		fillTearInfo(ti, r+1, c-1, counter);
+	if (end > half) {
+		int c = (int)std::max(start, half);
+		rightMarginIndex[row] = std::min(rightMarginIndex[row], c);
 	}
-	fillTearInfo(ti, r+1, c  , counter);
-	fillTearInfo(ti, r+1, c+1, counter);
+
+	ComponentRun span;
+	span.row   = (unsigned int)row;
+	span.start = (unsigned int)start;
+	span.end   = (unsigned int)end;
+	stack.push_back(span);
+	return end - 1;
 }
 
 
 
 //////////////////////////////
 //
-// RollImage::analyzeAdvancedMargins -- Separate the hard and soft margins.
+// RollImage::floodFillMarginRuns -- Same as floodFillMargins(), but for
+//     pixel classes stored in pixelRuns (in a single thread).  Non-paper
+//     runs are filled whole, since a run of PIX_NONPAPER is always
+//     bounded by paper or margin.
 //
 
-void RollImage::analyzeAdvancedMargins(void) {
-	analyzeHardMargins(getLeaderIndex());
-	m_analyzedAdvancedMargins = true;
+void RollImage::floodFillMarginRuns(void) {
+	ulongint rows = getRows();
+	ulongint cols = getCols();
+	ulongint startcol = 5;
+	if (cols <= startcol) {
+		leftMarginIndex.assign(rows, 0);
+		rightMarginIndex.assign(rows, 0);
+		return;
+	}
+	leftMarginIndex.assign(rows, (int)startcol - 1);
+	rightMarginIndex.assign(rows, (int)(cols - startcol));
+
+	vector<ComponentRun> stack;
+	vector<ulongint> starts;
+	for (ulongint r=0; r<rows; r++) {
+		if (pixelRuns.getValue(r, startcol) == PIX_NONPAPER) {
+			fillMarginRun(r, startcol, stack);
+		}
+		if (pixelRuns.getValue(r, cols-1-startcol) == PIX_NONPAPER) {
+			fillMarginRun(r, cols-1-startcol, stack);
+		}
+		while (!stack.empty()) {
+			ComponentRun span = stack.back();
+			stack.pop_back();
+			for (int dir=-1; dir<=1; dir+=2) {
+				if ((dir < 0) && (span.row == 0)) {
+					continue;
+				}
+				if ((dir > 0) && (span.row + 1 >= rows)) {
+					continue;
+				}
+				ulongint nr = span.row + dir;
+				const vector<PixelRun>& runs = pixelRuns.getRuns(nr);
+				starts.clear();
+				for (ulongint i=0; i<runs.size(); i++) {
+					if (runs[i].start >= span.end) {
+						break;
+					}
+					if ((runs[i].value == PIX_NONPAPER) &&
+							(pixelRuns.getRunEnd(nr, i) > span.start)) {
+						starts.push_back(runs[i].start);
+					}
+				}
+				for (ulongint i=0; i<starts.size(); i++) {
+					fillMarginRun(nr, starts[i], stack);
+				}
+			}
+		}
+	}
+
+	for (ulongint r=0; r<rows; r++) {
+		if (pixelRuns.findValue(r, 0, PIX_PAPER) < 0) {
+			leftMarginIndex[r]  = (int)cols - 1;
+			rightMarginIndex[r] = 0;
+		}
+	}
 }
 
 
 
 //////////////////////////////
 //
-// RollImage::analyzeBasicMargins --
+// RollImage::fillMarginRun -- Mark the non-paper run at (row, col) in
+//     pixelRuns as margin, update the margin indexes and add the run to
+//     the stack.
 //
 
-void RollImage::analyzeBasicMargins(void) {
-	getRawMargins();
-	waterfallDownMargins();
-	waterfallUpMargins();
-	waterfallLeftMargins();
-	waterfallRightMargins();
+void RollImage::fillMarginRun(ulongint row, ulongint col,
+		vector<ComponentRun>& stack) {
+	ulongint half = getCols() / 2;
+	const vector<PixelRun>& runs = pixelRuns.getRuns(row);
+	ulongint index = 0;
+	while ((index + 1 < runs.size()) && (runs[index+1].start <= col)) {
+		index++;
+	}
+	ulongint start = runs[index].start;
+	ulongint end   = pixelRuns.getRunEnd(row, index);
+	pixelRuns.replaceValues(row, start, end, PIX_NONPAPER, PIX_NONPAPER, PIX_MARGIN);
 
-	m_analyzedBasicMargins = true;
+	if (start < half) {
+		int c = (int)std::min(end, half) - 1;
+		leftMarginIndex[row] = std::max(leftMarginIndex[row], c);
+	}
+	if (end > half) {
+		int c = (int)std::max(start, half);
+		rightMarginIndex[row] = std::min(rightMarginIndex[row], c);
+	}
+
+	ComponentRun span;
+	span.row   = (unsigned int)row;
+	span.start = (unsigned int)start;
+	span.end   = (unsigned int)end;
+	stack.push_back(span);
 }
 
 
+
 //////////////////////////////
 //
-// RollImage::getRawMargins -- Identifies the pixel position of the
-//   left and right margins. The index value stored in the margins
-//   is the closest pixel in the margin to the paper, searched
-//   by moving horizontally from the edge of the image.  Dust will
-//   cause problems that are fixed later in waterfallDownMargins().
+// RollImage::getRawMarginRuns -- Same as getRawMargins(), but for pixel
+//   classes stored in pixelRuns.
 //
 
-void RollImage::getRawMargins(void) {
+void RollImage::getRawMarginRuns(void) {
 	ulongint rows = getRows();
 	ulongint cols = getCols();
 
 	leftMarginIndex.resize(rows);
 	rightMarginIndex.resize(rows);
 
-	int startcol = 5; // starting a little off of the margin due to digital noise
-	                  // the second and third columns.
+	ulongint startcol = 5;
 	for (ulongint r=0; r<rows; r++) {
-		std::vector<ucharint>& rowdata = pixelType.at(r);
 		leftMarginIndex[r] = 0;
-		for (ulongint c=startcol; c<cols; c++) {
-			if (rowdata.at(c) == PIX_PAPER) {
-				leftMarginIndex[r] = c - 1;
-				break;
-			} else {
-				rowdata.at(c) = PIX_MARGIN;
-				leftMarginIndex[r] = c;
-			}
+		if (startcol >= cols) {
+			continue;
 		}
+		long paper = pixelRuns.findValue(r, startcol, PIX_PAPER);
+		ulongint end = paper < 0 ? cols : (ulongint)paper;
+		pixelRuns.replaceValues(r, startcol, end, PIX_PAPER+1, 0xff, PIX_MARGIN);
+		leftMarginIndex[r] = (int)end - 1;
 	}
 
 	for (ulongint r=0; r<rows; r++) {
-		std::vector<ucharint>& rowdata = pixelType.at(r);
 		rightMarginIndex[r] = 0;
-		for (int c=cols-1-startcol; c>=0; c--) {
-			if (rowdata.at(c) == PIX_PAPER) {
-				rightMarginIndex[r] = c + 1;
-				break;
-			} else {
-				rowdata.at(c) = PIX_MARGIN;
-				rightMarginIndex[r] = c;
-			}
+		if (startcol >= cols) {
+			continue;
 		}
+		long paper = pixelRuns.findValueReverse(r, cols-1-startcol, PIX_PAPER);
+		pixelRuns.replaceValues(r, paper+1, cols-startcol, PIX_PAPER+1, 0xff, PIX_MARGIN);
+		rightMarginIndex[r] = (int)(paper + 1);
 	}
 }
 
@@ -2440,32 +3079,25 @@ void RollImage::getRawMargins(void) {
 
 //////////////////////////////
 //
-// RollImage::waterfallDownMargins -- Fill in margin areas that are blocked
-//     from the left/right by dust.
+// RollImage::waterfallDownMarginRuns -- Same as waterfallDownMargins(),
+//     but for pixel classes stored in pixelRuns.
 //
 
-void RollImage::waterfallDownMargins(void) {
+void RollImage::waterfallDownMarginRuns(void) {
 	ulongint rows = getRows();
-	int cols = (int)getCols();
-
-	for (ulongint r=0; r<rows-1; r++) {
-		std::vector<ucharint>& row1 = pixelType[r];
-		std::vector<ucharint>& row2 = pixelType[r+1];
-		for (int c=0; c<cols; c++) {
-			if (row1[c] != PIX_MARGIN) {
-				continue;
+	ulongint half = getCols() / 2;
+	vector<ColumnSpan> spans;
+
+	for (ulongint r=0; r+1<rows; r++) {
+		pixelRuns.spreadValue(r, r+1, PIX_MARGIN, PIX_PAPER, spans);
+		for (ulongint i=0; i<spans.size(); i++) {
+			if (spans[i].first < half) {
+				int c = (int)std::min(spans[i].second, half) - 1;
+				leftMarginIndex[r+1] = std::max(leftMarginIndex[r+1], c);
 			}
-			if (row2[c] != PIX_PAPER) {
-				row2[c] = PIX_MARGIN;
-				if (c < cols/2) {
-					if (c > leftMarginIndex[r+1]) {
-						leftMarginIndex[r+1] = c;
-					}
-				} else {
-					if (c < rightMarginIndex[r+1]) {
-						rightMarginIndex[r+1] = c;
-					}
-				}
+			if (spans[i].second > half) {
+				int c = (int)std::max(spans[i].first, half);
+				rightMarginIndex[r+1] = std::min(rightMarginIndex[r+1], c);
 			}
 		}
 	}
@@ -2475,32 +3107,25 @@ void RollImage::waterfallDownMargins(void) {
 
 //////////////////////////////
 //
-// RollImage::waterfallUpMargins -- Fill in margin areas that are blocked
-//     from the left/right by dust by going up from bottom of image.
+// RollImage::waterfallUpMarginRuns -- Same as waterfallUpMargins(), but
+//     for pixel classes stored in pixelRuns.
 //
 
-void RollImage::waterfallUpMargins(void) {
+void RollImage::waterfallUpMarginRuns(void) {
 	ulongint rows = getRows();
-	ulongint cols = getCols();
+	ulongint half = getCols() / 2;
+	vector<ColumnSpan> spans;
 
 	for (ulongint r=rows-1; r>0; r--) {
-		std::vector<ucharint>& row1 = pixelType.at(r);
-		std::vector<ucharint>& row2 = pixelType.at(r-1);
-		for (ulongint c=0; c<cols; c++) {
-			if (row1.at(c) != PIX_MARGIN) {
-				continue;
+		pixelRuns.spreadValue(r, r-1, PIX_MARGIN, PIX_PAPER, spans);
+		for (ulongint i=0; i<spans.size(); i++) {
+			if (spans[i].first < half) {
+				int c = (int)std::min(spans[i].second, half) - 1;
+				leftMarginIndex[r-1] = std::max(leftMarginIndex[r-1], c);
 			}
-			if (row2.at(c) != PIX_PAPER) {
-				row2.at(c) = PIX_MARGIN;
-				if (c < cols/2) {
-					if (c > (ulongint)leftMarginIndex.at(r-1)) {
-						leftMarginIndex.at(r-1) = c;
-					}
-				} else {
-					if (c < (ulongint)rightMarginIndex.at(r-1)) {
-						rightMarginIndex.at(r-1) = c;
-					}
-				}
+			if (spans[i].second > half) {
+				int c = (int)std::max(spans[i].first, half);
+				rightMarginIndex[r-1] = std::min(rightMarginIndex[r-1], c);
 			}
 		}
 	}
@@ -2510,32 +3135,27 @@ void RollImage::waterfallUpMargins(void) {
 
 //////////////////////////////
 //
-// RollImage::waterfallRightMargins -- Fill in margin areas that are blocked
-//     from up/down by dust by going right from the left side of the image.
-//     This function is needed to go around fingerprints to avoid spurious
-//     hole detection on the edges of the roll.
+// RollImage::waterfallLeftMarginRuns -- Same as waterfallLeftMargins(),
+//     but for pixel classes stored in pixelRuns.  Each row is independent
+//     of the others, so the rows are processed one at a time.  Spans
+//     contain the filled pixels (at c-1 for a margin pixel at c).
 //
 
-void RollImage::waterfallRightMargins(void) {
+void RollImage::waterfallLeftMarginRuns(void) {
 	ulongint rows = getRows();
-	ulongint cols = getCols();
+	ulongint half = getCols() / 2;
+	vector<ColumnSpan> spans;
 
-	for (ulongint c=0; c<cols-1; c++) {
-		for (ulongint r=0; r<rows; r++) {
-			if (pixelType.at(r).at(c) != PIX_MARGIN) {
-				continue;
+	for (ulongint r=0; r<rows; r++) {
+		pixelRuns.spreadValueLeft(r, PIX_MARGIN, PIX_PAPER, spans);
+		for (ulongint i=0; i<spans.size(); i++) {
+			if (spans[i].first + 1 < half) {
+				int c = (int)std::min(spans[i].second, half - 1) - 1;
+				leftMarginIndex[r] = std::max(leftMarginIndex[r], c);
 			}
-			if (pixelType.at(r).at(c+1) != PIX_PAPER) {
-				pixelType.at(r).at(c+1) = PIX_MARGIN;
-				if (c < cols/2) {
-					if (c+1 > (ulongint)leftMarginIndex.at(r)) {
-						leftMarginIndex.at(r) = c+1;
-					}
-				} else {
-					if (c+1 < (ulongint)rightMarginIndex.at(r)) {
-						rightMarginIndex.at(r-1) = c+1;
-					}
-				}
+			if (spans[i].second + 1 > half) {
+				int c = (int)std::max(spans[i].first + 1, half) - 1;
+				rightMarginIndex[r] = std::min(rightMarginIndex[r], c);
 			}
 		}
 	}
@@ -2545,34 +3165,140 @@ void RollImage::waterfallRightMargins(void) {
 
 //////////////////////////////
 //
-// RollImage::waterfallLeftMargins -- Fill in margin areas that are blocked
-//     from up/down by dust by going left from the right side of the image.
-//     This function is needed to go around fingerprints to avoid spurious
-//     hole detection on the edges of the roll.
+// RollImage::waterfallRightMarginRuns -- Same as waterfallRightMargins(),
+//     but for pixel classes stored in pixelRuns.  Spans contain the filled
+//     pixels (at c+1 for a margin pixel at c).
 //
 
-void RollImage::waterfallLeftMargins(void) {
+void RollImage::waterfallRightMarginRuns(void) {
 	ulongint rows = getRows();
 	ulongint cols = getCols();
-
-	for (ulongint c=cols-1; c>0; c--) {
-		for (ulongint r=0; r<rows; r++) {
-			if (pixelType.at(r).at(c) != PIX_MARGIN) {
-				continue;
+	ulongint half = cols / 2;
+	vector<ColumnSpan> spans;
+
+	ulongint belowFirst = cols;  // first column updated by the row below
+	int      pending    = -1;    // update from the row below for this row
+	for (ulongint r=rows; r>0; ) {
+		r--;
+		pixelRuns.spreadValueRight(r, PIX_MARGIN, PIX_PAPER, spans);
+		ulongint original = (ulongint)rightMarginIndex.at(r);
+		ulongint first = cols;
+		int last = -1;
+		for (ulongint i=0; i<spans.size(); i++) {
+			if (spans[i].first <= half) {
+				int c = (int)std::min(spans[i].second - 1, half);
+				leftMarginIndex[r] = std::max(leftMarginIndex[r], c);
 			}
-			if (pixelType.at(r).at(c-1) != PIX_PAPER) {
-				pixelType.at(r).at(c-1) = PIX_MARGIN;
-				if (c < cols/2) {
-					if (c-1 > (ulongint)leftMarginIndex.at(r)) {
-						leftMarginIndex.at(r) = c-1;
-					}
-				} else {
-					if (c-1 < (ulongint)rightMarginIndex.at(r)) {
-						rightMarginIndex.at(r) = c-1;
-					}
+			// filled pixels t where t-1 >= half, t < original and
+			// t-1 <= belowFirst:
+			ulongint start = std::max(spans[i].first, half + 1);
+			ulongint end   = std::min(spans[i].second, original);
+			end = std::min(end, belowFirst + 2);
+			if (start < end) {
+				if (first == cols) {
+					first = start - 1;
 				}
+				last = (int)end - 1;
 			}
 		}
+		if (pending >= 0) {
+			rightMarginIndex[r] = pending;
+		}
+		pending = last;
+		belowFirst = first;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// RollImage::storePaperMask -- Create paperMask from the pixel classes,
+//     for when they were not set up by loadGreenChannel().
+//
+
+void RollImage::storePaperMask(void) {
+	ulongint rows = getRows();
+	ulongint cols = getCols();
+	paperMask.resize(rows, cols);
+	vector<ucharint> classes(cols);
+	for (ulongint r=0; r<rows; r++) {
+		releasePixelBand(r);
+		const ucharint* pixels = pixelType.getRow(r);
+		if (!pixelRuns.empty()) {
+			pixelRuns.decodeRow(r, classes.data());
+			pixels = classes.data();
+		}
+		// Only PIX_PAPER (0) is less than 1:
+		packBelowThreshold(paperMask.getRow(r), pixels, cols, PIX_PAPER+1);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// RollImage::expandPixelRuns -- Convert the run-length pixel classes into
+//     pixelType (for the analysis steps which change individual pixels).
+//
+
+void RollImage::expandPixelRuns(void) {
+	if (pixelRuns.empty()) {
+		return;
+	}
+	if (m_bandRows == 0) {
+		pixelRuns.expandTo(pixelType);
+		return;
+	}
+	// Same as RunLengthPlane::expandTo(), but written to the temporary
+	// file of pixelType band by band:
+	ulongint rows = pixelRuns.getRows();
+	pixelType.resize(rows, pixelRuns.getCols(), true);
+	for (ulongint r=0; r<rows; r++) {
+		releasePixelBand(r);
+		pixelRuns.decodeRow(r, pixelType.getRow(r));
+		pixelRuns.releaseRow(r);
+	}
+	pixelRuns.clear();
+	releasePixelRows(0, rows);
+}
+
+
+
+//////////////////////////////
+//
+// RollImage::releasePixelRows -- Drop rows of the pixel planes from memory
+//    (they are kept in the temporary files of the planes).  Does nothing
+//    when the planes are in memory.
+//
+
+void RollImage::releasePixelRows(ulongint startrow, ulongint count) {
+	if (m_bandRows == 0) {
+		return;
+	}
+	pixelType.releaseRows(startrow, count);
+	monochrome.releaseRows(startrow, count);
+}
+
+
+
+//////////////////////////////
+//
+// RollImage::releasePixelBand -- Called for each row of a pass over the
+//    pixel planes.  At the start of each band, the band before the
+//    previous one is dropped from memory, so the previous band is still
+//    available to passes which look at neighboring rows.  Set upward to
+//    true for passes from the bottom of the image to the top.
+//
+
+void RollImage::releasePixelBand(ulongint row, bool upward) {
+	if ((m_bandRows == 0) || (row % m_bandRows != 0)) {
+		return;
+	}
+	if (upward) {
+		releasePixelRows(row + m_bandRows, m_bandRows);
+	} else if (row >= 2 * m_bandRows) {
+		releasePixelRows(row - 2 * m_bandRows, m_bandRows);
 	}
 }
 
@@ -2748,8 +3474,10 @@ void RollImage::mergePixelOverlay(std::fstream& output) {
 	ulonglongint offset;
 	ulongint rows = getRows();
 	ulongint cols = getCols();
+	ScopedStage stage(m_profiler, "mergePixelOverlay", (ulonglongint)rows * cols);
 
 	for (ulongint r=0; r<rows; r++) {
+		releasePixelBand(r);
 		for (ulongint c=0; c<cols; c++) {
 			int value = pixelType[r][c];
 			if (!value) {
@@ -3011,7 +3739,7 @@ void RollImage::analyzeHardMargins(ulongint leaderBoundary) {
 	ulongint endboundary = 1000;
 
 	ulongint minpos = leftMarginIndex[leaderBoundary];
-	ulongint rows = pixelType.size();
+	ulongint rows = getRows();
 	for (ulongint r=leaderBoundary+1; r<rows-endboundary; r++) {
 		if ((ulongint)leftMarginIndex[r] < minpos) {
 			minpos = leftMarginIndex[r];
@@ -3021,6 +3749,11 @@ void RollImage::analyzeHardMargins(ulongint leaderBoundary) {
 	setHardMarginLeftIndex(minpos);
 
 	for (ulongint r=leaderBoundary; r<rows; r++) {
+		releasePixelBand(r);
+		if (!pixelRuns.empty()) {
+			pixelRuns.replaceValues(r, 0, minpos+1, PIX_MARGIN, PIX_MARGIN, PIX_HARDMARGIN);
+			continue;
+		}
 		for (ulongint c=0; c<=minpos; c++) {
 			if (pixelType[r][c] == PIX_MARGIN) {
 				pixelType[r][c] = PIX_HARDMARGIN;
@@ -3036,7 +3769,13 @@ void RollImage::analyzeHardMargins(ulongint leaderBoundary) {
 	}
 	setHardMarginRightIndex(maxpos);
 
+	releasePixelRows(0, rows);
 	for (ulongint r=leaderBoundary; r<rows; r++) {
+		releasePixelBand(r);
+		if (!pixelRuns.empty()) {
+			pixelRuns.replaceValues(r, maxpos, getCols(), PIX_MARGIN, PIX_MARGIN, PIX_HARDMARGIN);
+			continue;
+		}
 		ulongint cols = pixelType[r].size();
 		for (ulongint c=maxpos; c<cols; c++) {
 			if (pixelType[r][c] == PIX_MARGIN) {
@@ -3081,6 +3820,13 @@ void RollImage::markPreleaderRegion(void) {
 
 	// mark holes in leader region as leader holes.
 
+	if (!pixelRuns.empty()) {
+		for (ulongint r=0; r<=preleaderIndex; r++) {
+			pixelRuns.replaceValues(r, 0, cols, PIX_PAPER+1, 0xff, PIX_PRELEADER);
+		}
+		return;
+	}
+
 	for (ulongint r=0; r<=preleaderIndex; r++) {
 		for (ulongint c=0; c<cols; c++) {
 			if (pixelType[r][c]) {
@@ -3103,6 +3849,13 @@ void RollImage::markLeaderRegion(void) {
 
 	// mark holes in leader region as leader holes.
 
+	if (!pixelRuns.empty()) {
+		for (ulongint r=0; r<leaderIndex; r++) {
+			pixelRuns.replaceValues(r, 0, cols, PIX_PAPER+1, 0xff, PIX_LEADER);
+		}
+		return;
+	}
+
 	for (ulongint r=0; r<leaderIndex; r++) {
 		for (ulongint c=0; c<cols; c++) {
 			if (pixelType[r][c]) {
@@ -3310,7 +4063,6 @@ ulongint RollImage::getLastMusicHoleEnd(void) {
 //
 
 void RollImage::markHoleShifts(void) {
-	int counter;
 	for (ulongint i=0; i<holes.size(); i++) {
 		if (!holes[i]->isMusicHole()) {
 			continue;
@@ -3325,11 +4077,7 @@ void RollImage::markHoleShifts(void) {
 		//}
 		// Hole shifts too much to mark it with a different color from
 		// regular holes.
-		counter = 0;
-		ulongint r = holes[i]->entry.first;
-		ulongint c = holes[i]->entry.second;
-		int target = pixelType[r][c];
-		fillHoleSimple(r, c, target, PIX_HOLE_SHIFT, counter);
+		paintHole(*holes[i], PIX_HOLE_SHIFT);
 	}
 }
 
@@ -3341,7 +4089,6 @@ void RollImage::markHoleShifts(void) {
 //
 
 void RollImage::markSnakeBites(void) {
-	int counter;
 	for (ulongint i=0; i<holes.size(); i++) {
 		if (!holes[i]->isMusicHole()) {
 			continue;
@@ -3351,11 +4098,7 @@ void RollImage::markSnakeBites(void) {
 			continue;
 		}
 
-		counter = 0;
-		ulongint r = holes[i]->entry.first;
-		ulongint c = holes[i]->entry.second;
-		int target = pixelType[r][c];
-		fillHoleSimple(r, c, target, PIX_HOLE_SNAKEBITE, counter);
+		paintHole(*holes[i], PIX_HOLE_SNAKEBITE);
 	}
 }
 
@@ -3855,6 +4598,7 @@ double RollImage::getDustScoreBass(void) {
 	ulongint endrow   = getLastMusicHoleEnd();
 
 	for (ulongint r=startrow; r<=endrow; r++) {
+		releasePixelBand(r);
 		for (ulongint c=startcol; c<=endcol; c++) {
 			if (pixelType[r][c] == PIX_PAPER) {
 				counter++;
@@ -3892,6 +4636,7 @@ double RollImage::getDustScoreTreble(void) {
 	ulongint endrow   = getLastMusicHoleEnd();
 
 	for (ulongint r=startrow; r<=endrow; r++) {
+		releasePixelBand(r);
 		for (ulongint c=startcol; c<=endcol; c++) {
 			if (pixelType[r][c] == PIX_PAPER) {
 				counter++;
@@ -4013,10 +4758,10 @@ int RollImage::getMeasuredTrackerHoleCount(void) {
 //
 
 void RollImage::addDriftInfoToHoles(void) {
-	for (ulongint i=0; i<holes.size(); i++) {
+	ThreadPool::getShared().parallelForEach(holes.size(), [this](ulongint i) {
 		holes[i]->leadinghcor = driftCorrection[holes[i]->origin.first];
 		holes[i]->trailinghcor = driftCorrection[holes[i]->origin.first+holes[i]->width.first];
-	}
+	}, HOLE_GRAIN);
 }
 
 
@@ -4027,6 +4772,9 @@ void RollImage::addDriftInfoToHoles(void) {
 //
 
 std::string RollImage::getDataMD5Sum(void) {
+	if (!m_channelMD5.empty()) {
+		return m_channelMD5;
+	}
 	CheckSum checksum;
 	return checksum.getMD5Sum(monochrome);
 }
@@ -4070,6 +4818,7 @@ void RollImage::generateHoleMidiFileHex(ostream& output) {
 //
 
 void RollImage::generateNoteMidiFileBinasc(ostream& output) {
+	ScopedStage stage(m_profiler, "generateNoteMidiFileBinasc");
 #ifndef DONOTUSEFFT
 	MidiFile midifile;
 	generateMidifile(midifile);
@@ -4085,6 +4834,7 @@ void RollImage::generateNoteMidiFileBinasc(ostream& output) {
 //
 
 void RollImage::generateHoleMidiFileBinasc(ostream& output) {
+	ScopedStage stage(m_profiler, "generateHoleMidiFileBinasc");
 #ifndef DONOTUSEFFT
 	MidiFile midifile;
 	generateHoleMidifile(midifile);
@@ -4643,6 +5393,7 @@ void RollImage::insertRollImageProperties(MidiFile& midifile) {
 //
 
 std::ostream& RollImage::printRollImageProperties(std::ostream& out) {
+	ScopedStage stage(m_profiler, "printRollImageProperties");
 	if (!m_analyzedLeaders) {
 		analyzeLeaders();
 	}
@@ -5028,6 +5779,9 @@ std::ostream& RollImage::printRollImageProperties(std::ostream& out) {
 	}
 	out << "\n@@END: DEBUGGING\n";
 
+	if (m_profiler.isEnabled()) {
+		m_profiler.printAton(out);
+	}
 
 	out << "\n@@END: ROLLINFO\n";
 	return out;
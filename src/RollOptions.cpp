@@ -11,6 +11,8 @@
 //
 
 #include "RollOptions.h"
+#include "Smoothing.h"
+#include "ThreadPool.h"
 
 using namespace std;
 
@@ -320,6 +322,7 @@ std::string RollOptions::getRollType(void) {
 void RollOptions::setRollTypeRedWelte(void) {
 	m_rollType = "welte-red";
 	m_minTrackerSpacingToPaperEdge = 1.6;
+	m_trackerHolesPerInch = 8.0;
 	m_rewindHole = 91;  // 91st hole from left (bass)
 	m_rewindHoleMidi = 104;
 	m_trackerHoles = 100;
@@ -375,8 +378,22 @@ void RollOptions::setRollTypeGreenWelte(void) {
 	cerr << "GREEN ROLL NOT IMPLEMENT YET" << endl;
 	exit(1);
 
+	setGreenWelteLayout();
+}
+
+
+
+//////////////////////////////
+//
+// RollOptions::setGreenWelteLayout -- Tracker-bar layout of Green Welte
+//     (T-98) piano rolls, without the check that the analysis can handle
+//     them (used by RollSynthesizer for generating test images).
+//
+
+void RollOptions::setGreenWelteLayout(void) {
 	m_rollType = "welte-green";
 	m_minTrackerSpacingToPaperEdge = 1.6; // check
+	m_trackerHolesPerInch = 9.0; // check
 	m_rewindHole = 1;  // 1st hole from left (bass), but only if "long"
 	m_rewindHoleMidi = 16;
 	m_trackerHoles = 98;
@@ -425,6 +442,7 @@ void RollOptions::setRollType65Note(void) {
 	m_rollType = "65-note";
 	m_bridgeFactor  = 1.25;
 	m_minTrackerSpacingToPaperEdge = 2.0;
+	m_trackerHolesPerInch = 6.0;
 	m_rewindHole = 0;  // no rewind hole
 	m_rewindHoleMidi = 0;
 	m_trackerHoles = 65;
@@ -489,6 +507,7 @@ void RollOptions::setRollType88Note(void) {
 	m_rollType = "88-note";
 	m_bridgeFactor  = 0.85;
 	m_minTrackerSpacingToPaperEdge = 1.6;
+	m_trackerHolesPerInch = 9.0;
 	m_rewindHole = 0;  // no rewind hole (but can be at position 2, MIDI 16)
 	m_rewindHoleMidi = 0;
 	m_trackerHoles = 100;
@@ -577,6 +596,17 @@ int RollOptions::getExpectedTrackerHoleCount(void) {
 
 
 
+//////////////////////////////
+//
+// RollOptions::getTrackerHolesPerInch -- Returns 0.0 if roll type is undefined.
+//
+
+double RollOptions::getTrackerHolesPerInch(void) {
+	return m_trackerHolesPerInch;
+}
+
+
+
 //////////////////////////////
 //
 // RollOptions::setThreshold -- 
@@ -599,6 +629,163 @@ int RollOptions::getThreshold(void) {
 
 
 
+//////////////////////////////
+//
+// RollOptions::setThreadCount -- Number of threads to use for parallel
+//    analysis steps.  0 means the thread count of the shared ThreadPool
+//    (see ThreadPool::getDefaultThreadCount()).
+//
+
+void RollOptions::setThreadCount(int value) {
+	m_threadCount = value < 0 ? 0 : value;
+}
+
+
+
+//////////////////////////////
+//
+// RollOptions::getThreadCount -- Returns the number of threads for
+//    parallel analysis steps.
+//
+
+int RollOptions::getThreadCount(void) {
+	if (m_threadCount > 0) {
+		return m_threadCount;
+	}
+	return ThreadPool::getShared().getThreadCount();
+}
+
+
+
+//////////////////////////////
+//
+// RollOptions::setRunLengthPixels -- Keep the pixel classes run-length
+//    encoded during the margin and leader analysis.  This must be set
+//    before the image is loaded.
+//
+
+void RollOptions::setRunLengthPixels(bool value) {
+	m_runLengthPixels = value;
+}
+
+
+
+//////////////////////////////
+//
+// RollOptions::getRunLengthPixels --
+//
+
+bool RollOptions::getRunLengthPixels(void) {
+	return m_runLengthPixels;
+}
+
+
+
+//////////////////////////////
+//
+// RollOptions::setMarginFloodFill -- Mark all non-paper regions which are
+//    connected to the sides of the image as margin with a flood fill,
+//    rather than with getRawMargins() and the waterfall passes (which can
+//    miss dust-shadowed pockets).  This changes the analysis results, so
+//    it is off by default.
+//
+
+void RollOptions::setMarginFloodFill(bool value) {
+	m_marginFloodFill = value;
+}
+
+
+
+//////////////////////////////
+//
+// RollOptions::getMarginFloodFill --
+//
+
+bool RollOptions::getMarginFloodFill(void) {
+	return m_marginFloodFill;
+}
+
+
+
+//////////////////////////////
+//
+// RollOptions::setSmoothingMode -- How the margin curves are smoothed for
+//    the tear, shift and drift analyses (see SmoothingMode in Smoothing.h).
+//    Modes other than SMOOTH_EXACT are faster but may change the last bits
+//    of the curves.
+//
+
+void RollOptions::setSmoothingMode(int value) {
+	if ((value < SMOOTH_EXACT) || (value > SMOOTH_FIXED)) {
+		value = SMOOTH_EXACT;
+	}
+	m_smoothingMode = value;
+}
+
+
+
+//////////////////////////////
+//
+// RollOptions::getSmoothingMode --
+//
+
+int RollOptions::getSmoothingMode(void) {
+	return m_smoothingMode;
+}
+
+
+
+//////////////////////////////
+//
+// RollOptions::setBandMemory -- Limit the memory used by the pixel planes
+//    of the analysis to about the given number of bytes.  The planes are
+//    stored in temporary files (see setScratchDirectory()) and the long
+//    passes over the image drop the rows behind them from memory.  The
+//    results are the same as with the planes in memory.  0 keeps the
+//    full planes in memory.  This must be set before the image is loaded.
+//
+
+void RollOptions::setBandMemory(ulonglongint bytes) {
+	m_bandMemory = bytes;
+}
+
+
+
+//////////////////////////////
+//
+// RollOptions::getBandMemory --
+//
+
+ulonglongint RollOptions::getBandMemory(void) {
+	return m_bandMemory;
+}
+
+
+
+//////////////////////////////
+//
+// RollOptions::setScratchDirectory -- Directory for the temporary files
+//    of the pixel planes when a band memory budget is set.  It should be
+//    on a disk rather than in memory (tmpfs).  Empty means $TMPDIR or /tmp.
+//
+
+void RollOptions::setScratchDirectory(const string& directory) {
+	m_scratchDirectory = directory;
+}
+
+
+
+//////////////////////////////
+//
+// RollOptions::getScratchDirectory --
+//
+
+const string& RollOptions::getScratchDirectory(void) {
+	return m_scratchDirectory;
+}
+
+
+
 //////////////////////////////
 //
 // RollOptions::hasNoExpressionMidiFileSetup -- The roll has no 
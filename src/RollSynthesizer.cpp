@@ -0,0 +1,987 @@
+//
+// Creation Date: Fri Oct 16 23:12:08 PDT 2026
+// Last Modified: Fri Oct 16 23:12:08 PDT 2026
+// Filename:      RollSynthesizer.cpp
+// Web Address:
+// Syntax:        C++
+// vim:           ts=3:nowrap:ft=text
+//
+// Description:   Generate synthetic piano-roll images with a known list of
+//                holes, tears and shifts.
+//
+
+#include "RollSynthesizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+using namespace std;
+
+namespace rip  {
+
+
+//////////////////////////////
+//
+// RollSynthesizer::RollSynthesizer --
+//
+
+RollSynthesizer::RollSynthesizer(void) {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::~RollSynthesizer --
+//
+
+RollSynthesizer::~RollSynthesizer() {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::setRollType -- Use the tracker-bar layout of a roll
+//     type: "welte-red", "welte-green", "65-note" or "88-note".  Returns
+//     false for other types.
+//
+
+bool RollSynthesizer::setRollType(const string& type) {
+	if (type == "welte-red") {
+		setRollTypeRedWelte();
+	} else if (type == "welte-green") {
+		setGreenWelteLayout();
+	} else if (type == "65-note") {
+		setRollType65Note();
+	} else if (type == "88-note") {
+		setRollType88Note();
+	} else {
+		return false;
+	}
+	m_generated = false;
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::setDpi -- Resolution of the image in both directions.
+//
+
+void RollSynthesizer::setDpi(double value) {
+	m_dpi = value > 10.0 ? value : 10.0;
+	m_generated = false;
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::setLength -- Length of the image in feet (used when
+//     setRows() has not been given a non-zero value).
+//
+
+void RollSynthesizer::setLength(double feet) {
+	m_feet = feet;
+	m_generated = false;
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::setRows -- Length of the image in rows (0 = use the
+//     length in feet).
+//
+
+void RollSynthesizer::setRows(ulongint value) {
+	m_setRows = value;
+	m_generated = false;
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::setHoleDensity -- Fraction of the music rows in which
+//     each tracker-bar position is open (0.01 to 0.95).
+//
+
+void RollSynthesizer::setHoleDensity(double value) {
+	m_density = std::max(0.01, std::min(0.95, value));
+	m_generated = false;
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::setHoleWidth -- Width of the punches as a fraction of
+//     the tracker-bar spacing (0 = default for the roll type).
+//
+
+void RollSynthesizer::setHoleWidth(double value) {
+	m_holeWidth = std::max(0.0, std::min(0.9, value));
+	m_generated = false;
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::setBridgeRate -- Fraction of the notes which are punched
+//     as a chain of holes separated by thin paper bridges.
+//
+
+void RollSynthesizer::setBridgeRate(double value) {
+	m_bridgeRate = std::max(0.0, std::min(1.0, value));
+	m_generated = false;
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::setDrift -- Amplitude in inches of the slow sideways
+//     movement of the paper.
+//
+
+void RollSynthesizer::setDrift(double inches) {
+	m_drift = std::max(0.0, inches);
+	m_generated = false;
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::setShiftCount -- Number of operator shifts.
+//
+
+void RollSynthesizer::setShiftCount(int value) {
+	m_shiftCount = std::max(0, value);
+	m_generated = false;
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::setTearCount -- Number of edge tears.
+//
+
+void RollSynthesizer::setTearCount(int value) {
+	m_tearCount = std::max(0, value);
+	m_generated = false;
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::setDustRate -- Number of dust specks per foot of roll.
+//
+
+void RollSynthesizer::setDustRate(double perfoot) {
+	m_dustRate = std::max(0.0, perfoot);
+	m_generated = false;
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::setLeader -- Length in inches of the tapered leader
+//     (0 = no leader).
+//
+
+void RollSynthesizer::setLeader(double inches) {
+	m_leader = std::max(0.0, inches);
+	m_generated = false;
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::setPreleader -- Length in inches of the narrow strap
+//     before the leader (0 = no preleader).
+//
+
+void RollSynthesizer::setPreleader(double inches) {
+	m_preleader = std::max(0.0, inches);
+	m_generated = false;
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::setSeed -- Random seed for the roll contents.
+//
+
+void RollSynthesizer::setSeed(ulonglongint value) {
+	m_seed = value;
+	m_generated = false;
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::setBigTiff -- Write a BigTIFF file even if the image
+//     would fit into a regular TIFF file.
+//
+
+void RollSynthesizer::setBigTiff(bool value) {
+	m_bigTiff = value;
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::getRandom -- Uniform random number from 0.0 up to (but
+//     not including) 1.0.  The mantissa is taken directly from the 64-bit
+//     generator so that every platform makes the same roll from a seed.
+//
+
+double RollSynthesizer::getRandom(void) {
+	return (double)(m_random() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+
+double RollSynthesizer::getRandom(double low, double high) {
+	return low + (high - low) * getRandom();
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::generate -- Place the paper, holes, tears, shifts and
+//     dust.  Returns false if there is no roll type or if the roll is too
+//     short for its leader.
+//
+
+bool RollSynthesizer::generate(void) {
+	int tracks = getExpectedTrackerHoleCount();
+	if ((tracks <= 0) || (getTrackerHolesPerInch() <= 0.0)) {
+		cerr << "Error: a roll type is needed to synthesize a roll" << endl;
+		return false;
+	}
+
+	m_random.seed(m_seed);
+	m_holes.clear();
+	m_tears.clear();
+	m_shifts.clear();
+	m_dust.clear();
+	m_notes = 0;
+
+	// Tracker-bar layout: the outer holes are slightly further from the
+	// paper edges than the minimum that the analysis expects.
+	m_spacing = m_dpi / getTrackerHolesPerInch();
+	double edge = getMinTrackerEdge() + 0.4;
+	m_paperWidth = (tracks - 1 + 2.0 * edge) * m_spacing;
+	double fraction = m_holeWidth;
+	if (fraction <= 0.0) {
+		fraction = getRollType() == "65-note" ? 0.62 : 0.5;
+	}
+	m_punchWidth = fraction * m_spacing;
+
+	// The hard margins leave room for the drift and for shifts, and the
+	// image is at least 4096 columns wide since the tracker-bar spacing
+	// analysis reads that many columns of the hole histogram.
+	double shiftroom = m_shiftCount > 0 ? 0.06 * m_dpi : 0.0;
+	double margin = std::ceil(0.5 * m_dpi + m_drift * m_dpi + shiftroom);
+	margin = std::max(margin, std::ceil((4096.0 - m_paperWidth) / 2.0));
+	m_cols = (ulongint)(m_paperWidth + 2.0 * margin + 0.5);
+	m_paperLeft = margin;
+	m_firstTrack = m_paperLeft + edge * m_spacing;
+	m_driftPhase = getRandom(0.0, 2.0 * M_PI);
+
+	m_rows = m_setRows;
+	if (m_rows == 0) {
+		m_rows = (ulongint)(m_feet * 12.0 * m_dpi + 0.5);
+	}
+	m_preleaderRow = (ulongint)(m_preleader * m_dpi + 0.5);
+	m_leaderRow = (ulongint)((m_preleader + m_leader) * m_dpi + 0.5);
+	m_firstHole = m_leaderRow + (ulongint)(0.5 * m_dpi);
+	m_lastHole = m_rows - (ulongint)(3.0 * m_dpi);
+	if ((m_rows < (ulongint)(4.0 * m_dpi)) || (m_firstHole + m_dpi > m_lastHole)) {
+		cerr << "Error: the roll is too short for its leader" << endl;
+		return false;
+	}
+
+	m_texture.resize(m_cols + 4096);
+	for (ulongint i=0; i<m_texture.size(); i++) {
+		m_texture[i] = (ucharint)getRandom(170.0, 191.0);
+	}
+
+	makeShifts();
+	makeHoles();
+	makeTears();
+	makeDust();
+
+	m_generated = true;
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::isPunchable -- True if music holes should be placed at
+//     the given tracker-bar position.  The rewind hole is only punched at
+//     the end of the roll, and 88-note rolls only use the sustain pedal
+//     and the 88 notes.
+//
+
+bool RollSynthesizer::isPunchable(int position) {
+	if (getRollType() == "88-note") {
+		return (position == 4) || ((position >= 7) && (position <= 94));
+	}
+	return position != getRewindHoleBassNumber();
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::makeShifts -- Place the operator shifts in the music
+//     region.  Each one moves the paper by 1/50 to 1/25 of an inch over
+//     1/6 of an inch, and the total movement stays within the room left
+//     in the hard margins.
+//
+
+void RollSynthesizer::makeShifts(void) {
+	vector<ulongint> rows;
+	for (int i=0; i<m_shiftCount; i++) {
+		rows.push_back((ulongint)getRandom(m_firstHole, m_lastHole - m_dpi));
+	}
+	std::sort(rows.begin(), rows.end());
+
+	double total = 0.0;
+	double limit = 0.06 * m_dpi;
+	for (ulongint i=0; i<rows.size(); i++) {
+		if (!m_shifts.empty() && (rows[i] < m_shifts.back().row + m_dpi)) {
+			continue;
+		}
+		SynthShift shift;
+		shift.row = rows[i];
+		shift.length = (ulongint)(m_dpi / 6.0);
+		shift.amount = getRandom(0.02, 0.04) * m_dpi;
+		if ((getRandom() < 0.5) || (total + shift.amount > limit)) {
+			shift.amount = -shift.amount;
+		}
+		if (total + shift.amount < -limit) {
+			shift.amount = -shift.amount;
+		}
+		total += shift.amount;
+		m_shifts.push_back(shift);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::makeHoles -- Punch each tracker-bar position with notes
+//     of random lengths.  A note is either one hole or a chain of short
+//     holes separated by paper bridges which are thinner than the bridge
+//     factor of the roll type, and notes are separated by more than that.
+//
+
+void RollSynthesizer::makeHoles(void) {
+	int tracks = getExpectedTrackerHoleCount();
+	double bridge = getBridgeFactor() * m_punchWidth;
+	double minlength = std::max(m_punchWidth, 0.08 * m_dpi);
+	double maxlength = std::max(minlength, 0.9 * m_dpi);
+	double meanlength = (minlength + maxlength) / 2.0;
+	double meangap = meanlength * (1.0 - m_density) / m_density;
+	double mingap = std::ceil(2.0 * std::max(m_punchWidth, bridge)) + 2.0;
+	double maxrow = m_lastHole;
+
+	for (int position=1; position<=tracks; position++) {
+		if (!isPunchable(position)) {
+			continue;
+		}
+		double row = m_firstHole + getRandom(0.0, meangap);
+		while (true) {
+			vector<pair<ulongint, ulongint>> chain;
+			if (getRandom() < m_bridgeRate) {
+				int count = 2 + (int)(getRandom() * 4.0);
+				double start = row;
+				for (int i=0; i<count; i++) {
+					double length = getRandom(std::max(1.2 * m_punchWidth, 4.0),
+							std::max(2.5 * m_punchWidth, 6.0));
+					chain.emplace_back((ulongint)start, (ulongint)length);
+					start += (ulongint)length;
+					start += (ulongint)getRandom(std::max(2.0, 0.25 * bridge),
+							std::max(3.0, 0.6 * bridge));
+				}
+			} else {
+				chain.emplace_back((ulongint)row, (ulongint)getRandom(minlength, maxlength));
+			}
+			ulongint offtime = chain.back().first + chain.back().second;
+			if (offtime > maxrow) {
+				break;
+			}
+			for (ulongint i=0; i<chain.size(); i++) {
+				SynthHole hole;
+				hole.row      = chain[i].first;
+				hole.length   = chain[i].second;
+				hole.width    = m_punchWidth;
+				hole.position = position;
+				hole.midi     = m_bass_midi + position - 1;
+				hole.note     = m_notes;
+				hole.offtime  = offtime;
+				hole.attack   = i == 0;
+				m_holes.push_back(hole);
+			}
+			m_notes++;
+			row = offtime + mingap - std::log(1.0 - getRandom()) * meangap;
+		}
+	}
+
+	// The rewind hole follows the music.
+	int rewind = getRewindHoleBassNumber();
+	ulongint lastrow = 0;
+	for (ulongint i=0; i<m_holes.size(); i++) {
+		lastrow = std::max(lastrow, m_holes[i].row + m_holes[i].length);
+	}
+	if ((rewind > 0) && (lastrow + 0.75 * m_dpi < m_rows - 0.5 * m_dpi)) {
+		SynthHole hole;
+		hole.row      = lastrow + (ulongint)(0.5 * m_dpi);
+		hole.length   = (ulongint)(0.25 * m_dpi);
+		hole.width    = m_punchWidth;
+		hole.position = rewind;
+		hole.midi     = getRewindHoleMidi();
+		hole.note     = m_notes++;
+		hole.offtime  = hole.row + hole.length;
+		hole.rewind   = true;
+		m_holes.push_back(hole);
+	}
+
+	std::stable_sort(m_holes.begin(), m_holes.end(),
+		[](const SynthHole& a, const SynthHole& b) {
+			return a.row == b.row ? a.position < b.position : a.row < b.row;
+		});
+
+	m_trackHoles.assign(tracks + 1, vector<ulongint>());
+	m_firstHole = m_holes.empty() ? 0 : m_holes[0].row;
+	m_lastHole = 0;
+	for (ulongint i=0; i<m_holes.size(); i++) {
+		SynthHole& hole = m_holes[i];
+		hole.col = m_firstTrack + (hole.position - 1) * m_spacing + getOffset(hole.row);
+		m_trackHoles.at(hole.position).push_back(i);
+		m_lastHole = std::max(m_lastHole, hole.row + hole.length);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::makeTears -- Place triangular tears into the edges of
+//     the music region.  They are deeper than 1/10 of an inch (so that they
+//     are counted as edge tears), but stop short of the outer holes when
+//     the margin allows.
+//
+
+void RollSynthesizer::makeTears(void) {
+	double mindepth = 0.11 * m_dpi;
+	double maxdepth = std::max(mindepth, m_firstTrack - m_paperLeft - m_punchWidth);
+	for (int i=0; i<m_tearCount; i++) {
+		SynthTear tear;
+		tear.treble = getRandom() < 0.5;
+		tear.depth  = getRandom(mindepth, maxdepth);
+		tear.length = std::max((ulongint)4, (ulongint)(2.0 * tear.depth));
+		tear.row    = (ulongint)getRandom(m_firstHole, m_lastHole - tear.length);
+		m_tears.push_back(tear);
+	}
+	std::sort(m_tears.begin(), m_tears.end(),
+		[](const SynthTear& a, const SynthTear& b) { return a.row < b.row; });
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::makeDust -- Half of the dust specks are bright spots on
+//     the paper (smaller than the antidust area limit), and half are dark
+//     spots in the hard margins.
+//
+
+void RollSynthesizer::makeDust(void) {
+	ulongint count = (ulongint)(m_dustRate * m_rows / (12.0 * m_dpi) + 0.5);
+	double hardmargin = m_paperLeft - m_drift * m_dpi - (m_shiftCount > 0 ? 0.06 * m_dpi : 0.0);
+	double lastcol = m_firstTrack + (getExpectedTrackerHoleCount() - 1) * m_spacing;
+	for (ulongint i=0; i<count; i++) {
+		SynthDust dust;
+		dust.dark = getRandom() < 0.5;
+		if (dust.dark) {
+			dust.size = std::max((ulongint)2, (ulongint)(0.01 * m_dpi + 0.5));
+			double col = getRandom(0.0, std::max(1.0, hardmargin - 2.0 * dust.size));
+			if (getRandom() < 0.5) {
+				col = m_cols - 1 - col - dust.size;
+			}
+			dust.col = (ulongint)col;
+		} else {
+			dust.size = std::max((ulongint)2, (ulongint)(0.007 * m_dpi + 0.5));
+			dust.col = (ulongint)getRandom(m_firstTrack, lastcol);
+		}
+		dust.row = (ulongint)getRandom(0.0, m_rows - dust.size);
+		m_dust.push_back(dust);
+	}
+	std::sort(m_dust.begin(), m_dust.end(),
+		[](const SynthDust& a, const SynthDust& b) { return a.row < b.row; });
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::getOffset -- Sideways position of the paper at a row:
+//     two slow sine curves plus the operator shifts up to that row.
+//
+
+double RollSynthesizer::getOffset(ulongint row) const {
+	double amplitude = m_drift * m_dpi;
+	double output = amplitude * (0.7 * std::sin(2.0 * M_PI * row / (30.0 * m_dpi))
+			+ 0.3 * std::sin(2.0 * M_PI * row / (11.0 * m_dpi) + m_driftPhase));
+	for (ulongint i=0; i<m_shifts.size(); i++) {
+		const SynthShift& shift = m_shifts[i];
+		if (row >= shift.row + shift.length) {
+			output += shift.amount;
+		} else if (row > shift.row) {
+			output += shift.amount * (row - shift.row) / shift.length;
+		} else {
+			break;
+		}
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::getPaperEdges -- Bass and treble edge columns of the
+//     paper at a row, including the leader taper and tears.
+//
+
+void RollSynthesizer::getPaperEdges(ulongint row, double& left,
+		double& right) const {
+	double offset = getOffset(row);
+	left = m_paperLeft + offset;
+	right = m_paperLeft + m_paperWidth + offset;
+
+	double inset = 0.0;
+	if (row < m_preleaderRow) {
+		inset = 1.75 * m_dpi;
+	} else if (row < m_leaderRow) {
+		inset = 0.75 * m_dpi * (m_leaderRow - row) / (double)(m_leaderRow - m_preleaderRow);
+	}
+	left += inset;
+	right -= inset;
+
+	for (ulongint i=0; i<m_tears.size(); i++) {
+		const SynthTear& tear = m_tears[i];
+		if (row < tear.row) {
+			break;
+		}
+		if (row >= tear.row + tear.length) {
+			continue;
+		}
+		double half = tear.length / 2.0;
+		double depth = tear.depth * (1.0 - std::fabs(row + 0.5 - tear.row - half) / half);
+		if (tear.treble) {
+			right -= depth;
+		} else {
+			left += depth;
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::getHoleColumns -- First and last pixel columns of a hole
+//     centered at the given column (pixels with their centers inside the
+//     punch width).
+//
+
+void RollSynthesizer::getHoleColumns(double center, long& first,
+		long& last) const {
+	first = (long)std::ceil(center - m_punchWidth / 2.0 - 0.5);
+	last  = (long)std::floor(center + m_punchWidth / 2.0 - 0.5);
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::renderRow -- Fill a row of RGB pixels.  Rows may be
+//     rendered in any order and from several threads once generate() has
+//     been called.
+//
+
+void RollSynthesizer::renderRow(ulongint row, vector<ucharint>& rgb) const {
+	rgb.assign(m_cols * 3, 255);
+	if (!m_generated) {
+		return;
+	}
+
+	double left;
+	double right;
+	getPaperEdges(row, left, right);
+	long first = std::max(0L, (long)std::ceil(left));
+	long last = std::min((long)m_cols, (long)std::floor(right));
+	const ucharint* texture = m_texture.data() + (row * 2731) % 4096;
+	for (long c=first; c<last; c++) {
+		ucharint value = texture[c];
+		rgb[3*c + 0] = (ucharint)std::min(255, value + 25);
+		rgb[3*c + 1] = value;
+		rgb[3*c + 2] = (ucharint)(value * 3 / 4);
+	}
+
+	double offset = getOffset(row);
+	for (ulongint p=1; p<m_trackHoles.size(); p++) {
+		const vector<ulongint>& list = m_trackHoles[p];
+		auto it = std::upper_bound(list.begin(), list.end(), row,
+				[this](ulongint value, ulongint index) {
+					return value < m_holes[index].row;
+				});
+		if (it == list.begin()) {
+			continue;
+		}
+		const SynthHole& hole = m_holes[*(it - 1)];
+		if (row >= hole.row + hole.length) {
+			continue;
+		}
+		long hfirst;
+		long hlast;
+		getHoleColumns(m_firstTrack + (hole.position - 1) * m_spacing + offset, hfirst, hlast);
+		hfirst = std::max(hfirst, 0L);
+		hlast = std::min(hlast, (long)m_cols - 1);
+		for (long c=hfirst; c<=hlast; c++) {
+			rgb[3*c + 0] = 255;
+			rgb[3*c + 1] = 255;
+			rgb[3*c + 2] = 255;
+		}
+	}
+
+	// Dust specks are at most a few pixels tall, so start searching a
+	// little above the row.
+	ulongint start = row > 16 ? row - 16 : 0;
+	auto it = std::lower_bound(m_dust.begin(), m_dust.end(), start,
+			[](const SynthDust& dust, ulongint value) { return dust.row < value; });
+	for (; (it != m_dust.end()) && (it->row <= row); it++) {
+		if (row >= it->row + it->size) {
+			continue;
+		}
+		ucharint value = it->dark ? 40 : 255;
+		for (ulongint c=it->col; (c<it->col + it->size) && (c<m_cols); c++) {
+			rgb[3*c + 0] = value;
+			rgb[3*c + 1] = value;
+			rgb[3*c + 2] = value;
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::writeTiffHeader -- Write an image file directory for a
+//     single strip of uncompressed RGB pixels, padded to the start of the
+//     pixel data at byte 512.
+//
+
+void RollSynthesizer::writeTiffHeader(ostream& out, bool bigtiff) {
+	ulonglongint dataoffset = 512;
+	ulonglongint databytes = (ulonglongint)m_rows * m_cols * 3;
+	ulongint dpi = (ulongint)(m_dpi * 100.0 + 0.5);
+
+	// tag, datatype, count, value (shorts and longs in place, rationals
+	// in place for BigTIFF or after the directory for TIFF).
+	struct Entry { int tag; int type; int count; ulonglongint value; };
+	vector<Entry> entries = {
+		{256, 4, 1, m_cols},
+		{257, 4, 1, m_rows},
+		{258, 3, 3, 0},    // bits per sample: 8, 8, 8
+		{259, 3, 1, 1},    // no compression
+		{262, 3, 1, 2},    // RGB
+		{273, bigtiff ? 16 : 4, 1, dataoffset},
+		{277, 3, 1, 3},    // samples per pixel
+		{278, 4, 1, m_rows},
+		{279, bigtiff ? 16 : 4, 1, databytes},
+		{282, 5, 1, 0},    // horizontal dpi
+		{283, 5, 1, 0},    // vertical dpi
+		{284, 3, 1, 1},    // contiguous samples
+		{296, 3, 1, 2}     // inches
+	};
+
+	ulonglongint position;
+	ulonglongint extra;   // byte offset of values after the directory
+	out.write("II", 2);
+	if (bigtiff) {
+		writeLittleEndian2ByteUInt(out, 43);
+		writeLittleEndian2ByteUInt(out, 8);
+		writeLittleEndian2ByteUInt(out, 0);
+		writeLittleEndian8ByteUInt(out, 16);
+		writeLittleEndian8ByteUInt(out, entries.size());
+		position = 16 + 8 + 20 * entries.size() + 8;
+	} else {
+		writeLittleEndian2ByteUInt(out, 42);
+		writeLittleEndian4ByteUInt(out, 8);
+		writeLittleEndian2ByteUInt(out, (ushortint)entries.size());
+		position = 8 + 2 + 12 * entries.size() + 4;
+	}
+	extra = position;
+
+	for (ulongint i=0; i<entries.size(); i++) {
+		const Entry& entry = entries[i];
+		writeLittleEndian2ByteUInt(out, (ushortint)entry.tag);
+		writeLittleEndian2ByteUInt(out, (ushortint)entry.type);
+		if (bigtiff) {
+			writeLittleEndian8ByteUInt(out, entry.count);
+		} else {
+			writeLittleEndian4ByteUInt(out, entry.count);
+		}
+		ulongint size = bigtiff ? 8 : 4;
+		if (entry.tag == 258) {
+			if (bigtiff) {
+				for (int j=0; j<3; j++) {
+					writeLittleEndian2ByteUInt(out, 8);
+				}
+				writeLittleEndian2ByteUInt(out, 0);
+			} else {
+				writeLittleEndian4ByteUInt(out, (ulongint)extra);
+				extra += 6;
+			}
+		} else if (entry.type == 5) {
+			if (bigtiff) {
+				writeLittleEndian4ByteUInt(out, dpi);
+				writeLittleEndian4ByteUInt(out, 100);
+			} else {
+				writeLittleEndian4ByteUInt(out, (ulongint)extra);
+				extra += 8;
+			}
+		} else if (entry.type == 3) {
+			writeLittleEndian2ByteUInt(out, (ushortint)entry.value);
+			for (ulongint j=2; j<size; j+=2) {
+				writeLittleEndian2ByteUInt(out, 0);
+			}
+		} else if (entry.type == 4) {
+			writeLittleEndian4ByteUInt(out, (ulongint)entry.value);
+			if (bigtiff) {
+				writeLittleEndian4ByteUInt(out, 0);
+			}
+		} else {
+			writeLittleEndian8ByteUInt(out, entry.value);
+		}
+	}
+
+	// offset to the next directory (none):
+	if (bigtiff) {
+		writeLittleEndian8ByteUInt(out, 0);
+	} else {
+		writeLittleEndian4ByteUInt(out, 0);
+		// values which do not fit into the entries:
+		for (int j=0; j<3; j++) {
+			writeLittleEndian2ByteUInt(out, 8);
+		}
+		writeLittleEndian4ByteUInt(out, dpi);
+		writeLittleEndian4ByteUInt(out, 100);
+		writeLittleEndian4ByteUInt(out, dpi);
+		writeLittleEndian4ByteUInt(out, 100);
+		position = extra;
+	}
+
+	string padding(dataoffset - position, '\0');
+	out.write(padding.data(), padding.size());
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::writeTiff -- Write the image as an uncompressed RGB TIFF.
+//     BigTIFF is used if requested or if the pixels do not fit into 4 GB.
+//
+
+bool RollSynthesizer::writeTiff(const string& filename) {
+	if (!m_generated && !generate()) {
+		return false;
+	}
+
+	ofstream output(filename, ios::binary | ios::out | ios::trunc);
+	if (!output.is_open()) {
+		cerr << "Error: cannot write " << filename << endl;
+		return false;
+	}
+
+	ulonglongint databytes = (ulonglongint)m_rows * m_cols * 3;
+	bool bigtiff = m_bigTiff || (databytes > 0xffffffffULL - 512);
+	writeTiffHeader(output, bigtiff);
+
+	vector<ucharint> rgb;
+	for (ulongint r=0; r<m_rows; r++) {
+		renderRow(r, rgb);
+		output.write((const char*)rgb.data(), rgb.size());
+	}
+	output.flush();
+	if (!output.good()) {
+		cerr << "Error: problem writing " << filename << endl;
+		return false;
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::printTruth -- Print the generated roll features with the
+//     same ATON parameter names as the analysis output (the hole and note
+//     counts include the rewind hole).  TRACKER_HOLE is the tracker-bar
+//     position counted from 1 at the bass edge of the paper, WIDTH_ROW is
+//     the number of rows in the hole, and the hole columns are given at the
+//     first row of each hole.
+//
+
+ostream& RollSynthesizer::printTruth(ostream& out) {
+	if (!m_generated && !generate()) {
+		return out;
+	}
+
+	ulongint antidust = 0;
+	for (ulongint i=0; i<m_dust.size(); i++) {
+		if (!m_dust[i].dark) {
+			antidust++;
+		}
+	}
+	ulongint basstears = 0;
+	for (ulongint i=0; i<m_tears.size(); i++) {
+		if (!m_tears[i].treble) {
+			basstears++;
+		}
+	}
+	long first;
+	long last;
+	getHoleColumns(0.0, first, last);
+	double offset = std::fmod(m_firstTrack, m_spacing);
+
+	out << "@@ Ground truth for a synthetic piano-roll image.\n";
+	out << "\n@@BEGIN: ROLLINFO\n";
+	out << "@ROLL_TYPE:\t\t"         << getRollType()                     << endl;
+	out << "@SEED:\t\t\t"            << m_seed                            << endl;
+	out << "@LENGTH_DPI:\t\t"        << m_dpi                             << "ppi" << endl;
+	out << "@IMAGE_WIDTH:\t\t"       << m_cols                            << "px" << endl;
+	out << "@IMAGE_LENGTH:\t\t"      << m_rows                            << "px" << endl;
+	out << "@ROLL_WIDTH:\t\t"        << m_paperWidth                      << "px" << endl;
+	out << "@PRELEADER_ROW:\t\t"     << m_preleaderRow                    << "px" << endl;
+	out << "@LEADER_ROW:\t\t"        << m_leaderRow                       << "px" << endl;
+	out << "@FIRST_HOLE:\t\t"        << m_firstHole                       << "px" << endl;
+	out << "@LAST_HOLE:\t\t"         << m_lastHole                        << "px" << endl;
+	out << "@MUSICAL_HOLES:\t\t"     << m_holes.size()                    << endl;
+	out << "@MUSICAL_NOTES:\t\t"     << m_notes                           << endl;
+	out << "@AVG_HOLE_WIDTH:\t"      << last - first + 1                  << "px" << endl;
+	out << "@ANTIDUST_COUNT:\t"      << antidust                          << endl;
+	out << "@DUST_COUNT:\t\t"        << m_dust.size() - antidust          << endl;
+	out << "@EDGE_TEAR_COUNT:\t"     << m_tears.size()                    << endl;
+	out << "@BASS_TEAR_COUNT:\t"     << basstears                         << endl;
+	out << "@TREBLE_TEAR_COUNT:\t"   << m_tears.size() - basstears        << endl;
+	out << "@SHIFTS:\t\t"            << m_shifts.size()                   << endl;
+	out << "@HOLE_SEPARATION:\t"     << m_spacing                         << "px" << endl;
+	out << "@HOLE_OFFSET:\t\t"       << offset                            << "px" << endl;
+	out << "@TRACKER_HOLES:\t\t"     << getExpectedTrackerHoleCount()     << endl;
+	out << "@@END: ROLLINFO\n";
+
+	vector<ulongint> counts(m_trackHoles.size(), 0);
+	out << "\n@@BEGIN: HOLES\n";
+	for (ulongint i=0; i<m_holes.size(); i++) {
+		const SynthHole& hole = m_holes[i];
+		getHoleColumns(hole.col, first, last);
+		out << "\n@@BEGIN: HOLE\n";
+		out << "@ID:\t\tK" << hole.midi << "_N" << ++counts.at(hole.position) << endl;
+		out << "@ORIGIN_ROW:\t"   << hole.row                << "px" << endl;
+		out << "@ORIGIN_COL:\t"   << first                   << "px" << endl;
+		out << "@WIDTH_ROW:\t"    << hole.length             << "px" << endl;
+		out << "@WIDTH_COL:\t"    << last - first + 1        << "px" << endl;
+		out << "@CENTROID_COL:\t" << hole.col                << "px" << endl;
+		if (hole.attack) {
+			out << "@NOTE_ATTACK:\t" << hole.row              << "px" << endl;
+			out << "@OFF_TIME:\t"    << hole.offtime          << "px" << endl;
+		}
+		out << "@TRACKER_HOLE:\t" << hole.position           << endl;
+		out << "@MIDI_KEY:\t"     << hole.midi               << endl;
+		if (hole.rewind) {
+			out << "@REWIND:\t\ttrue" << endl;
+		}
+		out << "@@END: HOLE\n";
+	}
+	out << "\n@@END: HOLES\n";
+
+	out << "\n@@BEGIN: TEARS\n";
+	for (ulongint i=0; i<m_tears.size(); i++) {
+		const SynthTear& tear = m_tears[i];
+		out << "\n@@BEGIN: TEAR\n";
+		out << "@ORIGIN_ROW:\t" << tear.row                  << "px" << endl;
+		out << "@WIDTH_ROW:\t"  << tear.length               << "px" << endl;
+		out << "@DEPTH:\t\t"    << tear.depth                << "px" << endl;
+		out << "@SIDE:\t\t"     << (tear.treble ? "treble" : "bass") << endl;
+		out << "@@END: TEAR\n";
+	}
+	out << "\n@@END: TEARS\n";
+
+	out << "\n@@BEGIN: SHIFTS\n";
+	for (ulongint i=0; i<m_shifts.size(); i++) {
+		const SynthShift& shift = m_shifts[i];
+		out << "\n@@BEGIN: SHIFT\n";
+		out << "@ROW:\t\t"      << shift.row                 << "px" << endl;
+		out << "@WIDTH_ROW:\t"  << shift.length              << "px" << endl;
+		out << "@MOVEMENT:\t"   << int(shift.amount * 100 + (shift.amount < 0 ? -0.5 : 0.5)) / 100.0 << "px" << endl;
+		out << "@@END: SHIFT\n";
+	}
+	out << "\n@@END: SHIFTS\n";
+
+	return out;
+}
+
+
+
+//////////////////////////////
+//
+// RollSynthesizer::writeTruth -- Write the ground truth to a file ("-" for
+//     standard output).
+//
+
+bool RollSynthesizer::writeTruth(const string& filename) {
+	if (filename == "-") {
+		printTruth(cout);
+		return cout.good();
+	}
+	ofstream output(filename);
+	if (!output.is_open()) {
+		cerr << "Error: cannot write " << filename << endl;
+		return false;
+	}
+	printTruth(output);
+	return output.good();
+}
+
+
+
+} // end rip namespace
+
+
+
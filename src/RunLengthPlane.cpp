@@ -0,0 +1,484 @@
+//
+// Creation Date: Fri Oct 16 15:08:52 PDT 2026
+// Last Modified: Fri Oct 16 15:08:52 PDT 2026
+// Filename:      RunLengthPlane.cpp
+// Web Address:
+// Syntax:        C++
+// vim:           ts=3:nowrap:ft=text
+//
+// Description:   Run-length encoded image plane for pixel classes.
+//
+
+#include "RunLengthPlane.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace rip  {
+
+
+//////////////////////////////
+//
+// RunLengthPlane::RunLengthPlane -- Constructor.
+//
+
+RunLengthPlane::RunLengthPlane(void) {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// RunLengthPlane::~RunLengthPlane -- Destructor.
+//
+
+RunLengthPlane::~RunLengthPlane() {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// RunLengthPlane::resize -- Set the size of the plane, with every pixel
+//    set to the given value.
+//
+
+void RunLengthPlane::resize(ulongint rows, ulongint cols, ucharint value) {
+	m_rows.clear();
+	m_rows.shrink_to_fit();
+	m_cols = cols;
+	m_rows.resize(rows);
+	if (cols == 0) {
+		return;
+	}
+	PixelRun run;
+	run.start = 0;
+	run.value = value;
+	for (ulongint r=0; r<rows; r++) {
+		m_rows[r].push_back(run);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// RunLengthPlane::clear -- Release the memory for the plane.
+//
+
+void RunLengthPlane::clear(void) {
+	m_rows.clear();
+	m_rows.shrink_to_fit();
+	m_cols = 0;
+}
+
+
+
+//////////////////////////////
+//
+// RunLengthPlane::encodeRow -- Store a row of pixels (getCols() values)
+//    as runs.
+//
+
+void RunLengthPlane::encodeRow(ulongint row, const ucharint* pixels) {
+	vector<PixelRun>& runs = m_rows[row];
+	runs.clear();
+	for (ulongint c=0; c<m_cols; c++) {
+		if (runs.empty() || (runs.back().value != pixels[c])) {
+			PixelRun run;
+			run.start = (unsigned int)c;
+			run.value = pixels[c];
+			runs.push_back(run);
+		}
+	}
+	runs.shrink_to_fit();
+}
+
+
+
+//////////////////////////////
+//
+// RunLengthPlane::decodeRow -- Expand the runs of a row into getCols()
+//    pixels.
+//
+
+void RunLengthPlane::decodeRow(ulongint row, ucharint* pixels) const {
+	const vector<PixelRun>& runs = m_rows[row];
+	for (ulongint i=0; i<runs.size(); i++) {
+		ulongint end = getRunEnd(row, i);
+		std::fill(pixels + runs[i].start, pixels + end, runs[i].value);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// RunLengthPlane::releaseRow -- Free the runs of a row (the row is empty
+//    afterwards, so it must be encoded again before it is used).
+//
+
+void RunLengthPlane::releaseRow(ulongint row) {
+	vector<PixelRun>().swap(m_rows[row]);
+}
+
+
+
+//////////////////////////////
+//
+// RunLengthPlane::expandTo -- Convert to a one-byte-per-pixel plane.  The
+//    runs of each row are released as soon as the row has been expanded,
+//    so that both representations of the full image are never held in
+//    memory at the same time.  The run-length plane is empty afterwards.
+//
+
+void RunLengthPlane::expandTo(ImagePlane<ucharint>& plane) {
+	plane.resize(getRows(), getCols(), true);
+	for (ulongint r=0; r<getRows(); r++) {
+		decodeRow(r, plane.getRow(r));
+		releaseRow(r);
+	}
+	clear();
+}
+
+
+
+//////////////////////////////
+//
+// RunLengthPlane::getRunEnd -- Return the column after the last pixel
+//    of the given run in a row.
+//
+
+ulongint RunLengthPlane::getRunEnd(ulongint row, ulongint index) const {
+	const vector<PixelRun>& runs = m_rows[row];
+	if (index + 1 < runs.size()) {
+		return runs[index+1].start;
+	}
+	return m_cols;
+}
+
+
+
+//////////////////////////////
+//
+// RunLengthPlane::getValue -- Return the value of a single pixel.
+//
+
+ucharint RunLengthPlane::getValue(ulongint row, ulongint col) const {
+	const vector<PixelRun>& runs = m_rows[row];
+	ulongint low = 0;
+	ulongint high = runs.size();
+	while (high - low > 1) {
+		ulongint mid = (low + high) / 2;
+		if (runs[mid].start <= col) {
+			low = mid;
+		} else {
+			high = mid;
+		}
+	}
+	return runs[low].value;
+}
+
+
+
+//////////////////////////////
+//
+// RunLengthPlane::getRunCount -- Return the total number of runs in
+//    the plane.
+//
+
+ulongint RunLengthPlane::getRunCount(void) const {
+	ulongint sum = 0;
+	for (ulongint r=0; r<m_rows.size(); r++) {
+		sum += m_rows[r].size();
+	}
+	return sum;
+}
+
+
+
+//////////////////////////////
+//
+// RunLengthPlane::getMemorySize -- Return the number of bytes used to
+//    store the plane.
+//
+
+ulongint RunLengthPlane::getMemorySize(void) const {
+	ulongint sum = m_rows.capacity() * sizeof(vector<PixelRun>);
+	for (ulongint r=0; r<m_rows.size(); r++) {
+		sum += m_rows[r].capacity() * sizeof(PixelRun);
+	}
+	return sum;
+}
+
+
+
+//////////////////////////////
+//
+// RunLengthPlane::findValue -- Return the first column at or after
+//    startcol which has the given value, or -1 if there is none.
+//
+
+long RunLengthPlane::findValue(ulongint row, ulongint startcol,
+		ucharint value) const {
+	const vector<PixelRun>& runs = m_rows[row];
+	for (ulongint i=0; i<runs.size(); i++) {
+		ulongint end = getRunEnd(row, i);
+		if ((end <= startcol) || (runs[i].value != value)) {
+			continue;
+		}
+		return (long)std::max((ulongint)runs[i].start, startcol);
+	}
+	return -1;
+}
+
+
+
+//////////////////////////////
+//
+// RunLengthPlane::findValueReverse -- Return the last column at or before
+//    startcol which has the given value, or -1 if there is none.
+//
+
+long RunLengthPlane::findValueReverse(ulongint row, ulongint startcol,
+		ucharint value) const {
+	const vector<PixelRun>& runs = m_rows[row];
+	for (long i=(long)runs.size()-1; i>=0; i--) {
+		if ((runs[i].start > startcol) || (runs[i].value != value)) {
+			continue;
+		}
+		ulongint last = getRunEnd(row, i) - 1;
+		return (long)std::min(last, startcol);
+	}
+	return -1;
+}
+
+
+
+//////////////////////////////
+//
+// RunLengthPlane::countValues -- Return the number of pixels in columns
+//    [startcol, endcol) of a row which have a value from lowest to highest.
+//
+
+ulongint RunLengthPlane::countValues(ulongint row, ulongint startcol,
+		ulongint endcol, ucharint lowest, ucharint highest) const {
+	const vector<PixelRun>& runs = m_rows[row];
+	ulongint count = 0;
+	for (ulongint i=0; i<runs.size(); i++) {
+		if ((runs[i].value < lowest) || (runs[i].value > highest)) {
+			continue;
+		}
+		ulongint start = std::max((ulongint)runs[i].start, startcol);
+		ulongint end   = std::min(getRunEnd(row, i), endcol);
+		if (start < end) {
+			count += end - start;
+		}
+	}
+	return count;
+}
+
+
+
+//////////////////////////////
+//
+// RunLengthPlane::replaceValues -- Set the pixels in columns [startcol,
+//    endcol) of a row which have a value from lowest to highest to the
+//    given value.
+//
+
+void RunLengthPlane::replaceValues(ulongint row, ulongint startcol,
+		ulongint endcol, ucharint lowest, ucharint highest, ucharint value) {
+	const vector<PixelRun>& runs = m_rows[row];
+	vector<ColumnSpan> spans;
+	for (ulongint i=0; i<runs.size(); i++) {
+		if ((runs[i].value < lowest) || (runs[i].value > highest)) {
+			continue;
+		}
+		ulongint start = std::max((ulongint)runs[i].start, startcol);
+		ulongint end   = std::min(getRunEnd(row, i), endcol);
+		if (start < end) {
+			spans.push_back(ColumnSpan(start, end));
+		}
+	}
+	if (!spans.empty()) {
+		setSpans(row, spans, value);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// RunLengthPlane::spreadValue -- Every pixel in torow which is next to
+//    a pixel in fromrow that has the given value, and which is not
+//    a barrier pixel, is set to the value.  The columns of these pixels
+//    are returned in spans (including pixels which already had the value).
+//
+
+void RunLengthPlane::spreadValue(ulongint fromrow, ulongint torow,
+		ucharint value, ucharint barrier, vector<ColumnSpan>& spans) {
+	spans.clear();
+	const vector<PixelRun>& from = m_rows[fromrow];
+	const vector<PixelRun>& to   = m_rows[torow];
+	ulongint j = 0;
+	for (ulongint i=0; i<from.size(); i++) {
+		if (from[i].value != value) {
+			continue;
+		}
+		ulongint start = from[i].start;
+		ulongint end   = getRunEnd(fromrow, i);
+		while ((j < to.size()) && (getRunEnd(torow, j) <= start)) {
+			j++;
+		}
+		for (ulongint k=j; (k < to.size()) && (to[k].start < end); k++) {
+			if (to[k].value == barrier) {
+				continue;
+			}
+			ulongint s = std::max((ulongint)to[k].start, start);
+			ulongint e = std::min(getRunEnd(torow, k), end);
+			if (!spans.empty() && (spans.back().second == s)) {
+				spans.back().second = e;
+			} else {
+				spans.push_back(ColumnSpan(s, e));
+			}
+		}
+	}
+	if (!spans.empty()) {
+		setSpans(torow, spans, value);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// RunLengthPlane::spreadValueRight -- Extend pixels with the given value
+//    to the right until a barrier pixel is reached.  The columns of the
+//    pixels to the right of a pixel with the value are returned in spans
+//    (including pixels which already had the value).
+//
+
+void RunLengthPlane::spreadValueRight(ulongint row, ucharint value,
+		ucharint barrier, vector<ColumnSpan>& spans) {
+	spans.clear();
+	const vector<PixelRun>& runs = m_rows[row];
+	long first = -1;  // first pixel with value in current non-barrier stretch
+	for (ulongint i=0; i<=runs.size(); i++) {
+		if ((i == runs.size()) || (runs[i].value == barrier)) {
+			if (first >= 0) {
+				ulongint end = (i == runs.size()) ? m_cols : runs[i].start;
+				if ((ulongint)first + 1 < end) {
+					spans.push_back(ColumnSpan(first + 1, end));
+				}
+			}
+			first = -1;
+		} else if ((first < 0) && (runs[i].value == value)) {
+			first = runs[i].start;
+		}
+	}
+	if (!spans.empty()) {
+		setSpans(row, spans, value);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// RunLengthPlane::spreadValueLeft -- Extend pixels with the given value
+//    to the left until a barrier pixel is reached.  The columns of the
+//    pixels to the left of a pixel with the value are returned in spans
+//    (including pixels which already had the value), in left to right
+//    order.
+//
+
+void RunLengthPlane::spreadValueLeft(ulongint row, ucharint value,
+		ucharint barrier, vector<ColumnSpan>& spans) {
+	spans.clear();
+	const vector<PixelRun>& runs = m_rows[row];
+	long start = -1;  // start of current non-barrier stretch
+	long last  = -1;  // last pixel with value in current stretch
+	for (ulongint i=0; i<=runs.size(); i++) {
+		if ((i == runs.size()) || (runs[i].value == barrier)) {
+			if ((start >= 0) && (last > start)) {
+				spans.push_back(ColumnSpan(start, last));
+			}
+			start = -1;
+			last  = -1;
+			continue;
+		}
+		if (start < 0) {
+			start = runs[i].start;
+		}
+		if (runs[i].value == value) {
+			last = (long)getRunEnd(row, i) - 1;
+		}
+	}
+	if (!spans.empty()) {
+		setSpans(row, spans, value);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// RunLengthPlane::setSpans -- Set the pixels in a row which are inside of
+//    the spans to the given value.  The spans must be sorted and must not
+//    overlap.
+//
+
+void RunLengthPlane::setSpans(ulongint row, const vector<ColumnSpan>& spans,
+		ucharint value) {
+	const vector<PixelRun>& runs = m_rows[row];
+	vector<PixelRun> output;
+	output.reserve(runs.size() + 2 * spans.size());
+	ulongint k = 0;
+	for (ulongint i=0; i<runs.size(); i++) {
+		ulongint pos = runs[i].start;
+		ulongint end = getRunEnd(row, i);
+		while (pos < end) {
+			while ((k < spans.size()) && (spans[k].second <= pos)) {
+				k++;
+			}
+			if ((k < spans.size()) && (spans[k].first <= pos)) {
+				appendRun(output, pos, value);
+				pos = std::min(end, spans[k].second);
+			} else {
+				appendRun(output, pos, runs[i].value);
+				pos = (k < spans.size()) ? std::min(end, spans[k].first) : end;
+			}
+		}
+	}
+	output.shrink_to_fit();
+	m_rows[row].swap(output);
+}
+
+
+
+//////////////////////////////
+//
+// RunLengthPlane::appendRun -- Add a run to the end of a row, merging it
+//    with the last run if it has the same value.
+//
+
+void RunLengthPlane::appendRun(vector<PixelRun>& runs, ulongint start,
+		ucharint value) {
+	if (!runs.empty() && (runs.back().value == value)) {
+		return;
+	}
+	PixelRun run;
+	run.start = (unsigned int)start;
+	run.value = value;
+	runs.push_back(run);
+}
+
+
+} // end rip namespace
+
+
+
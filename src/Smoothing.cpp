@@ -0,0 +1,481 @@
+//
+// Creation Date: Fri Oct 16 20:31:18 PDT 2026
+// Last Modified: Fri Oct 16 20:31:18 PDT 2026
+// Filename:      Smoothing.cpp
+// Web Address:
+// Syntax:        C++
+// vim:           ts=3:nowrap:ft=text
+//
+// Description:   Engine for the bidirectional first-order IIR filter of
+//                exponentialSmoothing().
+//
+
+#include "Smoothing.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define RIP_X86_SIMD
+	#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace rip  {
+
+// LANE_CHUNK: number of samples of each signal which are interleaved into
+// the lane buffer at a time (small enough to stay in cache).
+static const ulongint LANE_CHUNK = 1024;
+
+
+//////////////////////////////
+//
+// smoothLanesScalar -- Filter interleaved signals in one direction:
+//    data[i*lanes + j] is sample i of signal j, and state[j] is the
+//    previous output of signal j (updated on return).  The arithmetic is
+//    in the same order as exponentialSmoothing(), so the results are the
+//    same.
+//
+
+static void smoothLanesScalar(double* data, ulongint length, ulongint lanes,
+		const double* k, const double* nk, double* state) {
+	for (ulongint j=0; j<lanes; j++) {
+		double s = state[j];
+		double* p = data + j;
+		for (ulongint i=0; i<length; i++, p+=lanes) {
+			s = k[j] * *p + nk[j] * s;
+			*p = s;
+		}
+		state[j] = s;
+	}
+}
+
+
+#ifdef RIP_X86_SIMD
+
+//////////////////////////////
+//
+// smoothLanesSse2 -- Two signals per register (lanes must be a multiple
+//    of 2).  Separate multiplies and adds (no fused multiply-add) keep the
+//    rounding the same as the scalar filter.
+//
+
+static void smoothLanesSse2(double* data, ulongint length, ulongint lanes,
+		const double* k, const double* nk, double* state) {
+	for (ulongint j=0; j<lanes; j+=2) {
+		__m128d kk = _mm_loadu_pd(k + j);
+		__m128d nn = _mm_loadu_pd(nk + j);
+		__m128d s  = _mm_loadu_pd(state + j);
+		double* p = data + j;
+		for (ulongint i=0; i<length; i++, p+=lanes) {
+			s = _mm_add_pd(_mm_mul_pd(kk, _mm_loadu_pd(p)), _mm_mul_pd(nn, s));
+			_mm_storeu_pd(p, s);
+		}
+		_mm_storeu_pd(state + j, s);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// smoothLanesAvx2 -- Four signals per register.
+//
+
+__attribute__((target("avx2")))
+static void smoothLanesAvx2(double* data, ulongint length, ulongint lanes,
+		const double* k, const double* nk, double* state) {
+	for (ulongint j=0; j<lanes; j+=4) {
+		__m256d kk = _mm256_loadu_pd(k + j);
+		__m256d nn = _mm256_loadu_pd(nk + j);
+		__m256d s  = _mm256_loadu_pd(state + j);
+		double* p = data + j;
+		for (ulongint i=0; i<length; i++, p+=lanes) {
+			s = _mm256_add_pd(_mm256_mul_pd(kk, _mm256_loadu_pd(p)), _mm256_mul_pd(nn, s));
+			_mm256_storeu_pd(p, s);
+		}
+		_mm256_storeu_pd(state + j, s);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// smoothLanesAvx512 -- Eight signals per register.
+//
+
+__attribute__((target("avx512f")))
+static void smoothLanesAvx512(double* data, ulongint length, ulongint lanes,
+		const double* k, const double* nk, double* state) {
+	for (ulongint j=0; j<lanes; j+=8) {
+		__m512d kk = _mm512_loadu_pd(k + j);
+		__m512d nn = _mm512_loadu_pd(nk + j);
+		__m512d s  = _mm512_loadu_pd(state + j);
+		double* p = data + j;
+		for (ulongint i=0; i<length; i++, p+=lanes) {
+			s = _mm512_add_pd(_mm512_mul_pd(kk, _mm512_loadu_pd(p)), _mm512_mul_pd(nn, s));
+			_mm512_storeu_pd(p, s);
+		}
+		_mm512_storeu_pd(state + j, s);
+	}
+}
+
+#endif /* RIP_X86_SIMD */
+
+
+
+//////////////////////////////
+//
+// getLaneWidth -- Number of double-precision signals per register at
+//    the current SimdLevel.
+//
+
+static ulongint getLaneWidth(void) {
+#ifdef RIP_X86_SIMD
+	switch (getSimdLevel()) {
+		case SIMD_AVX512: return 8;
+		case SIMD_AVX2:   return 4;
+		case SIMD_SSSE3:  return 2;
+	}
+#endif
+	return 1;
+}
+
+
+
+//////////////////////////////
+//
+// smoothLanes -- Dispatch to the filter for the current SimdLevel.  lanes
+//    must be a multiple of getLaneWidth().
+//
+
+static void smoothLanes(double* data, ulongint length, ulongint lanes,
+		const double* k, const double* nk, double* state) {
+	switch (getLaneWidth()) {
+#ifdef RIP_X86_SIMD
+		case 8:
+			smoothLanesAvx512(data, length, lanes, k, nk, state);
+			return;
+		case 4:
+			smoothLanesAvx2(data, length, lanes, k, nk, state);
+			return;
+		case 2:
+			smoothLanesSse2(data, length, lanes, k, nk, state);
+			return;
+#endif
+	}
+	smoothLanesScalar(data, length, lanes, k, nk, state);
+}
+
+
+
+//////////////////////////////
+//
+// exponentialSmoothingLanes -- Apply exponentialSmoothing() to each signal
+//    with the matching gain, filtering all of the signals at once (one per
+//    SIMD lane).  The results are identical to exponentialSmoothing().  The
+//    signals are interleaved a chunk at a time, so the extra memory does
+//    not depend on the signal length.
+//
+
+void exponentialSmoothingLanes(vector<vector<double>*>& signals,
+		const vector<double>& gains) {
+	ulongint count = signals.size();
+	if (count == 0) {
+		return;
+	}
+	if (gains.size() != count) {
+		std::cerr << "Error: " << gains.size() << " gains for " << count
+		          << " signals" << std::endl;
+		return;
+	}
+	ulongint length = signals[0]->size();
+	for (ulongint j=1; j<count; j++) {
+		if (signals[j]->size() != length) {
+			// signals of different lengths are filtered one at a time
+			for (ulongint m=0; m<count; m++) {
+				exponentialSmoothing(*signals[m], gains[m]);
+			}
+			return;
+		}
+	}
+	if (length < 2) {
+		return;
+	}
+
+	ulongint width = getLaneWidth();
+	ulongint lanes = (count + width - 1) / width * width;
+	vector<double> k(lanes, 0.0);
+	vector<double> nk(lanes, 0.0);
+	vector<double> state(lanes, 0.0);
+	for (ulongint j=0; j<count; j++) {
+		k[j]  = gains[j];
+		nk[j] = 1.0 - gains[j];
+	}
+	vector<double> buffer(LANE_CHUNK * lanes, 0.0);
+
+	// Forward direction, starting from the second sample:
+	for (ulongint j=0; j<count; j++) {
+		state[j] = (*signals[j])[0];
+	}
+	for (ulongint start=1; start<length; start+=LANE_CHUNK) {
+		ulongint n = std::min(LANE_CHUNK, length - start);
+		for (ulongint j=0; j<count; j++) {
+			const double* input = signals[j]->data() + start;
+			for (ulongint t=0; t<n; t++) {
+				buffer[t * lanes + j] = input[t];
+			}
+		}
+		smoothLanes(buffer.data(), n, lanes, k.data(), nk.data(), state.data());
+		for (ulongint j=0; j<count; j++) {
+			double* output = signals[j]->data() + start;
+			for (ulongint t=0; t<n; t++) {
+				output[t] = buffer[t * lanes + j];
+			}
+		}
+	}
+
+	// Backward direction, starting from the second-to-last sample (the
+	// chunks are stored in reverse order in the buffer):
+	for (ulongint j=0; j<count; j++) {
+		state[j] = (*signals[j])[length - 1];
+	}
+	for (ulongint end=length-1; end>0; ) {
+		ulongint n = std::min(LANE_CHUNK, end);
+		for (ulongint j=0; j<count; j++) {
+			const double* input = signals[j]->data() + end - 1;
+			for (ulongint t=0; t<n; t++) {
+				buffer[t * lanes + j] = *(input - t);
+			}
+		}
+		smoothLanes(buffer.data(), n, lanes, k.data(), nk.data(), state.data());
+		for (ulongint j=0; j<count; j++) {
+			double* output = signals[j]->data() + end - 1;
+			for (ulongint t=0; t<n; t++) {
+				*(output - t) = buffer[t * lanes + j];
+			}
+		}
+		end -= n;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// filterBlocks -- One direction of exponentialSmoothingBlocks().  Sample t
+//    of the filter is x[t] (or x[length-1-t] when reverse is true), and the
+//    filter starts at t = 1.  Each block is first filtered from a zero
+//    state in parallel.  The true state at the start of each block is then
+//    carried from block to block, and its decaying contribution is added
+//    to the samples of the block in parallel.
+//
+
+static void filterBlocks(double* x, ulongint length, double gain,
+		ulongint blocksize, bool reverse) {
+	double k  = gain;
+	double nk = 1.0 - gain;
+	ulongint blocks = (length - 1 + blocksize - 1) / blocksize;
+	auto at = [x, length, reverse](ulongint t) -> double& {
+		return reverse ? x[length - 1 - t] : x[t];
+	};
+	auto blockStart = [blocksize](ulongint b) { return 1 + b * blocksize; };
+	auto blockEnd = [blocksize, length](ulongint b) {
+		return std::min(1 + (b + 1) * blocksize, length);
+	};
+
+	ThreadPool& pool = ThreadPool::getShared();
+	pool.parallelForEach(blocks, [&](ulongint b) {
+		double state = b == 0 ? at(0) : 0.0;
+		for (ulongint t=blockStart(b); t<blockEnd(b); t++) {
+			state = k * at(t) + nk * state;
+			at(t) = state;
+		}
+	});
+
+	// incoming[b]: the filter output just before block b.
+	vector<double> incoming(blocks, 0.0);
+	double previous = at(blockEnd(0) - 1);
+	for (ulongint b=1; b<blocks; b++) {
+		incoming[b] = previous;
+		ulongint n = blockEnd(b) - blockStart(b);
+		previous = at(blockEnd(b) - 1) + std::pow(nk, (double)n) * previous;
+	}
+
+	pool.parallelForEach(blocks - 1, [&](ulongint index) {
+		ulongint b = index + 1;
+		double carry = incoming[b];
+		double decay = nk;
+		for (ulongint t=blockStart(b); t<blockEnd(b); t++) {
+			double add = decay * carry;
+			if (fabs(add) < 1.0e-12) {
+				break;
+			}
+			at(t) += add;
+			decay *= nk;
+		}
+	});
+}
+
+
+
+//////////////////////////////
+//
+// exponentialSmoothingBlocks -- Block-parallel version of
+//    exponentialSmoothing() for long signals.  The result only differs
+//    from exponentialSmoothing() by rounding (and by dropping carried
+//    contributions smaller than 1e-12).  Signals that are shorter than
+//    two blocks, or when the shared ThreadPool has one thread, are
+//    filtered with exponentialSmoothing().
+//
+
+void exponentialSmoothingBlocks(vector<double>& signal, double gain,
+		ulongint blocksize) {
+	ulongint length = signal.size();
+	if (blocksize < 16) {
+		blocksize = 16;
+	}
+	if ((length <= 2 * blocksize) || (ThreadPool::getShared().getThreadCount() <= 1)) {
+		exponentialSmoothing(signal, gain);
+		return;
+	}
+	filterBlocks(signal.data(), length, gain, blocksize, false);
+	filterBlocks(signal.data(), length, gain, blocksize, true);
+}
+
+
+
+//////////////////////////////
+//
+// exponentialSmoothingFloat -- Single-precision version of
+//    exponentialSmoothing().
+//
+
+void exponentialSmoothingFloat(vector<double>& signal, double gain) {
+	ulongint length = signal.size();
+	if (length < 2) {
+		return;
+	}
+	vector<float> y(signal.begin(), signal.end());
+	float k  = (float)gain;
+	float nk = 1.0f - k;
+	for (ulongint i=1; i<length; i++) {
+		y[i] = k * y[i] + nk * y[i-1];
+	}
+	for (ulongint i=length-1; i>0; i--) {
+		y[i-1] = k * y[i-1] + nk * y[i];
+	}
+	std::copy(y.begin(), y.end(), signal.begin());
+}
+
+
+
+//////////////////////////////
+//
+// exponentialSmoothingFixed -- Fixed-point version of exponentialSmoothing(),
+//    with samples in 16.16 format and the gain in 0.31 format (the two
+//    filter coefficients add up to exactly 1.0).  Samples must be smaller
+//    than 32768 in magnitude, which is plenty for pixel positions.
+//
+
+void exponentialSmoothingFixed(vector<double>& signal, double gain) {
+	ulongint length = signal.size();
+	if (length < 2) {
+		return;
+	}
+	const longlongint one   = 1LL << 31;
+	const longlongint round = 1LL << 30;
+	longlongint k  = llround(gain * (double)one);
+	longlongint nk = one - k;
+	vector<longlongint> y(length);
+	for (ulongint i=0; i<length; i++) {
+		y[i] = llround(signal[i] * 65536.0);
+	}
+	for (ulongint i=1; i<length; i++) {
+		y[i] = (k * y[i] + nk * y[i-1] + round) >> 31;
+	}
+	for (ulongint i=length-1; i>0; i--) {
+		y[i-1] = (k * y[i-1] + nk * y[i] + round) >> 31;
+	}
+	for (ulongint i=0; i<length; i++) {
+		signal[i] = y[i] / 65536.0;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// smoothSignals -- Apply exponentialSmoothing() to each signal with the
+//    matching gain, using the given SmoothingMode.
+//
+
+void smoothSignals(vector<vector<double>*>& signals, const vector<double>& gains,
+		int mode) {
+	if (gains.size() != signals.size()) {
+		std::cerr << "Error: " << gains.size() << " gains for " << signals.size()
+		          << " signals" << std::endl;
+		return;
+	}
+	switch (mode) {
+		case SMOOTH_BLOCKS:
+			for (ulongint i=0; i<signals.size(); i++) {
+				exponentialSmoothingBlocks(*signals[i], gains[i]);
+			}
+			return;
+		case SMOOTH_FLOAT:
+			ThreadPool::getShared().parallelForEach(signals.size(), [&](ulongint i) {
+				exponentialSmoothingFloat(*signals[i], gains[i]);
+			});
+			return;
+		case SMOOTH_FIXED:
+			ThreadPool::getShared().parallelForEach(signals.size(), [&](ulongint i) {
+				exponentialSmoothingFixed(*signals[i], gains[i]);
+			});
+			return;
+	}
+	exponentialSmoothingLanes(signals, gains);
+}
+
+
+
+//////////////////////////////
+//
+// findSmoothingMode -- Convert a name ("exact", "blocks", "float" or
+//    "fixed") to a SmoothingMode, or -1 if the name is not known.
+//
+
+int findSmoothingMode(const string& name) {
+	for (int mode=SMOOTH_EXACT; mode<=SMOOTH_FIXED; mode++) {
+		if (name == getSmoothingModeName(mode)) {
+			return mode;
+		}
+	}
+	return -1;
+}
+
+
+
+//////////////////////////////
+//
+// getSmoothingModeName --
+//
+
+const char* getSmoothingModeName(int mode) {
+	switch (mode) {
+		case SMOOTH_EXACT:  return "exact";
+		case SMOOTH_BLOCKS: return "blocks";
+		case SMOOTH_FLOAT:  return "float";
+		case SMOOTH_FIXED:  return "fixed";
+	}
+	return "unknown";
+}
+
+
+} // end rip namespace
+
+
+
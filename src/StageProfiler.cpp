@@ -0,0 +1,544 @@
+//
+// Creation Date: Fri Oct 16 22:05:41 PDT 2026
+// Last Modified: Fri Oct 16 22:05:41 PDT 2026
+// Filename:      StageProfiler.cpp
+// Web Address:
+// Syntax:        C++
+// vim:           ts=3:nowrap:ft=text
+//
+// Description:   Timing and memory measurements of processing stages.
+//
+
+#include "StageProfiler.h"
+#include "ThreadPool.h"
+
+#include <ctime>
+#include <fstream>
+#include <sys/resource.h>
+
+using namespace std;
+
+namespace rip  {
+
+// Nesting level of the stages running on the current thread:
+static thread_local ulongint t_depth = 0;
+
+// Hardware counters of the current thread (opened by the first stage which
+// runs on the thread while the profiler records them):
+static thread_local PerfCounters t_perf;
+
+
+//////////////////////////////
+//
+// StageProfiler::StageProfiler -- Constructor.
+//
+
+StageProfiler::StageProfiler(void) {
+	m_origin = std::chrono::steady_clock::now();
+}
+
+
+
+//////////////////////////////
+//
+// StageProfiler::~StageProfiler -- Destructor.
+//
+
+StageProfiler::~StageProfiler() {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// StageProfiler::setEnabled -- Turn the measurements on or off.  When off,
+//    beginStage() and endStage() do nothing.
+//
+
+void StageProfiler::setEnabled(bool value) {
+	m_enabled = value;
+}
+
+
+
+//////////////////////////////
+//
+// StageProfiler::setHardwareCounters -- Also record the hardware
+//    performance counters of each stage.  If the counters are not available
+//    the stages are measured without them (see getHardwareCounterStatus()).
+//
+
+void StageProfiler::setHardwareCounters(bool value) {
+	m_hardware = value;
+}
+
+
+
+//////////////////////////////
+//
+// StageProfiler::getHardwareCounterStatus -- "off" if the counters were not
+//    requested, "on" if they were recorded, otherwise the reason that they
+//    are not available.  The counters are opened on this thread if no
+//    stage has run yet.
+//
+
+string StageProfiler::getHardwareCounterStatus(void) {
+	if (!m_hardware) {
+		return "off";
+	}
+	bool opened;
+	{
+		lock_guard<mutex> guard(m_lock);
+		opened = m_hardwareOpened;
+	}
+	if (!opened) {
+		readHardwareCounters();
+	}
+	lock_guard<mutex> guard(m_lock);
+	if (m_hardwareError.empty()) {
+		return "on";
+	}
+	return "unavailable: " + m_hardwareError;
+}
+
+
+
+//////////////////////////////
+//
+// StageProfiler::clear -- Remove the records and restart the clock.
+//
+
+void StageProfiler::clear(void) {
+	lock_guard<mutex> guard(m_lock);
+	m_records.clear();
+	m_counters.clear();
+	m_startCpu.clear();
+	m_startRss.clear();
+	m_startCounters.clear();
+	m_threads.clear();
+	m_origin = std::chrono::steady_clock::now();
+}
+
+
+
+//////////////////////////////
+//
+// StageProfiler::beginStage -- Start measuring a stage.  Returns the index
+//    of the record, which is given to endStage().
+//
+
+ulongint StageProfiler::beginStage(const string& name, ulonglongint bytes) {
+	StageRecord record;
+	record.name      = name;
+	record.depth     = t_depth++;
+	record.bytes     = bytes;
+	double cpu       = getCpuTime();
+	longlongint rss  = getPeakRss();
+	PerfValues counters = readHardwareCounters();
+	lock_guard<mutex> guard(m_lock);
+	record.thread    = getThreadIndex();
+	record.startTime = getElapsed();
+	m_records.push_back(record);
+	m_startCpu.push_back(cpu);
+	m_startRss.push_back(rss);
+	m_startCounters.push_back(counters);
+	return m_records.size() - 1;
+}
+
+
+
+//////////////////////////////
+//
+// StageProfiler::endStage -- Finish measuring a stage, adding bytes to its
+//    estimate of the data touched.
+//
+
+void StageProfiler::endStage(ulongint index, ulonglongint bytes) {
+	double cpu      = getCpuTime();
+	longlongint rss = getPeakRss();
+	PerfValues counters = readHardwareCounters();
+	if (t_depth > 0) {
+		t_depth--;
+	}
+	lock_guard<mutex> guard(m_lock);
+	if (index >= m_records.size()) {
+		return;
+	}
+	StageRecord& record = m_records[index];
+	record.wallTime     = getElapsed() - record.startTime;
+	record.cpuTime      = cpu - m_startCpu[index];
+	record.peakRssDelta = rss - m_startRss[index];
+	record.bytes       += bytes;
+	for (int i=0; i<PERF_COUNTER_COUNT; i++) {
+		longlongint start = m_startCounters[index].value[i];
+		if ((start >= 0) && (counters.value[i] >= start)) {
+			record.counters.value[i] = counters.value[i] - start;
+		}
+	}
+	record.finished     = true;
+}
+
+
+
+//////////////////////////////
+//
+// StageProfiler::getRecords -- Return a copy of the finished records.
+//
+
+vector<StageRecord> StageProfiler::getRecords(void) {
+	lock_guard<mutex> guard(m_lock);
+	vector<StageRecord> output;
+	for (ulongint i=0; i<m_records.size(); i++) {
+		if (m_records[i].finished) {
+			output.push_back(m_records[i]);
+		}
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// StageProfiler::addCounter -- Record the current value of a counter (such
+//    as the number of holes found so far).  Does nothing when the profiler
+//    is not enabled.
+//
+
+void StageProfiler::addCounter(const string& name, double value) {
+	if (!m_enabled) {
+		return;
+	}
+	lock_guard<mutex> guard(m_lock);
+	CounterRecord record;
+	record.name  = name;
+	record.time  = getElapsed();
+	record.value = value;
+	m_counters.push_back(record);
+}
+
+
+
+//////////////////////////////
+//
+// StageProfiler::printAton -- Print the finished stages as an ATON
+//    PROFILE section.
+//
+
+std::ostream& StageProfiler::printAton(std::ostream& out) {
+	vector<StageRecord> records = getRecords();
+	ThreadPoolStatistics stats = ThreadPool::getShared().getStatistics();
+	string hardware = getHardwareCounterStatus();
+
+	out << "\n@@BEGIN: PROFILE\n";
+	out << "\n";
+	out << "@@ Measurements of the processing stages.  Times are in seconds;\n";
+	out << "@@ CPU_TIME is for the whole process while the stage ran (so stages\n";
+	out << "@@ which ran at the same time share it), PEAK_RSS_DELTA is the increase\n";
+	out << "@@ of the peak resident memory during the stage, and BYTES is an\n";
+	out << "@@ estimate of the size of the data read or written by the stage.\n";
+	out << "@@ Hardware counters (CYCLES to DTLB_MISSES) are user-space events of\n";
+	out << "@@ the thread which ran the stage, and do not include work that the\n";
+	out << "@@ stage handed to other threads.\n";
+	out << "@@\n";
+	out << "\n";
+	out << "@THREADS:\t\t"      << stats.threads     << endl;
+	out << "@POOL_TASKS:\t\t"   << stats.tasks       << endl;
+	out << "@POOL_STEALS:\t\t"  << stats.steals      << endl;
+	out << "@POOL_INLINE:\t\t"  << stats.inlineTasks << endl;
+	out << "@POOL_LOOPS:\t\t"   << stats.loops       << endl;
+	out << "@HW_COUNTERS:\t\t"  << hardware            << endl;
+	out << "\n";
+	for (ulongint i=0; i<records.size(); i++) {
+		StageRecord& record = records[i];
+		out << "@@BEGIN: STAGE\n";
+		out << "@NAME:\t\t\t"          << record.name         << endl;
+		out << "@DEPTH:\t\t\t"         << record.depth        << endl;
+		out << "@THREAD:\t\t"          << record.thread       << endl;
+		out << "@START_TIME:\t\t"      << record.startTime    << "s" << endl;
+		out << "@WALL_TIME:\t\t"       << record.wallTime     << "s" << endl;
+		out << "@CPU_TIME:\t\t"        << record.cpuTime      << "s" << endl;
+		out << "@PEAK_RSS_DELTA:\t"    << record.peakRssDelta << "B" << endl;
+		out << "@BYTES:\t\t\t"         << record.bytes        << "B" << endl;
+		for (int j=0; j<PERF_COUNTER_COUNT; j++) {
+			if (record.counters.value[j] >= 0) {
+				out << "@" << PerfCounters::getCounterLabel(j) << ":\t\t"
+				    << record.counters.value[j] << endl;
+			}
+		}
+		out << "@@END: STAGE\n";
+		out << "\n";
+	}
+	out << "@@END: PROFILE\n";
+	return out;
+}
+
+
+
+//////////////////////////////
+//
+// StageProfiler::printJson -- Print the finished stages as JSON, for
+//    comparing the stages of different runs or library versions.
+//
+
+std::ostream& StageProfiler::printJson(std::ostream& out) {
+	vector<StageRecord> records = getRecords();
+	ThreadPoolStatistics stats = ThreadPool::getShared().getStatistics();
+	string hardware = getHardwareCounterStatus();
+
+	out << "{\n";
+	out << "\t\"software_date\": \"" << __DATE__ << " " << __TIME__ << "\",\n";
+	out << "\t\"threads\": "        << stats.threads     << ",\n";
+	out << "\t\"pool\": {";
+	out << "\"tasks\": "            << stats.tasks       << ", ";
+	out << "\"steals\": "           << stats.steals      << ", ";
+	out << "\"inline_tasks\": "     << stats.inlineTasks << ", ";
+	out << "\"loops\": "            << stats.loops       << "},\n";
+	out << "\t\"hardware_counters\": \"" << hardware       << "\",\n";
+	out << "\t\"stages\": [";
+	for (ulongint i=0; i<records.size(); i++) {
+		StageRecord& record = records[i];
+		out << (i ? ",\n" : "\n");
+		out << "\t\t{\"name\": \""          << record.name         << "\"";
+		out << ", \"depth\": "              << record.depth;
+		out << ", \"thread\": "             << record.thread;
+		out << ", \"start\": "              << record.startTime;
+		out << ", \"wall\": "               << record.wallTime;
+		out << ", \"cpu\": "                << record.cpuTime;
+		out << ", \"peak_rss_delta\": "     << record.peakRssDelta;
+		out << ", \"bytes\": "              << record.bytes;
+		for (int j=0; j<PERF_COUNTER_COUNT; j++) {
+			if (record.counters.value[j] >= 0) {
+				out << ", \"" << PerfCounters::getCounterName(j) << "\": "
+				    << record.counters.value[j];
+			}
+		}
+		out << "}";
+	}
+	out << "\n\t]\n";
+	out << "}\n";
+	return out;
+}
+
+
+
+//////////////////////////////
+//
+// StageProfiler::writeJson -- Write printJson() to a file.  Returns false
+//    if the file cannot be written.
+//
+
+bool StageProfiler::writeJson(const string& filename) {
+	ofstream output(filename);
+	if (!output.is_open()) {
+		cerr << "Profile file " << filename << " cannot be written" << endl;
+		return false;
+	}
+	printJson(output);
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// StageProfiler::printChromeTrace -- Print the stages and counters in the
+//    trace-event JSON format which can be opened in chrome://tracing or
+//    ui.perfetto.dev.  Stages are complete ("X") events on the thread which
+//    ran them, with their CPU time, memory and bytes as arguments.
+//
+
+std::ostream& StageProfiler::printChromeTrace(std::ostream& out) {
+	vector<StageRecord> records = getRecords();
+	vector<CounterRecord> counters;
+	ulongint threadCount;
+	{
+		lock_guard<mutex> guard(m_lock);
+		counters = m_counters;
+		threadCount = m_threads.size();
+	}
+
+	out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+	out << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, "
+	    << "\"args\": {\"name\": \"rip analysis\"}}";
+	for (ulongint i=0; i<threadCount; i++) {
+		out << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << i
+		    << ", \"args\": {\"name\": \"" << (i ? "worker " : "main ") << i << "\"}}";
+	}
+	for (ulongint i=0; i<records.size(); i++) {
+		StageRecord& record = records[i];
+		out << ",\n{\"name\": \"" << record.name << "\", \"cat\": \"stage\", \"ph\": \"X\"";
+		out << ", \"ts\": "  << (ulonglongint)(record.startTime * 1.0e6);
+		out << ", \"dur\": " << (ulonglongint)(record.wallTime * 1.0e6);
+		out << ", \"pid\": 1, \"tid\": " << record.thread;
+		out << ", \"args\": {\"cpu_ms\": " << record.cpuTime * 1000.0;
+		out << ", \"peak_rss_delta\": " << record.peakRssDelta;
+		out << ", \"bytes\": " << record.bytes;
+		for (int j=0; j<PERF_COUNTER_COUNT; j++) {
+			if (record.counters.value[j] >= 0) {
+				out << ", \"" << PerfCounters::getCounterName(j) << "\": "
+				    << record.counters.value[j];
+			}
+		}
+		out << "}}";
+	}
+	for (ulongint i=0; i<counters.size(); i++) {
+		CounterRecord& counter = counters[i];
+		out << ",\n{\"name\": \"" << counter.name << "\", \"ph\": \"C\"";
+		out << ", \"ts\": " << (ulonglongint)(counter.time * 1.0e6);
+		std::streamsize precision = out.precision(15);
+		out << ", \"pid\": 1, \"args\": {\"value\": " << counter.value << "}}";
+		out.precision(precision);
+	}
+	out << "\n]}\n";
+	return out;
+}
+
+
+
+//////////////////////////////
+//
+// StageProfiler::writeChromeTrace -- Write printChromeTrace() to a file.
+//    Returns false if the file cannot be written.
+//
+
+bool StageProfiler::writeChromeTrace(const string& filename) {
+	ofstream output(filename);
+	if (!output.is_open()) {
+		cerr << "Trace file " << filename << " cannot be written" << endl;
+		return false;
+	}
+	printChromeTrace(output);
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// StageProfiler::getCpuTime -- Processor time used by the process, in
+//    seconds.
+//
+
+double StageProfiler::getCpuTime(void) {
+	struct timespec now;
+	if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now) != 0) {
+		return 0.0;
+	}
+	return now.tv_sec + now.tv_nsec / 1.0e9;
+}
+
+
+
+//////////////////////////////
+//
+// StageProfiler::getPeakRss -- Largest resident memory of the process so
+//    far, in bytes.
+//
+
+longlongint StageProfiler::getPeakRss(void) {
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return 0;
+	}
+	return (longlongint)usage.ru_maxrss * 1024;
+}
+
+
+
+//////////////////////////////
+//
+// StageProfiler::readHardwareCounters -- Read the counters of the current
+//    thread, opening them if this is the first stage on the thread.  All
+//    values are -1 if the counters are off or not available.
+//
+
+PerfValues StageProfiler::readHardwareCounters(void) {
+	if (!m_hardware) {
+		return PerfValues();
+	}
+	if (!t_perf.open()) {
+		lock_guard<mutex> guard(m_lock);
+		if (m_hardwareError.empty()) {
+			m_hardwareError = t_perf.getError();
+		}
+		m_hardwareOpened = true;
+		return PerfValues();
+	}
+	{
+		lock_guard<mutex> guard(m_lock);
+		m_hardwareOpened = true;
+	}
+	return t_perf.read();
+}
+
+
+
+//////////////////////////////
+//
+// StageProfiler::getThreadIndex -- Number the threads in the order that
+//    they run their first stage (m_lock must be held).
+//
+
+ulongint StageProfiler::getThreadIndex(void) {
+	auto it = m_threads.find(std::this_thread::get_id());
+	if (it != m_threads.end()) {
+		return it->second;
+	}
+	ulongint index = m_threads.size();
+	m_threads[std::this_thread::get_id()] = index;
+	return index;
+}
+
+
+
+//////////////////////////////
+//
+// StageProfiler::getElapsed -- Seconds since the profiler was created or
+//    cleared.
+//
+
+double StageProfiler::getElapsed(void) const {
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_origin;
+	return elapsed.count();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// ScopedStage --
+//
+
+//////////////////////////////
+//
+// ScopedStage::ScopedStage -- Constructor.
+//
+
+ScopedStage::ScopedStage(StageProfiler& profiler, const string& name,
+		ulonglongint bytes) : m_profiler(profiler), m_index(0) {
+	m_active = profiler.isEnabled();
+	if (m_active) {
+		m_index = profiler.beginStage(name, bytes);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// ScopedStage::~ScopedStage -- Destructor.
+//
+
+ScopedStage::~ScopedStage() {
+	if (m_active) {
+		m_profiler.endStage(m_index, m_bytes);
+	}
+}
+
+
+} // end rip namespace
+
+
+
@@ -0,0 +1,230 @@
+//
+// Creation Date: Fri Oct 16 18:02:36 PDT 2026
+// Last Modified: Fri Oct 16 18:02:36 PDT 2026
+// Filename:      TaskGraph.cpp
+// Web Address:
+// Syntax:        C++
+// vim:           ts=3:nowrap:ft=text
+//
+// Description:   Dependency graph of processing steps.
+//
+
+#include "TaskGraph.h"
+#include "ThreadPool.h"
+
+#include <mutex>
+
+using namespace std;
+
+namespace rip  {
+
+
+//////////////////////////////
+//
+// TaskGraph::TaskGraph -- Constructor.
+//
+
+TaskGraph::TaskGraph(void) {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// TaskGraph::~TaskGraph -- Destructor.
+//
+
+TaskGraph::~TaskGraph() {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// TaskGraph::clear -- Remove all tasks.
+//
+
+void TaskGraph::clear(void) {
+	m_tasks.clear();
+}
+
+
+
+//////////////////////////////
+//
+// TaskGraph::addTask -- Add a task which reads and writes the data given
+//    as bitmasks (the meaning of each bit is up to the caller).  The task
+//    will run after all earlier tasks which write any data that it reads
+//    or writes, and after all earlier tasks which read any data that it
+//    writes.  Returns the index of the task.
+//
+
+ulongint TaskGraph::addTask(const string& name, function<void(void)> function,
+		ulongint reads, ulongint writes) {
+	ulongint index = m_tasks.size();
+	m_tasks.resize(index + 1);
+	Task& task    = m_tasks.back();
+	task.name     = name;
+	task.function = function;
+	task.reads    = reads;
+	task.writes   = writes;
+
+	for (ulongint i=0; i<index; i++) {
+		Task& earlier = m_tasks[i];
+		if ((earlier.writes & (reads | writes)) || (writes & earlier.reads)) {
+			task.dependencies.push_back(i);
+			earlier.dependents.push_back(index);
+		}
+	}
+	return index;
+}
+
+
+
+//////////////////////////////
+//
+// TaskGraph::addBarrier -- Add a task which runs after all earlier tasks
+//    and before all later tasks.
+//
+
+ulongint TaskGraph::addBarrier(const string& name, function<void(void)> function) {
+	return addTask(name, function, TASK_ALL, TASK_ALL);
+}
+
+
+
+//////////////////////////////
+//
+// TaskGraph::getTaskName --
+//
+
+const string& TaskGraph::getTaskName(ulongint index) const {
+	return m_tasks.at(index).name;
+}
+
+
+
+//////////////////////////////
+//
+// TaskGraph::getDependencies -- Return the indexes of the earlier tasks
+//    which must finish before the given task can start.
+//
+
+const vector<ulongint>& TaskGraph::getDependencies(ulongint index) const {
+	return m_tasks.at(index).dependencies;
+}
+
+
+
+//////////////////////////////
+//
+// TaskGraph::setThreadCount -- Set the number of threads used to run the
+//    tasks.  1 runs the tasks in order on the calling thread, and any
+//    other count runs them on the shared ThreadPool (0 means the thread
+//    count of the pool).
+//
+
+void TaskGraph::setThreadCount(int count) {
+	m_threadCount = count < 0 ? 0 : count;
+}
+
+
+
+//////////////////////////////
+//
+// TaskGraph::getThreadCount -- Returns the number of threads which will
+//    be used to run the tasks.
+//
+
+int TaskGraph::getThreadCount(void) const {
+	int poolcount = ThreadPool::getShared().getThreadCount();
+	if ((m_threadCount > 0) && (m_threadCount < poolcount)) {
+		return m_threadCount;
+	}
+	return poolcount;
+}
+
+
+
+//////////////////////////////
+//
+// TaskGraph::run -- Run all of the tasks, returning after the last one
+//    has finished.
+//
+
+void TaskGraph::run(void) {
+	if ((getThreadCount() <= 1) || (m_tasks.size() <= 1)) {
+		runSerial();
+	} else {
+		runParallel(ThreadPool::getShared());
+	}
+}
+
+
+
+//////////////////////////////
+//
+// TaskGraph::runSerial -- Run the tasks in the order that they were added.
+//
+
+void TaskGraph::runSerial(void) {
+	for (ulongint i=0; i<m_tasks.size(); i++) {
+		m_tasks[i].function();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// TaskGraph::runParallel -- Run the tasks on a thread pool.  Each task is
+//    given to the pool when the last of its dependencies has finished.
+//
+
+void TaskGraph::runParallel(ThreadPool& pool) {
+	ulongint count = m_tasks.size();
+	vector<ulongint> waiting(count);
+	vector<ulongint> roots;
+	for (ulongint i=0; i<count; i++) {
+		waiting[i] = m_tasks[i].dependencies.size();
+		if (waiting[i] == 0) {
+			roots.push_back(i);
+		}
+	}
+
+	mutex lock;
+	TaskGroup group(pool);
+	function<void(ulongint)> start = [&](ulongint index) {
+		group.run([&, index]() {
+			m_tasks[index].function();
+			vector<ulongint> ready;
+			{
+				lock_guard<mutex> guard(lock);
+				const vector<ulongint>& dependents = m_tasks[index].dependents;
+				for (ulongint i=0; i<dependents.size(); i++) {
+					if (--waiting[dependents[i]] == 0) {
+						ready.push_back(dependents[i]);
+					}
+				}
+			}
+			for (ulongint i=0; i<ready.size(); i++) {
+				start(ready[i]);
+			}
+		});
+	};
+
+	// (the roots are found before starting any of them, since waiting
+	// changes as soon as tasks finish)
+	for (ulongint i=0; i<roots.size(); i++) {
+		start(roots[i]);
+	}
+	group.wait();
+}
+
+
+} // end rip namespace
+
+
+
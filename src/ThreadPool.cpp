@@ -0,0 +1,436 @@
+//
+// Creation Date: Fri Oct 16 19:14:52 PDT 2026
+// Last Modified: Fri Oct 16 19:14:52 PDT 2026
+// Filename:      ThreadPool.cpp
+// Web Address:
+// Syntax:        C++
+// vim:           ts=3:nowrap:ft=text
+//
+// Description:   Work-stealing thread pool shared by the library.
+//
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+
+using namespace std;
+
+namespace rip  {
+
+// The pool and queue which the current thread works for (NULL and 0 for
+// threads which are not pool workers):
+static thread_local ThreadPool* t_pool  = NULL;
+static thread_local ulongint    t_queue = 0;
+
+
+//////////////////////////////
+//
+// ThreadPool::ThreadPool -- Constructor.  The count is the total number
+//    of threads which work on tasks, including the thread which waits for
+//    them, so a count of 1 runs all tasks inline.  0 means the default
+//    count (see getDefaultThreadCount()).
+//
+
+ThreadPool::ThreadPool(int count) : m_queued(0), m_tasks(0), m_steals(0),
+		m_inlineTasks(0), m_loops(0) {
+	setThreadCount(count);
+}
+
+
+
+//////////////////////////////
+//
+// ThreadPool::~ThreadPool -- Destructor.
+//
+
+ThreadPool::~ThreadPool() {
+	stopWorkers();
+}
+
+
+
+//////////////////////////////
+//
+// ThreadPool::getShared -- Return the pool which is used by the library.
+//
+
+ThreadPool& ThreadPool::getShared(void) {
+	static ThreadPool pool;
+	return pool;
+}
+
+
+
+//////////////////////////////
+//
+// ThreadPool::getDefaultThreadCount -- Returns the value of the RIP_THREADS
+//    environment variable if it is set to a positive number, otherwise
+//    the number of processor cores.
+//
+
+int ThreadPool::getDefaultThreadCount(void) {
+	const char* value = getenv("RIP_THREADS");
+	if (value) {
+		int count = atoi(value);
+		if (count > 0) {
+			return count;
+		}
+	}
+	int count = (int)std::thread::hardware_concurrency();
+	return count > 0 ? count : 1;
+}
+
+
+
+//////////////////////////////
+//
+// ThreadPool::setThreadCount -- Restart the pool with a new number of
+//    threads (see the constructor).  Must not be called while tasks are
+//    running on the pool.
+//
+
+void ThreadPool::setThreadCount(int count) {
+	if (count <= 0) {
+		count = getDefaultThreadCount();
+	}
+	if ((ulongint)count == m_workers.size() + 1) {
+		return;
+	}
+	stopWorkers();
+	startWorkers(count - 1);
+}
+
+
+
+//////////////////////////////
+//
+// ThreadPool::getThreadCount -- Returns the number of threads which work
+//    on tasks (including the waiting thread).
+//
+
+int ThreadPool::getThreadCount(void) const {
+	return (int)m_workers.size() + 1;
+}
+
+
+
+//////////////////////////////
+//
+// ThreadPool::parallelFor -- Call the function for ranges [start, end) of
+//    at most grain indexes which together cover [start, end), and wait for
+//    all of them to finish.  Without worker threads the ranges are done in
+//    order on the calling thread.
+//
+
+void ThreadPool::parallelFor(ulongint start, ulongint end, ulongint grain,
+		const function<void(ulongint, ulongint)>& function) {
+	if (end <= start) {
+		return;
+	}
+	m_loops++;
+	if (grain == 0) {
+		grain = 1;
+	}
+	if (!hasWorkers() || (end - start <= grain)) {
+		for (ulongint i=start; i<end; i+=grain) {
+			function(i, std::min(i + grain, end));
+		}
+		return;
+	}
+	TaskGroup group(*this);
+	for (ulongint i=start; i<end; i+=grain) {
+		ulongint last = std::min(i + grain, end);
+		group.run([&function, i, last]() { function(i, last); });
+	}
+	group.wait();
+}
+
+
+
+//////////////////////////////
+//
+// ThreadPool::parallelForEach -- Call the function once for each index
+//    from 0 to count-1 (such as the items of a list), grain indexes per
+//    task.
+//
+
+void ThreadPool::parallelForEach(ulongint count,
+		const function<void(ulongint)>& function, ulongint grain) {
+	parallelFor(0, count, grain, [&function](ulongint start, ulongint end) {
+		for (ulongint i=start; i<end; i++) {
+			function(i);
+		}
+	});
+}
+
+
+
+//////////////////////////////
+//
+// ThreadPool::getStatistics -- Return counts of the work done since the
+//    pool was created or since resetStatistics().
+//
+
+ThreadPoolStatistics ThreadPool::getStatistics(void) const {
+	ThreadPoolStatistics stats;
+	stats.threads     = getThreadCount();
+	stats.tasks       = m_tasks;
+	stats.steals      = m_steals;
+	stats.inlineTasks = m_inlineTasks;
+	stats.loops       = m_loops;
+	return stats;
+}
+
+
+
+//////////////////////////////
+//
+// ThreadPool::resetStatistics --
+//
+
+void ThreadPool::resetStatistics(void) {
+	m_tasks       = 0;
+	m_steals      = 0;
+	m_inlineTasks = 0;
+	m_loops       = 0;
+}
+
+
+
+//////////////////////////////
+//
+// ThreadPool::submit -- Add a task to the back of the queue of the current
+//    thread, and wake up a sleeping worker to take it.
+//
+
+void ThreadPool::submit(Task&& task) {
+	Queue& queue = *m_queues[t_pool == this ? t_queue : 0];
+	{
+		lock_guard<mutex> guard(queue.lock);
+		queue.tasks.push_back(std::move(task));
+	}
+	m_queued++;
+	{
+		lock_guard<mutex> guard(m_sleepLock);
+	}
+	m_wakeup.notify_one();
+}
+
+
+
+//////////////////////////////
+//
+// ThreadPool::runOneTask -- Run a queued task if there is one (only tasks
+//    of the given group if it is not NULL).  Returns false if no task was
+//    found.
+//
+
+bool ThreadPool::runOneTask(const TaskGroup* group) {
+	Task task;
+	if (!popTask(task, group)) {
+		return false;
+	}
+	runTask(task);
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// ThreadPool::popTask -- Take the newest task from the queue of the current
+//    thread, or else the oldest task from another queue.  If group is not
+//    NULL, only tasks of that group are taken.
+//
+
+bool ThreadPool::popTask(Task& task, const TaskGroup* group) {
+	if (m_queued == 0) {
+		return false;
+	}
+	auto inGroup = [group](const Task& item) {
+		return (group == NULL) || (item.group == group);
+	};
+	ulongint count = m_queues.size();
+	ulongint own = t_pool == this ? t_queue : 0;
+	{
+		Queue& queue = *m_queues[own];
+		lock_guard<mutex> guard(queue.lock);
+		auto it = std::find_if(queue.tasks.rbegin(), queue.tasks.rend(), inGroup);
+		if (it != queue.tasks.rend()) {
+			task = std::move(*it);
+			queue.tasks.erase(std::next(it).base());
+			m_queued--;
+			return true;
+		}
+	}
+	for (ulongint i=1; i<count; i++) {
+		Queue& queue = *m_queues[(own + i) % count];
+		lock_guard<mutex> guard(queue.lock);
+		auto it = std::find_if(queue.tasks.begin(), queue.tasks.end(), inGroup);
+		if (it != queue.tasks.end()) {
+			task = std::move(*it);
+			queue.tasks.erase(it);
+			m_queued--;
+			m_steals++;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+//////////////////////////////
+//
+// ThreadPool::runTask -- Run a task and tell its group that it is done.
+//
+
+void ThreadPool::runTask(Task& task) {
+	task.function();
+	m_tasks++;
+	task.group->finishTask();
+}
+
+
+
+//////////////////////////////
+//
+// ThreadPool::workerLoop -- Run tasks until the pool is stopped.
+//
+
+void ThreadPool::workerLoop(ulongint index) {
+	t_pool  = this;
+	t_queue = index;
+	while (true) {
+		if (runOneTask()) {
+			continue;
+		}
+		unique_lock<mutex> guard(m_sleepLock);
+		m_wakeup.wait(guard, [this]() { return m_stop || (m_queued > 0); });
+		if (m_stop && (m_queued == 0)) {
+			return;
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// ThreadPool::startWorkers --
+//
+
+void ThreadPool::startWorkers(ulongint count) {
+	m_stop = false;
+	m_queues.clear();
+	for (ulongint i=0; i<=count; i++) {
+		m_queues.emplace_back(new Queue);
+	}
+	for (ulongint i=1; i<=count; i++) {
+		m_workers.emplace_back(&ThreadPool::workerLoop, this, i);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// ThreadPool::stopWorkers -- Let the workers finish the queued tasks and
+//    then end the threads.
+//
+
+void ThreadPool::stopWorkers(void) {
+	{
+		lock_guard<mutex> guard(m_sleepLock);
+		m_stop = true;
+	}
+	m_wakeup.notify_all();
+	for (ulongint i=0; i<m_workers.size(); i++) {
+		m_workers[i].join();
+	}
+	m_workers.clear();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TaskGroup --
+//
+
+//////////////////////////////
+//
+// TaskGroup::TaskGroup -- Constructor.
+//
+
+TaskGroup::TaskGroup(ThreadPool& pool) : m_pool(pool), m_pending(0) {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// TaskGroup::~TaskGroup -- Destructor.  Waits for any tasks which are
+//    still running.
+//
+
+TaskGroup::~TaskGroup() {
+	wait();
+}
+
+
+
+//////////////////////////////
+//
+// TaskGroup::run -- Start a task on the pool (or run it now if the pool
+//    has no worker threads).
+//
+
+void TaskGroup::run(function<void(void)> function) {
+	if (!m_pool.hasWorkers()) {
+		m_pool.m_inlineTasks++;
+		function();
+		return;
+	}
+	m_pending++;
+	ThreadPool::Task task;
+	task.function = std::move(function);
+	task.group    = this;
+	m_pool.submit(std::move(task));
+}
+
+
+
+//////////////////////////////
+//
+// TaskGroup::wait -- Return when all tasks of the group have finished,
+//    running queued tasks of the group in the meantime.
+//
+
+void TaskGroup::wait(void) {
+	while (m_pending > 0) {
+		if (!m_pool.runOneTask(this)) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// TaskGroup::finishTask --
+//
+
+void TaskGroup::finishTask(void) {
+	m_pending--;
+}
+
+
+} // end rip namespace
+
+
+
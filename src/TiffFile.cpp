@@ -18,6 +18,15 @@
 
 #include "TiffFile.h"
 
+#include <cstring>
+
+#ifndef _WIN32
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
 
 using namespace std;
 
@@ -53,6 +62,8 @@ TiffFile::~TiffFile(void) {
 //
 
 void TiffFile::close(void) {
+	unmapPixelData();
+	m_mapfailed = false;
 	fstream::close();
 	TiffHeader::clear();
 }
@@ -165,24 +176,197 @@ bool TiffFile::goToRowColumnIndex(ulongint rowindex, ulongint colindex) {
 
 //////////////////////////////
 //
-// TiffFile::getImageGreenChannel --
+// TiffFile::getImageGreenChannel -- Extract the green channel of the
+//    image (vector-of-rows version, kept for compatibility).
 //
 
 void TiffFile::getImageGreenChannel(vector<vector<ucharint> >& image) {
-	this->goToPixelIndex((int)0);
 	ulongint rows = this->getRows();
 	ulongint cols = this->getCols();
-	vector<ucharint> pixel(3);
 	image.resize(rows);
 	for (ulongint r=0; r<rows; r++) {
-		image.at(r).resize(cols);
-		for (ulongint c=0; c<cols; c++) {
-			pixel[0] = this->read1UByte();  // red
-			pixel[1] = this->read1UByte();  // green
-			pixel[2] = this->read1UByte();  // blue
-			image.at(r).at(c) = pixel[1];
-		}
+		image[r].resize(cols);
+		extractGreenChannel(image[r].data(), this->getRowPixels(r), cols);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// TiffFile::getImageGreenChannel -- Extract the green channel of the
+//    image into a plane with 64-byte aligned rows.
+//
+
+void TiffFile::getImageGreenChannel(ImagePlane<ucharint>& image) {
+	ulongint rows = this->getRows();
+	ulongint cols = this->getCols();
+	image.resize(rows, cols, true);
+	for (ulongint r=0; r<rows; r++) {
+		extractGreenChannel(image.getRow(r), this->getRowPixels(r), cols);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// TiffFile::mapPixelData -- Memory-map the image file so that rows of
+//    pixels can be accessed directly from the page cache (see
+//    getRowPixels()).  Returns false if the file cannot be mapped, such
+//    as when the pixel data is truncated, in which case getRowPixels()
+//    will read each row from the file stream instead.  Works for both
+//    32-bit and 64-bit (BigTIFF) files, since the data offset is already
+//    resolved by the header parser.
+//
+
+bool TiffFile::mapPixelData(void) {
+	if (m_mapbase) {
+		return true;
+	}
+	if (m_mapfailed || !m_allowMapping) {
+		return false;
+	}
+	m_mapfailed = true;
+
+#ifdef _WIN32
+	return false;
+#else
+	if (m_filename.empty()) {
+		return false;
+	}
+	int fd = ::open(m_filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		::close(fd);
+		return false;
+	}
+	ulonglongint filesize = (ulonglongint)info.st_size;
+	ulonglongint dataend = this->getPixelOffset((ulonglongint)this->getRows() *
+			(ulonglongint)this->getCols());
+	if ((filesize == 0) || (dataend > filesize)) {
+		// Do not map truncated images: accessing pages past the end of the
+		// file would cause a bus error.
+		::close(fd);
+		return false;
+	}
+	void* base = mmap(NULL, (size_t)filesize, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (base == MAP_FAILED) {
+		return false;
+	}
+	#ifdef MADV_SEQUENTIAL
+		madvise(base, (size_t)filesize, MADV_SEQUENTIAL);
+	#endif
+	m_mapbase   = (ucharint*)base;
+	m_maplength = filesize;
+	m_mapfailed = false;
+	return true;
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// TiffFile::allowPixelMapping -- Set to false to read each row from the
+//    file stream in getRowPixels() instead of memory-mapping the file.
+//
+
+void TiffFile::allowPixelMapping(bool state) {
+	m_allowMapping = state;
+	if (!state) {
+		unmapPixelData();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// TiffFile::unmapPixelData -- Release the memory map of the file, if any.
+//
+
+void TiffFile::unmapPixelData(void) {
+#ifndef _WIN32
+	if (m_mapbase) {
+		munmap(m_mapbase, (size_t)m_maplength);
+	}
+#endif
+	m_mapbase   = NULL;
+	m_maplength = 0;
+}
+
+
+
+//////////////////////////////
+//
+// TiffFile::isPixelDataMapped --
+//
+
+bool TiffFile::isPixelDataMapped(void) const {
+	return m_mapbase != NULL;
+}
+
+
+
+//////////////////////////////
+//
+// TiffFile::getRowPixels -- Return a pointer to the 24-bit RGB pixels
+//    of the given row.  The file is memory-mapped on the first call, and
+//    the returned pointer is valid until the file is closed.  If the file
+//    cannot be mapped, the row is read into an internal buffer, and the
+//    pointer is only valid until the next call to this function.
+//
+
+const ucharint* TiffFile::getRowPixels(ulongint rowindex) {
+	ulonglongint offset = this->getPixelOffset(rowindex, 0);
+	if (mapPixelData()) {
+		return m_mapbase + offset;
+	}
+
+	ulongint bytes = this->getCols() * 3;
+	m_rowbuffer.resize(bytes);
+	fstream::clear();
+	this->goToByteIndex(offset);
+	this->read((char*)m_rowbuffer.data(), bytes);
+	ulongint count = (ulongint)this->gcount();
+	if (count < bytes) {
+		std::cerr << "Error: unexpected end of file." << std::endl;
+		std::fill(m_rowbuffer.begin() + count, m_rowbuffer.end(), 0);
+	}
+	return m_rowbuffer.data();
+}
+
+
+
+//////////////////////////////
+//
+// TiffFile::releaseRowPixels -- Tell the operating system that the
+//    given rows of a memory-mapped file are no longer needed, so that
+//    they stop counting against the memory use of the program when the
+//    image is read in a single pass.  The rows can still be accessed
+//    later (they will be paged in again from the file).
+//
+
+void TiffFile::releaseRowPixels(ulongint startrow, ulongint count) {
+#if !defined(_WIN32) && defined(MADV_DONTNEED)
+	if (!m_mapbase || (count == 0)) {
+		return;
+	}
+	ulonglongint pagesize = (ulonglongint)sysconf(_SC_PAGESIZE);
+	ulonglongint start = this->getPixelOffset(startrow, 0);
+	ulonglongint end   = this->getPixelOffset(startrow + count, 0);
+	// only whole pages which are entirely inside of the rows:
+	start = (start + pagesize - 1) / pagesize * pagesize;
+	end   = end / pagesize * pagesize;
+	if (end > start) {
+		madvise(m_mapbase + start, (size_t)(end - start), MADV_DONTNEED);
 	}
+#endif
 }
 
 
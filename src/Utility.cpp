@@ -13,6 +13,11 @@
 
 #include "Utilities.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define RIP_X86_SIMD
+	#include <immintrin.h>
+#endif
+
 namespace rip {
 
 
@@ -274,6 +279,67 @@ void exponentialSmoothing(std::vector<double>& array, double gain) {
 
 
 
+//////////////////////////////
+//
+// getSpectralMagnitude -- Magnitude of the Fourier transform of a real
+//    signal at any frequency (in cycles per sample, not restricted to
+//    the bins of an FFT), calculated with the Goertzel recurrence.
+//
+
+double getSpectralMagnitude(const std::vector<double>& signal, double frequency) {
+	double pi = 4.0 * atan(1.0);
+	double coeff = 2.0 * cos(2.0 * pi * frequency);
+	double s1 = 0.0;
+	double s2 = 0.0;
+	for (ulongint i=0; i<signal.size(); i++) {
+		double s0 = signal[i] + coeff * s1 - s2;
+		s2 = s1;
+		s1 = s0;
+	}
+	double power = s1 * s1 + s2 * s2 - coeff * s1 * s2;
+	return power > 0.0 ? sqrt(power) : 0.0;
+}
+
+
+
+//////////////////////////////
+//
+// findSpectralPeak -- Return the frequency (cycles per sample) of the
+//    largest spectral magnitude between lowfreq and highfreq, searched by
+//    golden-section until the interval is smaller than tolerance.  The
+//    magnitude must have a single peak in the interval (such as within one
+//    bin of the largest bin of an FFT).
+//
+
+double findSpectralPeak(const std::vector<double>& signal, double lowfreq,
+		double highfreq, double tolerance) {
+	double ratio = (sqrt(5.0) - 1.0) / 2.0;
+	double a = lowfreq;
+	double b = highfreq;
+	double c = b - ratio * (b - a);
+	double d = a + ratio * (b - a);
+	double fc = getSpectralMagnitude(signal, c);
+	double fd = getSpectralMagnitude(signal, d);
+	while (b - a > tolerance) {
+		if (fc > fd) {
+			b  = d;
+			d  = c;
+			fd = fc;
+			c  = b - ratio * (b - a);
+			fc = getSpectralMagnitude(signal, c);
+		} else {
+			a  = c;
+			c  = d;
+			fc = fd;
+			d  = a + ratio * (b - a);
+			fd = getSpectralMagnitude(signal, d);
+		}
+	}
+	return (a + b) / 2.0;
+}
+
+
+
 //////////////////////////////
 //
 // goToByteIndex -- Generalized to work with files larger than 4GB, especially
@@ -299,6 +365,530 @@ bool goToByteIndex(std::fstream& file, ulonglongint offset) {
 
 
 
+//////////////////////////////
+//
+// extractRgbChannelScalar -- Portable version of extractRgbChannel(),
+//    also used for the leftover pixels of the vectorized versions.
+//
+
+static void extractRgbChannelScalar(ucharint* output, const ucharint* rgb,
+		ulongint count, int channel) {
+	const ucharint* input = rgb + channel;
+	for (ulongint i=0; i<count; i++) {
+		output[i] = input[i * 3];
+	}
+}
+
+
+
+//////////////////////////////
+//
+// markAboveThresholdScalar -- Portable version of markAboveThreshold().
+//
+
+static void markAboveThresholdScalar(ucharint* output, const ucharint* input,
+		ulongint count, ucharint threshold) {
+	for (ulongint i=0; i<count; i++) {
+		output[i] = input[i] >= threshold ? 1 : 0;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// packBelowThresholdScalar -- Portable version of packBelowThreshold().
+//    count does not have to be a multiple of 64.
+//
+
+static void packBelowThresholdScalar(ulonglongint* output, const ucharint* input,
+		ulongint count, ucharint threshold) {
+	for (ulongint i=0; i<count; i+=64) {
+		ulonglongint word = 0;
+		ulongint n = count - i < 64 ? count - i : 64;
+		for (ulongint j=0; j<n; j++) {
+			if (input[i+j] < threshold) {
+				word |= 1ULL << j;
+			}
+		}
+		output[i/64] = word;
+	}
+}
+
+
+#ifdef RIP_X86_SIMD
+
+//////////////////////////////
+//
+// makeChannelMasks -- Create the byte-shuffle masks which gather one
+//    channel of 16 RGB pixels (48 bytes) that are spread across three
+//    16-byte registers.  Output bytes which do not come from a given
+//    register are set to 0x80 so that pshufb will zero them.
+//
+
+static void makeChannelMasks(char masks[3][16], int channel) {
+	for (int m=0; m<3; m++) {
+		for (int j=0; j<16; j++) {
+			int source = 3 * j + channel - 16 * m;
+			if ((source >= 0) && (source < 16)) {
+				masks[m][j] = (char)source;
+			} else {
+				masks[m][j] = (char)0x80;
+			}
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// extractRgbChannelSsse3 -- 16 pixels per iteration.
+//
+
+__attribute__((target("ssse3")))
+static void extractRgbChannelSsse3(ucharint* output, const ucharint* rgb,
+		ulongint count, int channel) {
+	char masks[3][16];
+	makeChannelMasks(masks, channel);
+	__m128i m0 = _mm_loadu_si128((const __m128i*)masks[0]);
+	__m128i m1 = _mm_loadu_si128((const __m128i*)masks[1]);
+	__m128i m2 = _mm_loadu_si128((const __m128i*)masks[2]);
+
+	ulongint i = 0;
+	for ( ; i + 16 <= count; i += 16) {
+		const ucharint* p = rgb + i * 3;
+		__m128i a = _mm_loadu_si128((const __m128i*)(p));
+		__m128i b = _mm_loadu_si128((const __m128i*)(p + 16));
+		__m128i c = _mm_loadu_si128((const __m128i*)(p + 32));
+		__m128i v = _mm_or_si128(_mm_shuffle_epi8(a, m0), _mm_shuffle_epi8(b, m1));
+		v = _mm_or_si128(v, _mm_shuffle_epi8(c, m2));
+		_mm_storeu_si128((__m128i*)(output + i), v);
+	}
+	extractRgbChannelScalar(output + i, rgb + i * 3, count - i, channel);
+}
+
+
+
+//////////////////////////////
+//
+// extractRgbChannelAvx2 -- 32 pixels per iteration.  vpshufb cannot move
+//    bytes between 128-bit lanes, so the two lanes of each register are
+//    loaded with the matching 16-byte pieces of two 16-pixel groups, and
+//    the SSSE3 masks are then applied to each lane.
+//
+
+__attribute__((target("avx2")))
+static void extractRgbChannelAvx2(ucharint* output, const ucharint* rgb,
+		ulongint count, int channel) {
+	char masks[3][16];
+	makeChannelMasks(masks, channel);
+	__m256i m0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)masks[0]));
+	__m256i m1 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)masks[1]));
+	__m256i m2 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)masks[2]));
+
+	ulongint i = 0;
+	for ( ; i + 32 <= count; i += 32) {
+		const ucharint* p = rgb + i * 3;
+		__m256i a = _mm256_inserti128_si256(_mm256_castsi128_si256(
+				_mm_loadu_si128((const __m128i*)(p))),
+				_mm_loadu_si128((const __m128i*)(p + 48)), 1);
+		__m256i b = _mm256_inserti128_si256(_mm256_castsi128_si256(
+				_mm_loadu_si128((const __m128i*)(p + 16))),
+				_mm_loadu_si128((const __m128i*)(p + 64)), 1);
+		__m256i c = _mm256_inserti128_si256(_mm256_castsi128_si256(
+				_mm_loadu_si128((const __m128i*)(p + 32))),
+				_mm_loadu_si128((const __m128i*)(p + 80)), 1);
+		__m256i v = _mm256_or_si256(_mm256_shuffle_epi8(a, m0), _mm256_shuffle_epi8(b, m1));
+		v = _mm256_or_si256(v, _mm256_shuffle_epi8(c, m2));
+		_mm256_storeu_si256((__m256i*)(output + i), v);
+	}
+	extractRgbChannelScalar(output + i, rgb + i * 3, count - i, channel);
+}
+
+
+
+//////////////////////////////
+//
+// loadLanes512 -- Load four 16-byte pieces which are 48 bytes apart
+//    into the four lanes of a 512-bit register.
+//
+
+__attribute__((target("avx512f,avx512bw")))
+static inline __m512i loadLanes512(const ucharint* p) {
+	__m512i v = _mm512_castsi128_si512(_mm_loadu_si128((const __m128i*)(p)));
+	v = _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i*)(p + 48)),  1);
+	v = _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i*)(p + 96)),  2);
+	v = _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i*)(p + 144)), 3);
+	return v;
+}
+
+
+
+//////////////////////////////
+//
+// extractRgbChannelAvx512 -- 64 pixels per iteration, using the same
+//    lane layout as the AVX2 version.
+//
+
+__attribute__((target("avx512f,avx512bw")))
+static void extractRgbChannelAvx512(ucharint* output, const ucharint* rgb,
+		ulongint count, int channel) {
+	char masks[3][16];
+	makeChannelMasks(masks, channel);
+	char lanemasks[3][64];
+	for (int m=0; m<3; m++) {
+		for (int j=0; j<64; j++) {
+			lanemasks[m][j] = masks[m][j % 16];
+		}
+	}
+	__m512i m0 = _mm512_loadu_si512((const void*)lanemasks[0]);
+	__m512i m1 = _mm512_loadu_si512((const void*)lanemasks[1]);
+	__m512i m2 = _mm512_loadu_si512((const void*)lanemasks[2]);
+
+	ulongint i = 0;
+	for ( ; i + 64 <= count; i += 64) {
+		const ucharint* p = rgb + i * 3;
+		__m512i a = loadLanes512(p);
+		__m512i b = loadLanes512(p + 16);
+		__m512i c = loadLanes512(p + 32);
+		__m512i v = _mm512_or_si512(_mm512_shuffle_epi8(a, m0), _mm512_shuffle_epi8(b, m1));
+		v = _mm512_or_si512(v, _mm512_shuffle_epi8(c, m2));
+		_mm512_storeu_si512((void*)(output + i), v);
+	}
+	extractRgbChannelScalar(output + i, rgb + i * 3, count - i, channel);
+}
+
+
+
+//////////////////////////////
+//
+// markAboveThresholdSsse3 -- x >= t is tested as max(x, t) == x, since
+//    there is no unsigned byte comparison before AVX-512.
+//
+
+__attribute__((target("ssse3")))
+static void markAboveThresholdSsse3(ucharint* output, const ucharint* input,
+		ulongint count, ucharint threshold) {
+	__m128i limit = _mm_set1_epi8((char)threshold);
+	__m128i one   = _mm_set1_epi8(1);
+	ulongint i = 0;
+	for ( ; i + 16 <= count; i += 16) {
+		__m128i x = _mm_loadu_si128((const __m128i*)(input + i));
+		__m128i v = _mm_cmpeq_epi8(_mm_max_epu8(x, limit), x);
+		_mm_storeu_si128((__m128i*)(output + i), _mm_and_si128(v, one));
+	}
+	markAboveThresholdScalar(output + i, input + i, count - i, threshold);
+}
+
+
+
+//////////////////////////////
+//
+// markAboveThresholdAvx2 --
+//
+
+__attribute__((target("avx2")))
+static void markAboveThresholdAvx2(ucharint* output, const ucharint* input,
+		ulongint count, ucharint threshold) {
+	__m256i limit = _mm256_set1_epi8((char)threshold);
+	__m256i one   = _mm256_set1_epi8(1);
+	ulongint i = 0;
+	for ( ; i + 32 <= count; i += 32) {
+		__m256i x = _mm256_loadu_si256((const __m256i*)(input + i));
+		__m256i v = _mm256_cmpeq_epi8(_mm256_max_epu8(x, limit), x);
+		_mm256_storeu_si256((__m256i*)(output + i), _mm256_and_si256(v, one));
+	}
+	markAboveThresholdScalar(output + i, input + i, count - i, threshold);
+}
+
+
+
+//////////////////////////////
+//
+// markAboveThresholdAvx512 --
+//
+
+__attribute__((target("avx512f,avx512bw")))
+static void markAboveThresholdAvx512(ucharint* output, const ucharint* input,
+		ulongint count, ucharint threshold) {
+	__m512i limit = _mm512_set1_epi8((char)threshold);
+	__m512i one   = _mm512_set1_epi8(1);
+	ulongint i = 0;
+	for ( ; i + 64 <= count; i += 64) {
+		__m512i x = _mm512_loadu_si512((const void*)(input + i));
+		__mmask64 mask = _mm512_cmpge_epu8_mask(x, limit);
+		_mm512_storeu_si512((void*)(output + i), _mm512_maskz_mov_epi8(mask, one));
+	}
+	markAboveThresholdScalar(output + i, input + i, count - i, threshold);
+}
+
+
+
+//////////////////////////////
+//
+// packBelowThresholdSsse3 -- The byte comparison of
+//    markAboveThresholdSsse3(), with the results gathered into bits by
+//    pmovmskb (16 bits at a time) and inverted.
+//
+
+__attribute__((target("ssse3")))
+static void packBelowThresholdSsse3(ulonglongint* output, const ucharint* input,
+		ulongint count, ucharint threshold) {
+	__m128i limit = _mm_set1_epi8((char)threshold);
+	ulongint i = 0;
+	for ( ; i + 64 <= count; i += 64) {
+		ulonglongint word = 0;
+		for (int j=0; j<4; j++) {
+			__m128i x = _mm_loadu_si128((const __m128i*)(input + i + j*16));
+			__m128i v = _mm_cmpeq_epi8(_mm_max_epu8(x, limit), x);
+			word |= (ulonglongint)(ushortint)_mm_movemask_epi8(v) << (j*16);
+		}
+		output[i/64] = ~word;
+	}
+	packBelowThresholdScalar(output + i/64, input + i, count - i, threshold);
+}
+
+
+
+//////////////////////////////
+//
+// packBelowThresholdAvx2 --
+//
+
+__attribute__((target("avx2")))
+static void packBelowThresholdAvx2(ulonglongint* output, const ucharint* input,
+		ulongint count, ucharint threshold) {
+	__m256i limit = _mm256_set1_epi8((char)threshold);
+	ulongint i = 0;
+	for ( ; i + 64 <= count; i += 64) {
+		__m256i x0 = _mm256_loadu_si256((const __m256i*)(input + i));
+		__m256i x1 = _mm256_loadu_si256((const __m256i*)(input + i + 32));
+		__m256i v0 = _mm256_cmpeq_epi8(_mm256_max_epu8(x0, limit), x0);
+		__m256i v1 = _mm256_cmpeq_epi8(_mm256_max_epu8(x1, limit), x1);
+		ulonglongint word = (ulonglongint)(unsigned int)_mm256_movemask_epi8(v0);
+		word |= (ulonglongint)(unsigned int)_mm256_movemask_epi8(v1) << 32;
+		output[i/64] = ~word;
+	}
+	packBelowThresholdScalar(output + i/64, input + i, count - i, threshold);
+}
+
+
+
+//////////////////////////////
+//
+// packBelowThresholdAvx512 -- One comparison gives all 64 bits of a word.
+//
+
+__attribute__((target("avx512f,avx512bw")))
+static void packBelowThresholdAvx512(ulonglongint* output, const ucharint* input,
+		ulongint count, ucharint threshold) {
+	__m512i limit = _mm512_set1_epi8((char)threshold);
+	ulongint i = 0;
+	for ( ; i + 64 <= count; i += 64) {
+		__m512i x = _mm512_loadu_si512((const void*)(input + i));
+		output[i/64] = _mm512_cmplt_epu8_mask(x, limit);
+	}
+	packBelowThresholdScalar(output + i/64, input + i, count - i, threshold);
+}
+
+#endif /* RIP_X86_SIMD */
+
+
+
+//////////////////////////////
+//
+// detectSimdLevel -- Return the best SimdLevel supported by the CPU
+//    (and operating system) that the program is running on.
+//
+
+static int detectSimdLevel(void) {
+#ifdef RIP_X86_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512bw")) {
+		return SIMD_AVX512;
+	} else if (__builtin_cpu_supports("avx2")) {
+		return SIMD_AVX2;
+	} else if (__builtin_cpu_supports("ssse3")) {
+		return SIMD_SSSE3;
+	}
+#endif
+	return SIMD_SCALAR;
+}
+
+
+
+//////////////////////////////
+//
+// getMaxSimdLevel -- The CPU is only queried once.
+//
+
+int getMaxSimdLevel(void) {
+	static int maxlevel = detectSimdLevel();
+	return maxlevel;
+}
+
+
+
+//////////////////////////////
+//
+// activeSimdLevel -- Storage for the SimdLevel used by the pixel
+//    kernels, which defaults to the best level available.
+//
+
+static int& activeSimdLevel(void) {
+	static int level = getMaxSimdLevel();
+	return level;
+}
+
+
+
+//////////////////////////////
+//
+// getSimdLevel -- Return the SimdLevel currently used by the pixel kernels.
+//
+
+int getSimdLevel(void) {
+	return activeSimdLevel();
+}
+
+
+
+//////////////////////////////
+//
+// setSimdLevel -- Limit the pixel kernels to the given SimdLevel (mostly
+//    for benchmarking and testing).  The level is reduced to what the CPU
+//    supports, and the level actually used is returned.
+//
+
+int setSimdLevel(int level) {
+	if (level < SIMD_SCALAR) {
+		level = SIMD_SCALAR;
+	}
+	if (level > getMaxSimdLevel()) {
+		level = getMaxSimdLevel();
+	}
+	activeSimdLevel() = level;
+	return level;
+}
+
+
+
+//////////////////////////////
+//
+// getSimdLevelName --
+//
+
+const char* getSimdLevelName(int level) {
+	switch (level) {
+		case SIMD_SCALAR: return "scalar";
+		case SIMD_SSSE3:  return "ssse3";
+		case SIMD_AVX2:   return "avx2";
+		case SIMD_AVX512: return "avx512bw";
+	}
+	return "unknown";
+}
+
+
+
+//////////////////////////////
+//
+// extractRgbChannel -- Copy one channel (0=red, 1=green, 2=blue) of count
+//    interleaved 24-bit RGB pixels into output, which must have space for
+//    count bytes.
+//
+
+void extractRgbChannel(ucharint* output, const ucharint* rgb, ulongint count,
+		int channel) {
+	if ((channel < 0) || (channel > 2)) {
+		std::cerr << "Error: invalid RGB channel " << channel << std::endl;
+		return;
+	}
+	switch (activeSimdLevel()) {
+#ifdef RIP_X86_SIMD
+		case SIMD_AVX512:
+			extractRgbChannelAvx512(output, rgb, count, channel);
+			return;
+		case SIMD_AVX2:
+			extractRgbChannelAvx2(output, rgb, count, channel);
+			return;
+		case SIMD_SSSE3:
+			extractRgbChannelSsse3(output, rgb, count, channel);
+			return;
+#endif
+	}
+	extractRgbChannelScalar(output, rgb, count, channel);
+}
+
+
+
+//////////////////////////////
+//
+// extractGreenChannel -- Copy the green samples of count 24-bit RGB
+//    pixels into output.
+//
+
+void extractGreenChannel(ucharint* output, const ucharint* rgb, ulongint count) {
+	extractRgbChannel(output, rgb, count, 1);
+}
+
+
+
+//////////////////////////////
+//
+// markAboveThreshold -- Set output to 1 for each input value which is
+//    above (or equal) to the threshold, and to 0 otherwise (the same
+//    test as aboveThreshold()).
+//
+
+void markAboveThreshold(ucharint* output, const ucharint* input, ulongint count,
+		ucharint threshold) {
+	switch (activeSimdLevel()) {
+#ifdef RIP_X86_SIMD
+		case SIMD_AVX512:
+			markAboveThresholdAvx512(output, input, count, threshold);
+			return;
+		case SIMD_AVX2:
+			markAboveThresholdAvx2(output, input, count, threshold);
+			return;
+		case SIMD_SSSE3:
+			markAboveThresholdSsse3(output, input, count, threshold);
+			return;
+#endif
+	}
+	markAboveThresholdScalar(output, input, count, threshold);
+}
+
+
+
+//////////////////////////////
+//
+// packBelowThreshold -- Set bit (i % 64) of output[i / 64] for each input
+//    value which is below the threshold (the opposite of
+//    markAboveThreshold()).  Output needs (count + 63) / 64 words, and
+//    unused bits of the last word are cleared.
+//
+
+void packBelowThreshold(ulonglongint* output, const ucharint* input, ulongint count,
+		ucharint threshold) {
+	switch (activeSimdLevel()) {
+#ifdef RIP_X86_SIMD
+		case SIMD_AVX512:
+			packBelowThresholdAvx512(output, input, count, threshold);
+			return;
+		case SIMD_AVX2:
+			packBelowThresholdAvx2(output, input, count, threshold);
+			return;
+		case SIMD_SSSE3:
+			packBelowThresholdSsse3(output, input, count, threshold);
+			return;
+#endif
+	}
+	packBelowThresholdScalar(output, input, count, threshold);
+}
+
+
+
 } // end namespace rip
 
 
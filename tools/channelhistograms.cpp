@@ -35,15 +35,15 @@ int main(int argc, char** argv) {
 		histograms[i].resize(256);
 		std::fill(histograms[i].begin(), histograms[i].end(), 0);
 	}
-	tfile.goToPixelIndex(0);
-	ulongint count = tfile.getPixelCount();
-	for (ulongint i=0; i<count; i++) {
-		ucharint red   = tfile.read1UByte();
-		ucharint green = tfile.read1UByte();
-		ucharint blue  = tfile.read1UByte();
-		histograms[0].at(red)++;
-		histograms[1].at(green)++;
-		histograms[2].at(blue)++;
+	ulongint rows = tfile.getRows();
+	ulongint cols = tfile.getCols();
+	for (ulongint r=0; r<rows; r++) {
+		const ucharint* pixels = tfile.getRowPixels(r);
+		for (ulongint c=0; c<cols; c++) {
+			histograms[0][pixels[c*3+0]]++;  // red
+			histograms[1][pixels[c*3+1]]++;  // green
+			histograms[2][pixels[c*3+2]]++;  // blue
+		}
 	}
 
 	cout << "**value\t**red\t**green\t**blue\n";
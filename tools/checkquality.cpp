@@ -33,7 +33,7 @@ int main(int argc, char** argv) {
 		exit(1);
 	}
 
-	roll.loadGreenChannel(255);
+	roll.loadGreenChannel(255, false);
 	roll.analyze();
 	roll.printQualityReport();
 
@@ -31,22 +31,18 @@ int main(int argc, char** argv) {
 		exit(1);
 	}
 
-	int threshold = 249;
-
-	roll.setDebugOn();
-	roll.setWarningOn();
-	roll.loadGreenChannel(threshold);
-
-	int rows = roll.getRows();
-	int cols = roll.getCols();
+	ulongint rows = roll.getRows();
+	ulongint cols = roll.getCols();
 
 	cout << "P2" << endl;
 	cout << cols << " " << rows << endl;
 	cout << 255 << endl;
 
-	for (int r=0; r<(int)rows; r++) {
-		for (int c=0; c<(int)cols; c++) {
-			cout << (int)roll.monochrome.at(r).at(c);
+	vector<ucharint> green(cols);
+	for (ulongint r=0; r<rows; r++) {
+		extractGreenChannel(green.data(), roll.getRowPixels(r), cols);
+		for (ulongint c=0; c<cols; c++) {
+			cout << (int)green[c];
 			if (c < cols - 1) {
 				cout << ' ';
 			}
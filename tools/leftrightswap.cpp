@@ -19,7 +19,7 @@
 using namespace std;
 using namespace rip;
 
-void flipRow(fstream& output, TiffFile& image);
+void flipRow(fstream& output, TiffFile& image, ulongint row);
 
 ///////////////////////////////////////////////////////////////////////////
 
@@ -49,15 +49,14 @@ int main(int argc, char** argv) {
 
 	output.write(header.data(), header.size());
 
-	image.goToPixelIndex(0);  // should already be there, but being careful.
 	ulongint rows = image.getRows();
 	
 	// assuming 24-bit color for now.
 	for (ulongint r=0; r<rows; r++) {
-		flipRow(output, image);
+		flipRow(output, image, r);
 	}
 
-	ulonglongint position = image.tellg();
+	ulonglongint position = image.getPixelOffset(rows, 0);
 	image.seekg(0, std::ios::end);
 	ulonglongint endpos = image.tellg();
 	rip::goToByteIndex(image, position);
@@ -73,21 +72,15 @@ int main(int argc, char** argv) {
 
 //////////////////////////////
 //
-// flipRow -- flipping the current row, presuming read pointer is set to the
-//    correct position already.  Also presuming 24-bit color pixels.
+// flipRow -- flipping the given row.  Presuming 24-bit color pixels.
 //
 
-void flipRow(fstream& output, TiffFile& image) {
-	string indata;
+void flipRow(fstream& output, TiffFile& image, ulongint row) {
 	string outdata;
 	int cols = (int)image.getCols();
 	outdata.resize(cols*3);
-	indata = image.readString(cols*3);
+	const ucharint* indata = image.getRowPixels(row);
 
-	if ((int)indata.size() != cols * 3) {
-		cerr << "Strange problem happened when flipping row." << endl;
-		exit(1);
-	}
 	for (int c=0; c<cols; c++) {
 		outdata[(c*3)+0] = indata[(cols-c-1)*3+0];
 		outdata[(c*3)+1] = indata[(cols-c-1)*3+1];
@@ -39,29 +39,30 @@ int main(int argc, char** argv) {
 	}
 
 	vector<ucharint> pixel(3, 0);
-	tfile.goToPixelIndex(0);
-	ulongint count = tfile.getPixelCount();
+	ulongint rows = tfile.getRows();
+	ulongint cols = tfile.getCols();
 	ulongint offset;
-	for (ulongint i=0; i<count; i++) {
-		pixel[0] = tfile.read1UByte();  // red
-		pixel[1] = tfile.read1UByte();  // green
-		pixel[2] = tfile.read1UByte();  // blue
-		if (pixel[1] == 255) {
-			// holes set to green
-			pixel[0] = 0;
-			pixel[1] = 255;
-			pixel[2] = 0;
-			offset = tfile.getPixelOffset(i);
-			output.seekp(offset);
-			output.write((char*)pixel.data(), 3);
-		} else if (pixel[1] > 200) {
-			// border regions set to red.
-			pixel[0] = 255;
-			pixel[1] = 0;
-			pixel[2] = 0;
-			offset = tfile.getPixelOffset(i);
-			output.seekp(offset);
-			output.write((char*)pixel.data(), 3);
+	for (ulongint r=0; r<rows; r++) {
+		const ucharint* pixels = tfile.getRowPixels(r);
+		for (ulongint c=0; c<cols; c++) {
+			ucharint green = pixels[c*3+1];
+			if (green == 255) {
+				// holes set to green
+				pixel[0] = 0;
+				pixel[1] = 255;
+				pixel[2] = 0;
+				offset = tfile.getPixelOffset(r, c);
+				output.seekp(offset);
+				output.write((char*)pixel.data(), 3);
+			} else if (green > 200) {
+				// border regions set to red.
+				pixel[0] = 255;
+				pixel[1] = 0;
+				pixel[2] = 0;
+				offset = tfile.getPixelOffset(r, c);
+				output.seekp(offset);
+				output.write((char*)pixel.data(), 3);
+			}
 		}
 	}
 
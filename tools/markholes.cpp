@@ -23,9 +23,21 @@
 //     --65       Assume a 65-note Duo-art universal piano roll
 //     --88       Assume a 88-note roll
 //     -t         Set the paper/hole brightness boundary (from 0-255, with 249 being the default).
+//     --rle      Store pixel classes run-length encoded until hole extraction (less memory).
+//     --flood-margins  Find margins with a flood fill from the image sides.
+//     --threads  Number of threads for the analysis (0 = $RIP_THREADS or one per core, 1 = no extra threads).
+//     --smoothing  Margin smoothing mode: exact (default), blocks, float or fixed.
+//     --band-memory  Keep the pixel planes in temporary files and use about this many MB for them.
+//     --scratch-dir  Directory for the temporary files of --band-memory (default $TMPDIR or /tmp).
+//     --profile  Add a PROFILE section with stage timings to the analysis.
+//     --profile-json  Also write the stage timings to a JSON file.
+//     --trace    Write a Chrome/Perfetto trace of the run to a JSON file.
+//     --counters  Add hardware performance counters to the PROFILE section (Linux).
 //
 
 #include "RollImage.h"
+#include "Smoothing.h"
+#include "ThreadPool.h"
 #include "Options.h"
 
 #include <vector>
@@ -46,6 +58,16 @@ int main(int argc, char** argv) {
 	options.define("5|65|65-note|65-hole=b", "Assume 65-note roll");
 	options.define("8|88|88-note|88-hole=b", "Assume 88-note roll");
 	options.define("t|threshold=i:249", "Brightness threshold for hole/paper separation");
+	options.define("rle|run-length=b", "Store pixel classes as runs during margin analysis");
+	options.define("flood-margins=b", "Find margins with a flood fill from the sides of the image");
+	options.define("threads=i:0", "Number of threads for the analysis (0 = $RIP_THREADS or one per core)");
+	options.define("smoothing=s:exact", "Margin smoothing mode: exact, blocks, float or fixed");
+	options.define("band-memory=i:0", "Memory budget in MB for the pixel planes (0 = whole image in memory)");
+	options.define("scratch-dir=s", "Directory for the temporary pixel-plane files of --band-memory");
+	options.define("profile=b", "Add a PROFILE section with stage timings to the analysis");
+	options.define("profile-json=s", "Write stage timings to a JSON file");
+	options.define("trace=s", "Write a Chrome trace-event file (chrome://tracing, ui.perfetto.dev)");
+	options.define("counters=b", "Record hardware performance counters for each stage (Linux)");
 	options.process(argc, argv);
 
 	if (options.getArgCount() != 2) {
@@ -89,7 +111,24 @@ int main(int argc, char** argv) {
 
 	roll.setDebugOn();
 	roll.setWarningOn();
-	roll.loadGreenChannel(threshold);
+	roll.setRunLengthPixels(options.getBoolean("run-length"));
+	roll.setMarginFloodFill(options.getBoolean("flood-margins"));
+	if (options.getInteger("band-memory") > 0) {
+		roll.setBandMemory((ulonglongint)options.getInteger("band-memory") * 1024 * 1024);
+	}
+	roll.setScratchDirectory(options.getString("scratch-dir"));
+	ThreadPool::getShared().setThreadCount(options.getInteger("threads"));
+	int smoothing = findSmoothingMode(options.getString("smoothing"));
+	if (smoothing < 0) {
+		cerr << "Unknown smoothing mode " << options.getString("smoothing") << endl;
+		exit(1);
+	}
+	roll.setSmoothingMode(smoothing);
+	roll.getProfiler().setEnabled(options.getBoolean("profile") ||
+			options.getBoolean("profile-json") || options.getBoolean("trace") ||
+			options.getBoolean("counters"));
+	roll.getProfiler().setHardwareCounters(options.getBoolean("counters"));
+	roll.loadGreenChannel(threshold, false);
 
 	roll.analyze();
 	cerr << "DONE ANALYZING" << endl;
@@ -113,6 +152,13 @@ int main(int argc, char** argv) {
 	output.close();
 	cerr << "DONE CLOSE" << endl;
 
+	if (options.getBoolean("profile-json")) {
+		roll.getProfiler().writeJson(options.getString("profile-json"));
+	}
+	if (options.getBoolean("trace")) {
+		roll.getProfiler().writeChromeTrace(options.getString("trace"));
+	}
+
 	return 0;
 }
 
@@ -65,7 +65,6 @@ int main(int argc, char** argv) {
 	image.goToByteIndex(0);
 	string header = image.readString(dataoffset);
 	output.write(header.data(), header.size());
-	image.goToPixelIndex(0);  // should already be there, but being careful.
 	ulongint rows = image.getRows();
 
 	vector<pair<int, double>> driftAnalysis;
@@ -83,7 +82,7 @@ int main(int argc, char** argv) {
 		shiftImageRow(output, image, r, drift[r]);
 	}
 
-	ulonglongint position = image.tellg();
+	ulonglongint position = image.getPixelOffset(rows, 0);
 	image.seekg(0, std::ios::end);
 	ulonglongint endpos = image.tellg();
 	rip::goToByteIndex(image, position);
@@ -110,15 +109,9 @@ void shiftImageRow(fstream& output, TiffFile& image, int row, int adjust) {
 		iadjust = -int(-adjust + 0.5);
 	}
 
-	string indata;
 	string outdata;
 	int cols = (int)image.getCols();
-	indata = image.readString(cols*3);
-
-	if ((int)indata.size() != cols * 3) {
-		cerr << "Strange problem happened when processing row." << endl;
-		exit(1);
-	}
+	const ucharint* indata = image.getRowPixels(row);
 
 	outdata.resize(cols*3);
 	for (int c=0; c<cols*3; c++) {
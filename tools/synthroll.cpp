@@ -0,0 +1,122 @@
+//
+// Creation Date: Fri Oct 16 23:40:17 PDT 2026
+// Last Modified: Fri Oct 16 23:40:17 PDT 2026
+// Filename:      synthroll.cpp
+// Web Address:
+// Syntax:        C++
+// vim:           ts=3:nowrap:ft=text
+//
+// Description:   Write a synthetic piano-roll image (uncompressed RGB TIFF)
+//                and the list of holes, tears and shifts punched into it,
+//                for benchmarks which need reproducible input and a way
+//                to check the analysis results.
+// Options:
+//     -r         Use the tracker-bar layout of a Red Welte-Mignon roll (T-100).
+//     -g         Use the tracker-bar layout of a Green Welte-Mignon roll (T-98).
+//     --65       Use the tracker-bar layout of a 65-note roll.
+//     --88       Use the tracker-bar layout of an 88-note roll.
+//     --dpi      Image resolution (default 300).
+//     --length   Roll length in feet (default 6).
+//     --rows     Roll length in pixel rows (overrides --length).
+//     --density  Fraction of the music rows punched in each track (default 0.25).
+//     --hole-width  Hole width as a fraction of the tracker spacing (0 = roll default).
+//     --bridge   Fraction of notes punched as chains of bridged holes (default 0.2).
+//     --drift    Amplitude of the sideways paper drift in inches (default 0.02).
+//     --shifts   Number of operator shifts (default 2).
+//     --tears    Number of edge tears (default 2).
+//     --dust     Dust specks per foot (default 10).
+//     --leader   Length of the leader in inches (default 7).  Without a leader the
+//                analysis needs --drift 0 --shifts 0 to accept the roll.
+//     --preleader  Length of the preleader strap in inches (default 1).
+//     --seed     Random seed (default 1).
+//     --bigtiff  Write a BigTIFF file even for small images.
+//     --truth    Write the ground truth in ATON format to a file ("-" for stdout).
+//
+
+#include "RollSynthesizer.h"
+#include "Options.h"
+
+using namespace std;
+using namespace rip;
+using namespace smf;
+
+///////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("r|red|red-welte|welte-red=b", "Use Red-Welte (T-100) tracker-bar layout");
+	options.define("g|green|green-welte|welte-green=b", "Use Green-Welte (T-98) tracker-bar layout");
+	options.define("5|65|65-note|65-hole=b", "Use 65-note tracker-bar layout");
+	options.define("8|88|88-note|88-hole=b", "Use 88-note tracker-bar layout");
+	options.define("dpi=d:300", "Image resolution in pixels per inch");
+	options.define("length=d:6", "Roll length in feet");
+	options.define("rows=i:0", "Roll length in pixel rows (overrides --length)");
+	options.define("density=d:0.25", "Fraction of the music rows punched in each track");
+	options.define("hole-width=d:0", "Hole width as a fraction of the tracker spacing (0 = default)");
+	options.define("bridge=d:0.2", "Fraction of notes punched as chains of bridged holes");
+	options.define("drift=d:0.02", "Amplitude of the sideways paper drift in inches");
+	options.define("shifts=i:2", "Number of operator shifts");
+	options.define("tears=i:2", "Number of edge tears");
+	options.define("dust=d:10", "Dust specks per foot");
+	options.define("leader=d:7", "Length of the leader in inches");
+	options.define("preleader=d:1", "Length of the preleader in inches");
+	options.define("seed=i:1", "Random seed for the roll contents");
+	options.define("bigtiff=b", "Write a BigTIFF file");
+	options.define("truth=s", "Write the ground truth to a file (- for standard output)");
+	options.process(argc, argv);
+
+	if (options.getArgCount() != 1) {
+		cerr << "Usage: synthroll [-rg|--65|--88] [--truth holes.txt] output.tiff" << endl;
+		exit(1);
+	}
+
+	RollSynthesizer roll;
+	if (options.getBoolean("red-welte")) {
+		roll.setRollType("welte-red");
+	} else if (options.getBoolean("green-welte")) {
+		roll.setRollType("welte-green");
+	} else if (options.getBoolean("65-note")) {
+		roll.setRollType("65-note");
+	} else if (options.getBoolean("88-note")) {
+		roll.setRollType("88-note");
+	} else {
+		cerr << "A Roll type is required:" << endl;
+		cerr << "   -r   == for red Welte rolls"   << endl;
+		cerr << "   -g   == for green Welte rolls" << endl;
+		cerr << "   --65 == for 65-note rolls"     << endl;
+		cerr << "   --88 == for 88-note rolls"     << endl;
+		exit(1);
+	}
+
+	roll.setDpi(options.getDouble("dpi"));
+	roll.setLength(options.getDouble("length"));
+	roll.setRows(options.getInteger("rows") > 0 ? options.getInteger("rows") : 0);
+	roll.setHoleDensity(options.getDouble("density"));
+	roll.setHoleWidth(options.getDouble("hole-width"));
+	roll.setBridgeRate(options.getDouble("bridge"));
+	roll.setDrift(options.getDouble("drift"));
+	roll.setShiftCount(options.getInteger("shifts"));
+	roll.setTearCount(options.getInteger("tears"));
+	roll.setDustRate(options.getDouble("dust"));
+	roll.setLeader(options.getDouble("leader"));
+	roll.setPreleader(options.getDouble("preleader"));
+	roll.setSeed(options.getInteger("seed"));
+	roll.setBigTiff(options.getBoolean("bigtiff"));
+
+	if (!roll.generate()) {
+		exit(1);
+	}
+	if (!roll.writeTiff(options.getArg(1))) {
+		exit(1);
+	}
+	if (options.getBoolean("truth")) {
+		if (!roll.writeTruth(options.getString("truth"))) {
+			exit(1);
+		}
+	}
+
+	return 0;
+}
+
+
+